@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <string>
+
+#include "antialiasing.hpp"
+#include "shadermanager.hpp"
+
+namespace {
+
+const char* const FXAA_VERTEX = R"(
+    #version 330 core
+    out vec2 uv;
+    void main() {
+        // one triangle covering the screen: (-1,-1) (3,-1) (-1,3)
+        vec2 p = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2));
+        uv = p;
+        gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);
+    }
+)";
+
+const char* const FXAA_FRAGMENT = R"(
+    #version 330 core
+    #define EDGE_THRESHOLD      (1.0 / 8.0)   // local contrast, relative to the brightest tap
+    #define EDGE_THRESHOLD_MIN  (1.0 / 24.0)  // absolute, keeps dark noise untouched
+    #define REDUCE_MUL          (1.0 / 8.0)
+    #define REDUCE_MIN          (1.0 / 128.0)
+    #define SPAN_MAX            8.0           // texels along the edge
+
+    in vec2 uv;
+    out vec4 FragColor;
+
+    uniform sampler2D sceneColor;
+    uniform vec2 texelSize;   // 1 / target size
+    uniform vec2 uvScale;     // rendered part of the target
+
+    // taps stay inside the rendered part (the rest of the target is stale)
+    vec3 fetch(vec2 p) {
+        return texture(sceneColor, clamp(p, 0.5 * texelSize, uvScale - 0.5 * texelSize)).rgb;
+    }
+
+    void main() {
+        const vec3 toLuma = vec3(0.299, 0.587, 0.114);
+        vec2 p = uv * uvScale;
+        vec3 rgbM = fetch(p);
+        float lumaNW = dot(fetch(p + vec2(-1.0, -1.0) * texelSize), toLuma);
+        float lumaNE = dot(fetch(p + vec2( 1.0, -1.0) * texelSize), toLuma);
+        float lumaSW = dot(fetch(p + vec2(-1.0,  1.0) * texelSize), toLuma);
+        float lumaSE = dot(fetch(p + vec2( 1.0,  1.0) * texelSize), toLuma);
+        float lumaM = dot(rgbM, toLuma);
+        float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+        float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+
+        // most pixels are not on an edge: one fetch more than a copy
+        if (lumaMax - lumaMin < max(EDGE_THRESHOLD_MIN, lumaMax * EDGE_THRESHOLD)) {
+            FragColor = vec4(rgbM, 1.0);
+            return;
+        }
+
+        // edge direction from the luma gradient, stretched to the shorter axis
+        vec2 dir = vec2(-((lumaNW + lumaNE) - (lumaSW + lumaSE)), (lumaNW + lumaSW) - (lumaNE + lumaSE));
+        float dirReduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * (0.25 * REDUCE_MUL), REDUCE_MIN);
+        float rcpDirMin = 1.0 / (min(abs(dir.x), abs(dir.y)) + dirReduce);
+        dir = clamp(dir * rcpDirMin, vec2(-SPAN_MAX), vec2(SPAN_MAX)) * texelSize;
+
+        vec3 rgbA = 0.5 * (fetch(p + dir * (1.0 / 3.0 - 0.5)) + fetch(p + dir * (2.0 / 3.0 - 0.5)));
+        vec3 rgbB = rgbA * 0.5 + 0.25 * (fetch(p - dir * 0.5) + fetch(p + dir * 0.5));
+        float lumaB = dot(rgbB, toLuma);
+        // the wide blend crossed another edge: keep the narrow one
+        FragColor = vec4((lumaB < lumaMin || lumaB > lumaMax) ? rgbA : rgbB, 1.0);
+    }
+)";
+
+} // namespace
+
+const char* AntiAliasing::name(AntiAliasingMode mode) {
+    switch (mode) {
+    case AA_FXAA: return "FXAA";
+    case AA_MSAA2: return "MSAA 2x";
+    case AA_MSAA4: return "MSAA 4x";
+    default: return "off";
+    }
+}
+
+bool AntiAliasing::init(AntiAliasingMode mode, int width, int height) {
+    destroy();
+    aaMode = mode;
+    if (mode == AA_OFF) return false;
+    sampleCount = 0;
+    if (mode == AA_MSAA2 || mode == AA_MSAA4) {
+        GLint maxSamples = 0;
+        glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+        sampleCount = std::max(1, std::min(mode == AA_MSAA2 ? 2 : 4, (int)maxSamples));
+    } else {
+        fxaaProgram.adopt(compileProgramNow("shader/fxaa", FXAA_VERTEX, FXAA_FRAGMENT), "shader/fxaa");
+        if (!fxaaProgram) return false; // resolving with program 0 would draw nothing
+        emptyVAO.create("geometry/full-screen triangle");
+    }
+    targetWidth = std::max(1, width);
+    targetHeight = std::max(1, height);
+    framebuffer.create("framebuffer/anti-aliasing");
+    allocate();
+    return active();
+}
+
+void AntiAliasing::destroy() {
+    framebuffer.reset();
+    colorBuffer.reset();
+    colorTexture.reset();
+    depthBuffer.reset();
+    fxaaProgram.reset();
+    emptyVAO.reset();
+}
+
+void AntiAliasing::allocate() {
+    const int w = targetWidth, h = targetHeight;
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.get());
+    depthBuffer.create("framebuffer/anti-aliasing depth");
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer.get());
+    if (sampleCount) {
+        colorBuffer.create("framebuffer/anti-aliasing color");
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, sampleCount, GL_DEPTH24_STENCIL8, w, h);
+        gpuResources().setSize(GPU_RENDERBUFFER, depthBuffer.get(), gpuImageBytes(GL_DEPTH24_STENCIL8, w, h) * sampleCount,
+                               "DEPTH24_STENCIL8 x" + std::to_string(sampleCount));
+        glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer.get());
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, sampleCount, GL_RGBA8, w, h);
+        gpuResources().setSize(GPU_RENDERBUFFER, colorBuffer.get(), gpuImageBytes(GL_RGBA8, w, h) * sampleCount,
+                               "RGBA8 x" + std::to_string(sampleCount));
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer.get());
+    } else {
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, w, h);
+        gpuResources().setSize(GPU_RENDERBUFFER, depthBuffer.get(), gpuImageBytes(GL_DEPTH24_STENCIL8, w, h),
+                               "DEPTH24_STENCIL8");
+        colorTexture.create("framebuffer/anti-aliasing color");
+        glBindTexture(GL_TEXTURE_2D, colorTexture.get());
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        // FXAA's taps between texels rely on bilinear filtering
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        gpuResources().setSize(GPU_TEXTURE, colorTexture.get(), gpuImageBytes(GL_RGBA8, w, h), "RGBA8");
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture.get(), 0);
+    }
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer.get());
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) framebuffer.reset();
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void AntiAliasing::resize(int width, int height) {
+    width = std::max(1, width);
+    height = std::max(1, height);
+    if (!active() || (width == targetWidth && height == targetHeight)) return;
+    targetWidth = width;
+    targetHeight = height;
+    allocate();
+}
+
+void AntiAliasing::beginScene(int width, int height) {
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.get());
+    glViewport(0, 0, std::min(width, targetWidth), std::min(height, targetHeight));
+}
+
+void AntiAliasing::resolve(GLuint output, int width, int height) {
+    width = std::min(width, targetWidth);
+    height = std::min(height, targetHeight);
+    if (sampleCount) {
+        // a multisample blit can't scale, so the rectangles match
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer.get());
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, output);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, output);
+        glViewport(0, 0, width, height);
+        return;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, output);
+    glViewport(0, 0, width, height);
+    glDisable(GL_DEPTH_TEST);
+    GLuint prog = fxaaProgram.get();
+    glUseProgram(prog);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, colorTexture.get());
+    glUniform1i(glGetUniformLocation(prog, "sceneColor"), 0);
+    glUniform2f(glGetUniformLocation(prog, "texelSize"), 1.0f / (float)targetWidth, 1.0f / (float)targetHeight);
+    glUniform2f(glGetUniformLocation(prog, "uvScale"), (float)width / (float)targetWidth, (float)height / (float)targetHeight);
+    glBindVertexArray(emptyVAO.get());
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glEnable(GL_DEPTH_TEST);
+}
@@ -0,0 +1,68 @@
+#ifndef ANTIALIASING_HPP
+#define ANTIALIASING_HPP
+
+#include <ostream>
+
+#include <glad/glad.h>
+
+#include "gpuresources.hpp"
+
+enum AntiAliasingMode {
+    AA_OFF,
+    AA_FXAA,     // post-process: luma edge detection, blend along the edge
+    AA_MSAA2,
+    AA_MSAA4
+};
+
+// Scene target for anti-aliasing, rendered into instead of the output framebuffer.
+//
+// MSAA: multisampled colour/depth renderbuffers, resolved with a blit (the window's own
+// GLFW_SAMPLES is not used, so headless runs and the bench measure the same thing).
+// FXAA: a single-sampled colour texture, then one full-screen pass (FXAA 3.11 "console"
+// flavour: skip pixels whose 3x3 luma contrast is low, otherwise blend two to four taps
+// along the edge direction) into the output. Costs one extra read and write of the
+// image instead of 2-4x the colour/depth bandwidth of every draw.
+//
+// The target is allocated at the output size; beginScene/resolve take the part actually
+// rendered, so it works under DynamicResolution's scaled viewport.
+class AntiAliasing {
+public:
+    AntiAliasing() {}
+    ~AntiAliasing() { destroy(); }
+
+    // Samples are clamped to GL_MAX_SAMPLES. False (and inactive) if the target is incomplete
+    // or the FXAA program doesn't link.
+    bool init(AntiAliasingMode mode, int width, int height);
+    void destroy();
+    bool active() const { return (bool)framebuffer; }
+    AntiAliasingMode mode() const { return aaMode; }
+    int samples() const { return sampleCount; }
+
+    void resize(int width, int height);
+
+    // Binds the target with a width x height viewport (at most the allocated size).
+    void beginScene(int width, int height);
+    // Anti-aliased width x height image into the bottom-left of `output`, which is left
+    // bound with that viewport. Depth test is on again afterwards.
+    void resolve(GLuint output, int width, int height);
+
+    static const char* name(AntiAliasingMode mode);
+
+private:
+    AntiAliasing(const AntiAliasing&);
+    AntiAliasing& operator=(const AntiAliasing&);
+
+    void allocate();
+
+    AntiAliasingMode aaMode = AA_OFF;
+    int sampleCount = 0;
+    int targetWidth = 0, targetHeight = 0;
+    GpuFramebuffer framebuffer;
+    GpuRenderbuffer colorBuffer;                // MSAA
+    GpuTexture colorTexture;                    // FXAA
+    GpuRenderbuffer depthBuffer;
+    GpuProgram fxaaProgram;
+    GpuVertexArray emptyVAO;                    // the full-screen triangle comes from gl_VertexID
+};
+
+#endif
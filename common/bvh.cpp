@@ -0,0 +1,519 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BVH_SIMD 1
+#else
+#define BVH_SIMD 0
+#endif
+
+#include "jobsystem.hpp"
+#include "scenestore.hpp"
+#include "bvh.hpp"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// ---- build: binned SAH, shared by both levels ----
+
+const int SAH_BINS = 12;
+const int MAX_DEPTH = 60;    // traversal stacks hold 64 entries
+
+float halfArea(const glm::vec3& mn, const glm::vec3& mx) {
+    glm::vec3 e = glm::max(mx - mn, glm::vec3(0.0f));
+    return e.x * e.y + e.y * e.z + e.z * e.x;
+}
+
+void setBounds(BvhNode& n, const glm::vec3& mn, const glm::vec3& mx) {
+    for (int a = 0; a < 3; ++a) {
+        n.boundsMin[a] = mn[a];
+        n.boundsMax[a] = mx[a];
+    }
+}
+
+// Builds `nodes` over primitives with the given boxes; `order` receives the primitive
+// ids in leaf order (leaves reference ranges of it). A leaf is made when splitting
+// doesn't pay off (SAH, traversal step costing as much as one primitive) and holds at
+// most `maxLeaf` primitives unless they can't be separated.
+void buildTree(const std::vector<glm::vec3>& primMin, const std::vector<glm::vec3>& primMax, uint32_t maxLeaf,
+               std::vector<BvhNode>& nodes, std::vector<uint32_t>& order) {
+    const uint32_t n = (uint32_t)primMin.size();
+    nodes.clear();
+    order.resize(n);
+    for (uint32_t i = 0; i < n; ++i) order[i] = i;
+    if (n == 0) return;
+
+    std::vector<glm::vec3> centroid(n);
+    for (uint32_t i = 0; i < n; ++i) centroid[i] = 0.5f * (primMin[i] + primMax[i]);
+
+    nodes.reserve(2 * (size_t)n);
+    nodes.push_back(BvhNode());
+    nodes[0].leftOrFirst = 0;
+    nodes[0].count = n;
+
+    struct Pending { uint32_t node; int depth; };
+    std::vector<Pending> stack(1, Pending{0, 0});
+    while (!stack.empty()) {
+        Pending p = stack.back();
+        stack.pop_back();
+        const uint32_t first = nodes[p.node].leftOrFirst, count = nodes[p.node].count;
+
+        glm::vec3 mn(FLT_MAX), mx(-FLT_MAX), cmn(FLT_MAX), cmx(-FLT_MAX);
+        for (uint32_t i = first; i < first + count; ++i) {
+            uint32_t prim = order[i];
+            mn = glm::min(mn, primMin[prim]);
+            mx = glm::max(mx, primMax[prim]);
+            cmn = glm::min(cmn, centroid[prim]);
+            cmx = glm::max(cmx, centroid[prim]);
+        }
+        setBounds(nodes[p.node], mn, mx);
+        if (count <= 1 || p.depth >= MAX_DEPTH) continue;
+
+        // best split plane over all axes, SAH_BINS bins across the centroid bounds
+        float bestCost = FLT_MAX;
+        int bestAxis = -1, bestSplit = 0;
+        for (int axis = 0; axis < 3; ++axis) {
+            float extent = cmx[axis] - cmn[axis];
+            if (extent <= 0.0f) continue;
+            float scale = SAH_BINS / extent;
+            uint32_t binCount[SAH_BINS] = {0};
+            glm::vec3 binMin[SAH_BINS], binMax[SAH_BINS];
+            for (int b = 0; b < SAH_BINS; ++b) { binMin[b] = glm::vec3(FLT_MAX); binMax[b] = glm::vec3(-FLT_MAX); }
+            for (uint32_t i = first; i < first + count; ++i) {
+                uint32_t prim = order[i];
+                int b = std::min(SAH_BINS - 1, (int)((centroid[prim][axis] - cmn[axis]) * scale));
+                ++binCount[b];
+                binMin[b] = glm::min(binMin[b], primMin[prim]);
+                binMax[b] = glm::max(binMax[b], primMax[prim]);
+            }
+            // sweep from the left and from the right
+            float leftArea[SAH_BINS - 1];
+            uint32_t leftCount[SAH_BINS - 1];
+            glm::vec3 lmn(FLT_MAX), lmx(-FLT_MAX);
+            uint32_t sum = 0;
+            for (int b = 0; b < SAH_BINS - 1; ++b) {
+                sum += binCount[b];
+                lmn = glm::min(lmn, binMin[b]);
+                lmx = glm::max(lmx, binMax[b]);
+                leftCount[b] = sum;
+                leftArea[b] = sum ? halfArea(lmn, lmx) : 0.0f;
+            }
+            glm::vec3 rmn(FLT_MAX), rmx(-FLT_MAX);
+            sum = 0;
+            for (int b = SAH_BINS - 1; b > 0; --b) {
+                sum += binCount[b];
+                rmn = glm::min(rmn, binMin[b]);
+                rmx = glm::max(rmx, binMax[b]);
+                if (!sum || !leftCount[b - 1]) continue;
+                float cost = leftArea[b - 1] * leftCount[b - 1] + halfArea(rmn, rmx) * sum;
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = b;
+                }
+            }
+        }
+        if (bestAxis < 0) continue; // all centroids coincide
+        float parentArea = halfArea(mn, mx);
+        float splitCost = 1.0f + (parentArea > 0.0f ? bestCost / parentArea : (float)count);
+        if (splitCost >= (float)count && count <= maxLeaf) continue;
+
+        const float scale = SAH_BINS / (cmx[bestAxis] - cmn[bestAxis]);
+        const float lo = cmn[bestAxis];
+        uint32_t* mid = std::partition(&order[first], &order[first] + count, [&](uint32_t prim) {
+            return std::min(SAH_BINS - 1, (int)((centroid[prim][bestAxis] - lo) * scale)) < bestSplit;
+        });
+        uint32_t leftCount = (uint32_t)(mid - &order[first]);
+        if (leftCount == 0 || leftCount == count) continue;
+
+        uint32_t left = (uint32_t)nodes.size();
+        nodes.push_back(BvhNode());
+        nodes.push_back(BvhNode());
+        nodes[left].leftOrFirst = first;
+        nodes[left].count = leftCount;
+        nodes[left + 1].leftOrFirst = first + leftCount;
+        nodes[left + 1].count = count - leftCount;
+        nodes[p.node].leftOrFirst = left;
+        nodes[p.node].count = 0;
+        stack.push_back(Pending{left, p.depth + 1});
+        stack.push_back(Pending{left + 1, p.depth + 1});
+    }
+}
+
+// ---- traversal ----
+
+// Ray prepared for slab tests: origin and reciprocal direction. With SSE the three
+// axes are tested in one go (the fourth lane, a node's index/count, is ignored).
+struct RayBox {
+#if BVH_SIMD
+    __m128 origin, invDir;
+    explicit RayBox(const Ray& r) {
+        origin = _mm_set_ps(0.0f, r.origin.z, r.origin.y, r.origin.x);
+        invDir = _mm_set_ps(0.0f, 1.0f / r.direction.z, 1.0f / r.direction.y, 1.0f / r.direction.x);
+    }
+#else
+    glm::vec3 origin, invDir;
+    explicit RayBox(const Ray& r) : origin(r.origin), invDir(1.0f / r.direction) {}
+#endif
+};
+
+// Entry distance of the ray into the node's box if it enters before `tMax`.
+inline bool hitBox(const BvhNode& n, const RayBox& r, float tMax, float& tEnter) {
+#if BVH_SIMD
+    __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(n.boundsMin), r.origin), r.invDir);
+    __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(n.boundsMax), r.origin), r.invDir);
+    __m128 tNear = _mm_min_ps(t1, t2), tFar = _mm_max_ps(t1, t2);
+    tNear = _mm_max_ss(_mm_max_ss(tNear, _mm_shuffle_ps(tNear, tNear, _MM_SHUFFLE(1, 1, 1, 1))),
+                       _mm_shuffle_ps(tNear, tNear, _MM_SHUFFLE(2, 2, 2, 2)));
+    tFar = _mm_min_ss(_mm_min_ss(tFar, _mm_shuffle_ps(tFar, tFar, _MM_SHUFFLE(1, 1, 1, 1))),
+                      _mm_shuffle_ps(tFar, tFar, _MM_SHUFFLE(2, 2, 2, 2)));
+    float enter = std::max(_mm_cvtss_f32(tNear), 0.0f);
+    float leave = std::min(_mm_cvtss_f32(tFar), tMax);
+#else
+    float enter = 0.0f, leave = tMax;
+    for (int a = 0; a < 3; ++a) {
+        float t1 = (n.boundsMin[a] - r.origin[a]) * r.invDir[a];
+        float t2 = (n.boundsMax[a] - r.origin[a]) * r.invDir[a];
+        enter = std::max(enter, std::min(t1, t2));
+        leave = std::min(leave, std::max(t1, t2));
+    }
+#endif
+    tEnter = enter;
+    return enter <= leave;
+}
+
+// Front-to-back walk of a tree: the nearer child first, the other pushed with its entry
+// distance and skipped on pop if a closer hit has been found meanwhile.
+// leaf(first, count, t) tests a primitive range, shrinking t on a hit.
+template <typename LeafFn>
+bool traverseTree(const std::vector<BvhNode>& nodes, const RayBox& rb, float& t, bool anyHit, LeafFn leaf) {
+    if (nodes.empty()) return false;
+    float tEnter;
+    if (!hitBox(nodes[0], rb, t, tEnter)) return false;
+
+    struct Entry { uint32_t node; float tEnter; };
+    Entry stack[64];
+    int sp = 0;
+    bool hit = false;
+    uint32_t current = 0;
+    for (;;) {
+        const BvhNode& n = nodes[current];
+        if (n.count) {
+            if (leaf(n.leftOrFirst, n.count, t)) {
+                hit = true;
+                if (anyHit) return true;
+            }
+        } else {
+            float tl, tr;
+            bool hl = hitBox(nodes[n.leftOrFirst], rb, t, tl);
+            bool hr = hitBox(nodes[n.leftOrFirst + 1], rb, t, tr);
+            if (hl && hr) {
+                uint32_t nearNode = n.leftOrFirst, farNode = n.leftOrFirst + 1;
+                if (tr < tl) { std::swap(nearNode, farNode); std::swap(tl, tr); }
+                stack[sp].node = farNode;
+                stack[sp].tEnter = tr;
+                ++sp;
+                current = nearNode;
+                continue;
+            }
+            if (hl || hr) {
+                current = hl ? n.leftOrFirst : n.leftOrFirst + 1;
+                continue;
+            }
+        }
+        // pop the next subtree that can still beat the closest hit
+        for (;;) {
+            if (sp == 0) return hit;
+            --sp;
+            if (stack[sp].tEnter <= t) break;
+        }
+        current = stack[sp].node;
+    }
+}
+
+// Moller-Trumbore; accepts hits in (0, t).
+inline bool hitTriangle(const glm::vec3& o, const glm::vec3& d, const glm::vec3& v0, const glm::vec3& e1,
+                        const glm::vec3& e2, float& t) {
+    glm::vec3 p = glm::cross(d, e2);
+    float det = glm::dot(e1, p);
+    if (std::fabs(det) < 1e-12f) return false;
+    float inv = 1.0f / det;
+    glm::vec3 s = o - v0;
+    float u = glm::dot(s, p) * inv;
+    if (u < 0.0f || u > 1.0f) return false;
+    glm::vec3 q = glm::cross(s, e1);
+    float v = glm::dot(d, q) * inv;
+    if (v < 0.0f || u + v > 1.0f) return false;
+    float h = glm::dot(e2, q) * inv;
+    if (h <= 0.0f || h >= t) return false;
+    t = h;
+    return true;
+}
+
+Ray toLocal(const Ray& ray, const glm::mat4& worldToLocal) {
+    Ray local;
+    local.origin = glm::vec3(worldToLocal * glm::vec4(ray.origin, 1.0f));
+    local.direction = glm::vec3(worldToLocal * glm::vec4(ray.direction, 0.0f)); // unnormalized: same t
+    local.tMax = ray.tMax;
+    return local;
+}
+
+} // namespace
+
+// ---------------- MeshBVH ----------------
+
+void MeshBVH::build(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices) {
+    const size_t triangles = indices.size() / 3;
+    std::vector<glm::vec3> triMin(triangles), triMax(triangles);
+    for (size_t i = 0; i < triangles; ++i) {
+        const glm::vec3& a = positions[indices[3 * i]];
+        const glm::vec3& b = positions[indices[3 * i + 1]];
+        const glm::vec3& c = positions[indices[3 * i + 2]];
+        triMin[i] = glm::min(a, glm::min(b, c));
+        triMax[i] = glm::max(a, glm::max(b, c));
+    }
+    std::vector<uint32_t> order;
+    buildTree(triMin, triMax, 4, nodes, order);
+
+    v0.resize(triangles);
+    edge1.resize(triangles);
+    edge2.resize(triangles);
+    for (size_t i = 0; i < triangles; ++i) {
+        uint32_t tri = order[i];
+        const glm::vec3& a = positions[indices[3 * tri]];
+        v0[i] = a;
+        edge1[i] = positions[indices[3 * tri + 1]] - a;
+        edge2[i] = positions[indices[3 * tri + 2]] - a;
+    }
+}
+
+bool MeshBVH::intersect(const Ray& ray, float& t, uint32_t& triangle, bool anyHit) const {
+    const glm::vec3 o = ray.origin, d = ray.direction;
+    return traverseTree(nodes, RayBox(ray), t, anyHit, [&](uint32_t first, uint32_t count, float& tClosest) {
+        bool hit = false;
+        for (uint32_t i = first; i < first + count; ++i) {
+            if (hitTriangle(o, d, v0[i], edge1[i], edge2[i], tClosest)) {
+                triangle = i;
+                hit = true;
+                if (anyHit) break;
+            }
+        }
+        return hit;
+    });
+}
+
+bool MeshBVH::intersectAll(const Ray& ray, float& t, uint32_t& triangle) const {
+    bool hit = false;
+    for (size_t i = 0; i < v0.size(); ++i) {
+        if (hitTriangle(ray.origin, ray.direction, v0[i], edge1[i], edge2[i], t)) {
+            triangle = (uint32_t)i;
+            hit = true;
+        }
+    }
+    return hit;
+}
+
+void MeshBVH::rootBounds(glm::vec3& mn, glm::vec3& mx) const {
+    mn = glm::vec3(nodes[0].boundsMin[0], nodes[0].boundsMin[1], nodes[0].boundsMin[2]);
+    mx = glm::vec3(nodes[0].boundsMax[0], nodes[0].boundsMax[1], nodes[0].boundsMax[2]);
+}
+
+glm::vec3 MeshBVH::triangleNormal(uint32_t triangle) const {
+    return glm::cross(edge1[triangle], edge2[triangle]);
+}
+
+// ---------------- SceneBVH ----------------
+
+void SceneBVH::setMesh(uint32_t meshId, const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices) {
+    Clock::time_point start = Clock::now();
+    if (meshId >= meshes.size()) meshes.resize(meshId + 1);
+    meshes[meshId].build(positions, indices);
+    meshBuildMs += msSince(start);
+}
+
+void SceneBVH::build(const SceneStore& scene) {
+    Clock::time_point start = Clock::now();
+    std::vector<Instance> all;
+    std::vector<glm::vec3> instMin, instMax;
+    for (size_t i = 0; i < scene.nodeCount(); ++i) {
+        uint32_t m = scene.mesh[i];
+        if (m == SCENE_NONE || m >= meshes.size() || meshes[m].empty()) continue;
+        Instance inst;
+        inst.worldToLocal = glm::inverse(scene.world[i]);
+        inst.normalMatrix = glm::mat3(scene.normalMatrix[i]);
+        inst.node = (uint32_t)i;
+        inst.mesh = m;
+        all.push_back(inst);
+        glm::vec3 localMin, localMax, worldMin, worldMax;
+        meshes[m].rootBounds(localMin, localMax);
+        transformBounds(scene.world[i], localMin, localMax, worldMin, worldMax);
+        instMin.push_back(worldMin);
+        instMax.push_back(worldMax);
+    }
+    std::vector<uint32_t> order;
+    buildTree(instMin, instMax, 2, nodes, order);
+    instances.resize(all.size());
+    triangles = 0;
+    for (const Instance& inst : all) triangles += meshes[inst.mesh].triangleCount();
+    for (size_t i = 0; i < order.size(); ++i) instances[i] = all[order[i]];
+    lastBuildMs = msSince(start);
+}
+
+bool SceneBVH::traverse(const Ray& ray, float& t, uint32_t& instance, uint32_t& triangle, bool anyHit,
+                        uint32_t ignoreNode) const {
+    return traverseTree(nodes, RayBox(ray), t, anyHit, [&](uint32_t first, uint32_t count, float& tClosest) {
+        bool hit = false;
+        for (uint32_t i = first; i < first + count; ++i) {
+            const Instance& inst = instances[i];
+            if (inst.node == ignoreNode) continue;
+            if (meshes[inst.mesh].intersect(toLocal(ray, inst.worldToLocal), tClosest, triangle, anyHit)) {
+                instance = i;
+                hit = true;
+                if (anyHit) break;
+            }
+        }
+        return hit;
+    });
+}
+
+void SceneBVH::fillHit(const Ray& ray, float t, uint32_t instance, uint32_t triangle, RayHit& hit) const {
+    const Instance& inst = instances[instance];
+    hit.t = t;
+    hit.node = inst.node;
+    hit.triangle = triangle;
+    hit.position = ray.origin + t * ray.direction;
+    glm::vec3 n = inst.normalMatrix * meshes[inst.mesh].triangleNormal(triangle);
+    float len = glm::length(n);
+    hit.normal = len > 0.0f ? n / len : glm::vec3(0.0f, 1.0f, 0.0f);
+    if (glm::dot(hit.normal, ray.direction) > 0.0f) hit.normal = -hit.normal;
+}
+
+bool SceneBVH::intersect(const Ray& ray, RayHit& hit) const {
+    float t = ray.tMax;
+    uint32_t instance = 0, triangle = 0;
+    if (!traverse(ray, t, instance, triangle, false, SCENE_NONE)) return false;
+    fillHit(ray, t, instance, triangle, hit);
+    return true;
+}
+
+bool SceneBVH::occluded(const glm::vec3& from, const glm::vec3& to, uint32_t ignoreNode) const {
+    Ray ray;
+    ray.origin = from;
+    ray.direction = to - from;
+    float t = 1.0f; // the segment
+    uint32_t instance, triangle;
+    return traverse(ray, t, instance, triangle, true, ignoreNode);
+}
+
+bool SceneBVH::intersectBruteForce(const Ray& ray, RayHit& hit) const {
+    float t = ray.tMax;
+    uint32_t instance = 0, triangle = 0;
+    bool any = false;
+    for (size_t i = 0; i < instances.size(); ++i) {
+        const Instance& inst = instances[i];
+        if (meshes[inst.mesh].intersectAll(toLocal(ray, inst.worldToLocal), t, triangle)) {
+            instance = (uint32_t)i;
+            any = true;
+        }
+    }
+    if (any) fillHit(ray, t, instance, triangle, hit);
+    return any;
+}
+
+glm::vec3 SceneBVH::boundsMin() const {
+    return nodes.empty() ? glm::vec3(0.0f) : glm::vec3(nodes[0].boundsMin[0], nodes[0].boundsMin[1], nodes[0].boundsMin[2]);
+}
+
+glm::vec3 SceneBVH::boundsMax() const {
+    return nodes.empty() ? glm::vec3(0.0f) : glm::vec3(nodes[0].boundsMax[0], nodes[0].boundsMax[1], nodes[0].boundsMax[2]);
+}
+
+void SceneBVH::report(std::ostream& os) const {
+    size_t meshCount = 0, meshTriangles = 0, meshNodes = 0;
+    for (const MeshBVH& m : meshes) {
+        if (m.empty()) continue;
+        ++meshCount;
+        meshTriangles += m.triangleCount();
+        meshNodes += m.nodeCount();
+    }
+    os << "  ray queries    : " << instances.size() << " instances, " << triangles << " triangles ("
+       << nodes.size() << " top-level nodes, " << lastBuildMs << " ms), " << meshCount << " mesh trees ("
+       << meshTriangles << " triangles, " << meshNodes << " nodes, " << meshBuildMs << " ms), "
+       << (BVH_SIMD ? "SSE" : "scalar") << " box tests\n";
+}
+
+void benchmarkRays(const SceneBVH& bvh, JobSystem& jobs, size_t rayCount, std::ostream& os) {
+    if (!bvh.instanceCount() || !rayCount) {
+        os << "Ray bench: nothing to trace\n";
+        return;
+    }
+    // random origins inside the scene, uniformly distributed directions
+    const glm::vec3 mn = bvh.boundsMin(), mx = bvh.boundsMax();
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<float> u01(0.0f, 1.0f);
+    std::vector<Ray> rays(rayCount);
+    for (Ray& r : rays) {
+        r.origin = mn + (mx - mn) * glm::vec3(u01(rng), u01(rng), u01(rng));
+        float z = 2.0f * u01(rng) - 1.0f, phi = 6.2831853f * u01(rng), s = std::sqrt(1.0f - z * z);
+        r.direction = glm::vec3(s * std::cos(phi), z, s * std::sin(phi));
+    }
+    const size_t threads = jobs.workerCount() + 1;
+
+    std::vector<float> hitT(rayCount);
+    std::atomic<size_t> hits(0), blocked(0);
+    Clock::time_point start = Clock::now();
+    jobs.parallelFor(rayCount, 1024, [&](size_t begin, size_t end) {
+        size_t local = 0;
+        for (size_t i = begin; i < end; ++i) {
+            RayHit hit;
+            hitT[i] = bvh.intersect(rays[i], hit) ? hit.t : FLT_MAX;
+            if (hitT[i] != FLT_MAX) ++local;
+        }
+        hits += local;
+    });
+    double closestMs = msSince(start);
+
+    start = Clock::now();
+    jobs.parallelFor(rayCount, 1024, [&](size_t begin, size_t end) {
+        size_t local = 0;
+        for (size_t i = begin; i < end; ++i) {
+            if (bvh.occluded(rays[i].origin, rays[i].origin + 10.0f * rays[i].direction)) ++local;
+        }
+        blocked += local;
+    });
+    double occludedMs = msSince(start);
+
+    // the naive per-triangle loop is orders of magnitude slower: a sample of ~50M
+    // triangle tests checks both speed and that the tree finds the same hits
+    size_t sample = (size_t)(5e7 / (double)std::max(bvh.instancedTriangles(), (size_t)1));
+    sample = std::min(rayCount, std::max(sample, (size_t)16));
+    std::atomic<size_t> mismatches(0);
+    start = Clock::now();
+    jobs.parallelFor(sample, 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            RayHit hit;
+            float t = bvh.intersectBruteForce(rays[i], hit) ? hit.t : FLT_MAX;
+            if (std::fabs(t - hitT[i]) > 1e-3f * std::max(1.0f, t == FLT_MAX ? 1.0f : t)) ++mismatches;
+        }
+    });
+    double bruteMs = msSince(start);
+
+    auto mrays = [](size_t n, double ms) { return ms > 0.0 ? (double)n / (ms * 1000.0) : 0.0; };
+    os << "Ray bench: " << rayCount << " rays, " << bvh.instanceCount() << " instances, " << threads << " threads\n"
+       << "  closest hit    : " << mrays(rayCount, closestMs) << " Mrays/s (" << closestMs << " ms, "
+       << 100.0 * hits / rayCount << "% hit)\n"
+       << "  line of sight  : " << mrays(rayCount, occludedMs) << " Mrays/s (" << occludedMs << " ms, "
+       << 100.0 * blocked / rayCount << "% of 10 m segments blocked)\n"
+       << "  brute force    : " << (bruteMs > 0.0 ? sample * 1000.0 / bruteMs : 0.0) << " rays/s ("
+       << sample << " rays, " << (bruteMs > 0.0 ? mrays(rayCount, closestMs) / mrays(sample, bruteMs) : 0.0)
+       << "x slower than the BVH), " << mismatches << " hits differing from the BVH\n";
+}
@@ -0,0 +1,109 @@
+#ifndef BVH_HPP
+#define BVH_HPP
+
+#include <cfloat>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class JobSystem;
+class SceneStore;
+
+struct Ray {
+    glm::vec3 origin = glm::vec3(0.0f);
+    glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f); // need not be unit length; t is in its units
+    float tMax = FLT_MAX;
+};
+
+struct RayHit {
+    float t = FLT_MAX;
+    uint32_t node = 0xFFFFFFFFu;    // scene node that was hit (SCENE_NONE: nothing)
+    uint32_t triangle = 0;          // triangle of the node's mesh, in MeshBVH order
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::vec3 normal = glm::vec3(0.0f); // world, unit length, facing the ray
+};
+
+// Flat BVH node, 32 bytes; children of an inner node are adjacent (left, left + 1).
+struct BvhNode {
+    float boundsMin[3];
+    uint32_t leftOrFirst;  // inner: left child index, leaf: first primitive
+    float boundsMax[3];
+    uint32_t count;        // 0 = inner node
+};
+
+// Triangle BVH of one mesh in its local space, built once from the CPU copy of the
+// mesh's positions (binned SAH). Triangles are stored in leaf order, pre-transformed
+// for Moller-Trumbore.
+class MeshBVH {
+public:
+    // `indices` index `positions`, three per triangle.
+    void build(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices);
+    bool empty() const { return nodes.empty(); }
+    size_t triangleCount() const { return v0.size(); }
+    size_t nodeCount() const { return nodes.size(); }
+    void rootBounds(glm::vec3& mn, glm::vec3& mx) const;
+
+    // Closest hit closer than `t` (updated). With anyHit, stops at the first one.
+    bool intersect(const Ray& ray, float& t, uint32_t& triangle, bool anyHit) const;
+    // Brute force over every triangle, for validating/benchmarking the tree.
+    bool intersectAll(const Ray& ray, float& t, uint32_t& triangle) const;
+    glm::vec3 triangleNormal(uint32_t triangle) const; // local, unnormalized
+
+private:
+    std::vector<BvhNode> nodes;
+    std::vector<glm::vec3> v0, edge1, edge2;
+};
+
+// Two-level BVH over a scene: one MeshBVH per mesh id (setMesh, once), and a top-level
+// tree over the scene's mesh instances (build, whenever the published scene changes).
+// Rays are transformed into each instance's local space, so rooms built from the same
+// bench mesh share a single triangle tree. Queries are const and may run on any thread.
+class SceneBVH {
+public:
+    void setMesh(uint32_t meshId, const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices);
+    // Nodes whose mesh has no geometry (setMesh never called) are not hit.
+    void build(const SceneStore& scene);
+
+    // Closest hit along the ray. Returns false if nothing is hit before ray.tMax.
+    bool intersect(const Ray& ray, RayHit& hit) const;
+    // Line of sight: true if any geometry lies between `from` and `to`, ignoring the
+    // node `ignoreNode` (e.g. the bulb a light sits in).
+    bool occluded(const glm::vec3& from, const glm::vec3& to, uint32_t ignoreNode = 0xFFFFFFFFu) const;
+    // Reference answer: every instance, every triangle, no trees.
+    bool intersectBruteForce(const Ray& ray, RayHit& hit) const;
+
+    size_t instanceCount() const { return instances.size(); }
+    size_t instancedTriangles() const { return triangles; }
+    // World bounds of everything that can be hit.
+    glm::vec3 boundsMin() const;
+    glm::vec3 boundsMax() const;
+    double buildMs() const { return lastBuildMs; }
+    void report(std::ostream& os) const;
+
+private:
+    struct Instance {
+        glm::mat4 worldToLocal;
+        glm::mat3 normalMatrix;
+        uint32_t node;
+        uint32_t mesh;
+    };
+    bool traverse(const Ray& ray, float& t, uint32_t& instance, uint32_t& triangle, bool anyHit,
+                  uint32_t ignoreNode) const;
+    void fillHit(const Ray& ray, float t, uint32_t instance, uint32_t triangle, RayHit& hit) const;
+
+    std::vector<MeshBVH> meshes;
+    std::vector<BvhNode> nodes;
+    std::vector<Instance> instances; // in leaf order
+    size_t triangles = 0;            // summed over instances
+    double lastBuildMs = 0.0;
+    double meshBuildMs = 0.0;
+};
+
+// Rays per second of the tree against brute force, for --ray-bench. Rays start at random
+// points inside the scene bounds in random directions (fixed seed); closest-hit and
+// line-of-sight (10 m segments) are timed separately, spread over the job system.
+void benchmarkRays(const SceneBVH& bvh, JobSystem& jobs, size_t rayCount, std::ostream& os);
+
+#endif
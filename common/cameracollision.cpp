@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <set>
+#include <tuple>
+
+#include <btBulletCollisionCommon.h>
+
+#include "scenestore.hpp"
+#include "cameracollision.hpp"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// gap kept between the capsule and what it slid against
+const float SKIN = 0.01f;
+
+btVector3 toBt(const glm::vec3& v) { return btVector3(v.x, v.y, v.z); }
+glm::vec3 toGlm(const btVector3& v) { return glm::vec3(v.x(), v.y(), v.z()); }
+
+// Deepest penetration of the capsule into the world, as the push that resolves it.
+struct PenetrationCallback : public btCollisionWorld::ContactResultCallback {
+    btVector3 push = btVector3(0, 0, 0);
+    btScalar depth = 0;
+
+    virtual btScalar addSingleResult(btManifoldPoint& cp, const btCollisionObjectWrapper* colObj0Wrap, int, int,
+                                     const btCollisionObjectWrapper*, int, int) {
+        btScalar d = cp.getDistance();
+        if (d >= -SKIN * 0.5f || -d <= depth) return 0;
+        // the normal points from object 1 towards object 0; the capsule may be either
+        btScalar sign = colObj0Wrap->getCollisionObject()->getCollisionShape()->getShapeType() ==
+                                CAPSULE_SHAPE_PROXYTYPE ? 1 : -1;
+        depth = -d;
+        push = cp.m_normalWorldOnB * sign * depth;
+        return 0;
+    }
+};
+
+// Closest sweep hit against a surface facing the motion. A capsule already resting on a
+// surface keeps touching it while sliding along it; those contacts don't block.
+struct BlockingSweepCallback : public btCollisionWorld::ClosestConvexResultCallback {
+    btVector3 direction;
+
+    BlockingSweepCallback(const btVector3& from, const btVector3& to)
+        : btCollisionWorld::ClosestConvexResultCallback(from, to), direction((to - from).normalized()) {
+        m_collisionFilterGroup = btBroadphaseProxy::CharacterFilter;
+        m_collisionFilterMask = btBroadphaseProxy::StaticFilter;
+    }
+
+    virtual btScalar addSingleResult(btCollisionWorld::LocalConvexResult& result, bool normalInWorldSpace) {
+        btVector3 n = normalInWorldSpace ? result.m_hitNormalLocal
+                                         : result.m_hitCollisionObject->getWorldTransform().getBasis() * result.m_hitNormalLocal;
+        if (n.dot(direction) > -0.01f) return btScalar(1.0);
+        return btCollisionWorld::ClosestConvexResultCallback::addSingleResult(result, normalInWorldSpace);
+    }
+};
+
+} // namespace
+
+struct CameraCollider::MeshShape {
+    std::vector<btScalar> vertices;
+    std::vector<int> indices;
+    std::unique_ptr<btTriangleIndexVertexArray> triangles;
+    std::unique_ptr<btCollisionShape> shape;   // btBvhTriangleMeshShape or btBoxShape
+    bool box = false;
+    glm::vec3 boxCenter = glm::vec3(0.0f);      // btBoxShape is centred on its origin
+    glm::vec3 boxHalfExtents = glm::vec3(0.0f);
+};
+
+CameraCollider::CameraCollider() {}
+
+CameraCollider::~CameraCollider() {
+    // the world keeps raw pointers to its objects
+    if (world) {
+        for (auto& o : objects) world->removeCollisionObject(o.get());
+    }
+    objects.clear();
+}
+
+void CameraCollider::init(const CameraCollisionConfig& config) {
+    cfg = config;
+    collisionConfig.reset(new btDefaultCollisionConfiguration());
+    dispatcher.reset(new btCollisionDispatcher(collisionConfig.get()));
+    broadphase.reset(new btDbvtBroadphase());
+    world.reset(new btCollisionWorld(dispatcher.get(), broadphase.get(), collisionConfig.get()));
+    capsule.reset(new btCapsuleShape(cfg.radius, cfg.height));
+    capsuleObject.reset(new btCollisionObject());
+    capsuleObject->setCollisionShape(capsule.get());
+}
+
+void CameraCollider::setMesh(uint32_t meshId, const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices) {
+    if (!world || indices.size() < 3) return;
+    if (meshId >= meshes.size()) meshes.resize(meshId + 1);
+    std::unique_ptr<MeshShape> m(new MeshShape());
+
+    // a mesh whose vertices are exactly the 8 corners of its bounds (the light box) is
+    // cheaper as a box than as 12 triangles
+    glm::vec3 mn(FLT_MAX), mx(-FLT_MAX);
+    for (uint32_t i : indices) {
+        mn = glm::min(mn, positions[i]);
+        mx = glm::max(mx, positions[i]);
+    }
+    std::set<std::tuple<float, float, float>> corners;
+    bool onCorners = mx.x > mn.x && mx.y > mn.y && mx.z > mn.z;
+    for (size_t k = 0; k < indices.size() && onCorners; ++k) {
+        const glm::vec3& p = positions[indices[k]];
+        for (int a = 0; a < 3; ++a) onCorners = onCorners && (p[a] == mn[a] || p[a] == mx[a]);
+        corners.insert(std::make_tuple(p.x, p.y, p.z));
+    }
+    if (onCorners && corners.size() == 8 && indices.size() == 36) {
+        m->box = true;
+        m->boxCenter = 0.5f * (mn + mx);
+        m->boxHalfExtents = 0.5f * (mx - mn);
+        m->shape.reset(new btBoxShape(toBt(m->boxHalfExtents)));
+    } else {
+        m->vertices.reserve(positions.size() * 3);
+        for (const glm::vec3& p : positions) {
+            m->vertices.push_back(p.x);
+            m->vertices.push_back(p.y);
+            m->vertices.push_back(p.z);
+        }
+        m->indices.assign(indices.begin(), indices.end());
+        m->triangles.reset(new btTriangleIndexVertexArray((int)(m->indices.size() / 3), m->indices.data(), 3 * sizeof(int),
+                                                          (int)positions.size(), m->vertices.data(), 3 * sizeof(btScalar)));
+        m->shape.reset(new btBvhTriangleMeshShape(m->triangles.get(), true));
+    }
+    meshes[meshId] = std::move(m);
+}
+
+// The mesh's shape at the given scale; scaled copies are shared between instances.
+btCollisionShape* CameraCollider::instanceShape(uint32_t meshId, const glm::vec3& scale) {
+    MeshShape& m = *meshes[meshId];
+    if (glm::all(glm::lessThan(glm::abs(scale - glm::vec3(1.0f)), glm::vec3(1e-5f)))) return m.shape.get();
+    std::unique_ptr<btCollisionShape>& scaled = scaledShapes[std::make_tuple(meshId, scale.x, scale.y, scale.z)];
+    if (!scaled) {
+        if (m.box) scaled.reset(new btBoxShape(toBt(m.boxHalfExtents * scale)));
+        else scaled.reset(new btScaledBvhTriangleMeshShape((btBvhTriangleMeshShape*)m.shape.get(), toBt(scale)));
+    }
+    return scaled.get();
+}
+
+void CameraCollider::addScene(const SceneStore& scene) {
+    if (!world) return;
+    for (size_t i = 0; i < scene.nodeCount(); ++i) {
+        uint32_t mesh = scene.mesh[i];
+        if (mesh == SCENE_NONE || mesh >= meshes.size() || !meshes[mesh]) continue;
+        // world = translation * rotation * scale; Bullet takes the scale on the shape
+        const glm::mat4& w = scene.world[i];
+        glm::vec3 scale(glm::length(glm::vec3(w[0])), glm::length(glm::vec3(w[1])), glm::length(glm::vec3(w[2])));
+        if (scale.x <= 0.0f || scale.y <= 0.0f || scale.z <= 0.0f) continue;
+        glm::mat3 rotation(glm::vec3(w[0]) / scale.x, glm::vec3(w[1]) / scale.y, glm::vec3(w[2]) / scale.z);
+        glm::vec3 origin(w * glm::vec4(meshes[mesh]->boxCenter, 1.0f));
+
+        btMatrix3x3 basis(rotation[0][0], rotation[1][0], rotation[2][0],
+                          rotation[0][1], rotation[1][1], rotation[2][1],
+                          rotation[0][2], rotation[1][2], rotation[2][2]);
+        std::unique_ptr<btCollisionObject> object(new btCollisionObject());
+        object->setCollisionShape(instanceShape(mesh, scale));
+        object->setWorldTransform(btTransform(basis, toBt(origin)));
+        object->setCollisionFlags(object->getCollisionFlags() | btCollisionObject::CF_STATIC_OBJECT);
+        world->addCollisionObject(object.get(), btBroadphaseProxy::StaticFilter,
+                                  btBroadphaseProxy::AllFilter ^ btBroadphaseProxy::StaticFilter);
+        objects.push_back(std::move(object));
+    }
+    world->updateAabbs();
+}
+
+// Pushes the capsule out of whatever it overlaps (a few passes; each resolves the
+// deepest contact). Returns true if it had to move.
+bool CameraCollider::depenetrate(glm::vec3& center) {
+    bool moved = false;
+    for (int pass = 0; pass < 4; ++pass) {
+        capsuleObject->setWorldTransform(btTransform(btMatrix3x3::getIdentity(), toBt(center)));
+        PenetrationCallback cb;
+        world->contactTest(capsuleObject.get(), cb);
+        if (cb.depth <= 0) break;
+        center += toGlm(cb.push);
+        ++pushes;
+        moved = true;
+    }
+    return moved;
+}
+
+glm::vec3 CameraCollider::move(const glm::vec3& from, const glm::vec3& to) {
+    if (!world) return to;
+    Clock::time_point start = Clock::now();
+    const glm::vec3 eye(0.0f, cfg.eyeOffset, 0.0f);
+    glm::vec3 pos = from - eye, target = to - eye;
+
+    // collide and slide: sweep to the target, stop at the first contact, then keep
+    // only the part of the remaining motion along the surface
+    for (int slide = 0; slide < cfg.maxSlides; ++slide) {
+        glm::vec3 delta = target - pos;
+        float length = glm::length(delta);
+        if (length < 1e-6f) break;
+        btVector3 a = toBt(pos), b = toBt(target);
+        BlockingSweepCallback cb(a, b);
+        world->convexSweepTest(capsule.get(), btTransform(btMatrix3x3::getIdentity(), a),
+                               btTransform(btMatrix3x3::getIdentity(), b), cb);
+        ++sweeps;
+        if (!cb.hasHit()) {
+            pos = target;
+            break;
+        }
+        ++hits;
+        float fraction = std::max(cb.m_closestHitFraction - SKIN / length, 0.0f);
+        pos += delta * fraction;
+        glm::vec3 n = glm::normalize(toGlm(cb.m_hitNormalWorld));
+        glm::vec3 rest = target - pos;
+        target = pos + rest - n * glm::dot(rest, n);
+    }
+    depenetrate(pos);
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    moveSeconds += seconds;
+    worstMoveSeconds = std::max(worstMoveSeconds, seconds);
+    ++moves;
+    return pos + eye;
+}
+
+void CameraCollider::report(std::ostream& os) const {
+    if (!world) return;
+    size_t boxes = 0, triangleMeshes = 0;
+    for (const auto& m : meshes) {
+        if (!m) continue;
+        if (m->box) ++boxes;
+        else ++triangleMeshes;
+    }
+    os << "  camera collide : " << objects.size() << " static objects (" << triangleMeshes << " triangle meshes, "
+       << boxes << " boxes, " << scaledShapes.size() << " scaled shapes), " << moves << " moves, "
+       << (moves ? moveSeconds * 1e6 / moves : 0.0) << " us mean / " << worstMoveSeconds * 1e6 << " us worst, "
+       << sweeps << " sweeps, " << hits << " contacts, " << pushes << " push-outs\n";
+}
@@ -0,0 +1,76 @@
+#ifndef CAMERACOLLISION_HPP
+#define CAMERACOLLISION_HPP
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <tuple>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class SceneStore;
+class btBroadphaseInterface;
+class btCapsuleShape;
+class btCollisionConfiguration;
+class btCollisionDispatcher;
+class btCollisionObject;
+class btCollisionShape;
+class btCollisionWorld;
+class btTriangleIndexVertexArray;
+
+struct CameraCollisionConfig {
+    float radius = 0.25f;      // capsule radius, metres
+    float height = 0.9f;       // straight part of the capsule, which hangs below the eye
+    float eyeOffset = 0.4f;    // eye above the capsule's centre
+    int maxSlides = 4;         // sweep/slide iterations per move
+};
+
+// Kinematic capsule around the fly camera, colliding with the static scene through a
+// Bullet collision world (no dynamics): btDbvtBroadphase over one collision object per
+// scene node, btBvhTriangleMeshShape per mesh (btBoxShape for meshes that are boxes),
+// shared between instances. Each move sweeps the capsule from the old to the new eye
+// position and slides along whatever it hits, so cost follows the two trees, not the
+// number of objects in the scene.
+class CameraCollider {
+public:
+    CameraCollider();
+    ~CameraCollider();
+
+    void init(const CameraCollisionConfig& config);
+    bool active() const { return world != nullptr; }
+    // Collision shape of a scene mesh (local space, three indices per triangle).
+    void setMesh(uint32_t meshId, const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices);
+    // One static object per node whose mesh has a shape. Call once the scene is built
+    // and update()d; nodes are not tracked afterwards.
+    void addScene(const SceneStore& scene);
+
+    // Eye position reached moving from `from` towards `to` (one fixed tick).
+    glm::vec3 move(const glm::vec3& from, const glm::vec3& to);
+    void report(std::ostream& os) const;
+
+private:
+    CameraCollider(const CameraCollider&);
+    CameraCollider& operator=(const CameraCollider&);
+
+    struct MeshShape;
+    btCollisionShape* instanceShape(uint32_t meshId, const glm::vec3& scale);
+    bool depenetrate(glm::vec3& center);
+
+    CameraCollisionConfig cfg;
+    std::unique_ptr<btCollisionConfiguration> collisionConfig;
+    std::unique_ptr<btCollisionDispatcher> dispatcher;
+    std::unique_ptr<btBroadphaseInterface> broadphase;
+    std::unique_ptr<btCollisionWorld> world;
+    std::unique_ptr<btCapsuleShape> capsule;
+    std::unique_ptr<btCollisionObject> capsuleObject;   // for contact tests, not in the world
+    std::vector<std::unique_ptr<MeshShape>> meshes;     // by mesh id
+    std::map<std::tuple<uint32_t, float, float, float>, std::unique_ptr<btCollisionShape>> scaledShapes;
+    std::vector<std::unique_ptr<btCollisionObject>> objects;
+
+    unsigned long long moves = 0, sweeps = 0, hits = 0, pushes = 0;
+    double moveSeconds = 0.0, worstMoveSeconds = 0.0;
+};
+
+#endif
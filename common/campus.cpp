@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "lightculling.hpp"
+#include "scenestore.hpp"
+#include "campus.hpp"
+
+namespace {
+
+// Bench layout of the original classroom: the two middle columns joined (3.5 m between
+// centres), every other column 4.5 m from its neighbour, rows 2 m apart back to front.
+const float JOINED_COLUMNS = 3.5f;
+const float COLUMN_SPACING = 4.5f;
+const float ROW_SPACING = 2.0f;
+const float BENCH_SCALE = 0.35f;
+const float BENCH_Y = 0.68f;
+
+// mt19937's output is the same everywhere; the <random> distributions are not
+struct CampusRandom {
+    explicit CampusRandom(uint32_t seed) : engine(seed) {}
+    float next01() { return (float)(engine() >> 8) * (1.0f / 16777216.0f); }
+    std::mt19937 engine;
+};
+
+std::vector<float> benchColumnX(int columns) {
+    std::vector<float> x((size_t)std::max(columns, 0));
+    if (columns <= 0) return x;
+    int mid = columns / 2;
+    if (columns % 2 == 0) {
+        x[mid - 1] = -JOINED_COLUMNS * 0.5f;
+        x[mid] = JOINED_COLUMNS * 0.5f;
+        for (int c = mid - 2; c >= 0; --c) x[c] = x[c + 1] - COLUMN_SPACING;
+        for (int c = mid + 1; c < columns; ++c) x[c] = x[c - 1] + COLUMN_SPACING;
+    } else {
+        x[mid] = 0.0f;
+        for (int c = mid - 1; c >= 0; --c) x[c] = x[c + 1] - COLUMN_SPACING;
+        for (int c = mid + 1; c < columns; ++c) x[c] = x[c - 1] + COLUMN_SPACING;
+    }
+    return x;
+}
+
+uint32_t tiledMaterial(SceneStore& scene, uint32_t base, const glm::vec2& tiles, const glm::vec2& roomScale) {
+    if (roomScale == glm::vec2(1.0f)) return base;
+    Material m = scene.materials[base];
+    m.uvScale = tiles * roomScale; // keep the tile size, not the tile count
+    return scene.addMaterial(m);
+}
+
+} // namespace
+
+CampusStats generateCampus(SceneStore& scene, const CampusAssets& assets, const CampusConfig& config) {
+    CampusStats stats;
+    const glm::mat4 identity(1.0f);
+    const int rooms = std::max(config.rooms, 0);
+    const int columns = std::max(config.benchColumns, 0);
+    const int rows = std::max(config.benchRows, 0);
+
+    // room size: the standard box, grown in x/z if the bench grid doesn't fit
+    const std::vector<float> colX = benchColumnX(columns);
+    float widestColumn = colX.empty() ? 0.0f : std::max(-colX.front(), colX.back());
+    const float halfWidth = std::max(ROOM_HALF_WIDTH, widestColumn + 3.75f);
+    const float halfDepth = std::max(ROOM_HALF_DEPTH, (float)rows + 2.0f);
+    const glm::vec2 roomScale(halfWidth / ROOM_HALF_WIDTH, halfDepth / ROOM_HALF_DEPTH);
+    const glm::mat4 faceScale = glm::scale(identity, glm::vec3(roomScale.x, 1.0f, roomScale.y));
+    stats.roomSize = 2.0f * glm::vec2(halfWidth, halfDepth);
+
+    const uint32_t floorMaterial = tiledMaterial(scene, assets.floorMaterial, assets.floorTiles, roomScale);
+    const uint32_t ceilingMaterial = tiledMaterial(scene, assets.ceilingMaterial, assets.ceilingTiles, roomScale);
+
+    // bulb variants: standard, warm, cool
+    const glm::vec3 bulbColors[3] = {
+        assets.bulbColor, assets.bulbColor * glm::vec3(1.0f, 0.9f, 0.75f), assets.bulbColor * glm::vec3(0.9f, 0.95f, 1.05f)
+    };
+    uint32_t bulbMaterials[3];
+    float bulbRadius[3];
+    for (int i = 0; i < 3; ++i) {
+        Material m;
+        m.color = bulbColors[i]; // bright: the shader multiplies by surface color
+        m.uvScale = glm::vec2(6.0f);
+        bulbMaterials[i] = (i == 0 || config.variety > 0.0f) ? scene.addMaterial(m) : bulbMaterials[0];
+        bulbRadius[i] = lightEffectiveRadius(bulbColors[i], assets.lightThreshold);
+    }
+
+    const int perRow = config.roomsPerRow > 0 ? config.roomsPerRow
+                                              : std::max(1, (int)std::ceil(std::sqrt((double)rooms)));
+    const float pitchX = 2.0f * halfWidth + config.corridor;
+    const float pitchZ = 2.0f * halfDepth + config.corridor;
+    CampusRandom rng(config.seed);
+
+    for (int i = 0; i < rooms; ++i) {
+        // per-room furniture variety, drawn in a fixed order so layouts depend only on the seed
+        bool varied = rng.next01() < config.variety;
+        bool mirrored = varied && rng.next01() < 0.5f;       // podium (and short columns) on the right
+        bool projector = !(varied && rng.next01() < 0.5f);
+        int bulbVariant = varied ? (int)(rng.next01() * 3.0f) % 3 : 0;
+        float missingBenches = (varied && rng.next01() < 0.5f) ? 0.15f : 0.0f;
+        if (varied) ++stats.variedRooms;
+
+        glm::vec3 origin((float)(i % perRow) * pitchX, 0.0f, (float)(i / perRow) * pitchZ);
+        uint32_t room = scene.addNode(SCENE_NONE, glm::translate(identity, origin));
+
+        scene.addNode(room, faceScale, assets.floorMesh, floorMaterial);
+        scene.addNode(room, faceScale, assets.ceilingMesh, ceilingMaterial);
+        scene.addNode(room, faceScale, assets.frontBackMesh, assets.frontBackMaterial);
+        scene.addNode(room, faceScale, assets.leftRightMesh, assets.leftRightMaterial);
+
+        // ceiling bulbs: a grid inset 2 m from the walls, each a small box node with a light
+        const float bulbY = ROOM_HEIGHT - 0.15f;
+        const float bulbScale = 0.18f;
+        const int bulbCols = std::max(config.bulbColumns, 0), bulbRows = std::max(config.bulbRows, 0);
+        float leftX = -halfWidth + 2.0f, frontZ = -halfDepth + 2.0f;
+        float stepX = bulbCols > 1 ? (2.0f * halfWidth - 4.0f) / float(bulbCols - 1) : 0.0f;
+        float stepZ = bulbRows > 1 ? (2.0f * halfDepth - 4.0f) / float(bulbRows - 1) : 0.0f;
+        if (bulbCols == 1) leftX = 0.0f;
+        if (bulbRows == 1) frontZ = 0.0f;
+        for (int r = 0; r < bulbRows; ++r) {
+            for (int c = 0; c < bulbCols; ++c) {
+                glm::mat4 m = glm::translate(identity, glm::vec3(leftX + c * stepX, bulbY, frontZ + r * stepZ));
+                m = glm::scale(m, glm::vec3(bulbScale, bulbScale * 0.4f, bulbScale));
+                uint32_t bulb = scene.addNode(room, m, assets.bulbMesh, bulbMaterials[bulbVariant]);
+                scene.addLight(bulb, bulbColors[bulbVariant], bulbRadius[bulbVariant]);
+                ++stats.bulbs;
+            }
+        }
+
+        // one group node per placement; the model's shapes are its children
+        auto place = [&](const std::vector<CampusShape>& shapes, const glm::mat4& m) {
+            if (shapes.empty()) return;
+            uint32_t group = scene.addNode(room, m);
+            for (const CampusShape& s : shapes) scene.addNode(group, identity, s.mesh, s.material);
+        };
+        const float side = mirrored ? 1.0f : -1.0f; // podium side of the room
+
+        glm::vec3 podiumPos(side * (halfWidth - 5.0f), 1.15f, -(halfDepth - 2.5f));
+        place(assets.podium, glm::scale(glm::translate(identity, podiumPos), glm::vec3(0.35f)));
+
+        glm::vec3 boardPos(0.0f, 2.5f, -halfDepth + 0.1f);
+        place(assets.greenboard, glm::scale(glm::translate(identity, boardPos), glm::vec3(0.6f, 0.19f, 0.6f)));
+
+        // benches back-aligned per column; columns on the podium side are one row shorter
+        if (!assets.bench.empty()) {
+            const float backZ = halfDepth - 1.0f;
+            for (int c = 0; c < columns; ++c) {
+                int rowCount = (colX[c] * side > 0.0f) ? std::max(rows - 1, 0) : rows;
+                for (int r = 0; r < rowCount; ++r) {
+                    if (missingBenches > 0.0f && rng.next01() < missingBenches) continue;
+                    glm::mat4 m = glm::translate(identity, glm::vec3(colX[c], BENCH_Y, backZ - r * ROW_SPACING));
+                    m = glm::rotate(glm::scale(m, glm::vec3(BENCH_SCALE)), glm::radians(180.0f), glm::vec3(0, 1, 0));
+                    place(assets.bench, m);
+                    ++stats.benches;
+                }
+            }
+        }
+        for (const std::vector<CampusShape>& other : assets.others) place(other, identity);
+
+        // projector sheet, same offset from the front wall as in the original room
+        if (projector) {
+            glm::mat4 pm = glm::translate(identity, glm::vec3(-side * 2.0f, 2.8f, -halfDepth - 1.7f));
+            scene.addNode(room, glm::scale(pm, glm::vec3(1.8f, 1.2f, 1.0f)), assets.projectorMesh, assets.projectorMaterial);
+        }
+        ++stats.rooms;
+    }
+    return stats;
+}
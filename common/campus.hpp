@@ -0,0 +1,64 @@
+#ifndef CAMPUS_HPP
+#define CAMPUS_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class SceneStore;
+
+// Size of the room geometry built by setupGeometry (a 20 x 16 m, 5 m high box). Rooms
+// whose bench grid needs more floor scale it in x/z.
+const float ROOM_HALF_WIDTH = 10.0f;
+const float ROOM_HEIGHT = 5.0f;
+const float ROOM_HALF_DEPTH = 8.0f;
+
+struct CampusConfig {
+    int rooms = 1;
+    int roomsPerRow = 0;          // 0 = as square a block as possible
+    float corridor = 2.0f;        // gap between neighbouring rooms, metres
+    int benchColumns = 4;         // the two middle columns are joined
+    int benchRows = 6;            // columns on the podium side get one row fewer
+    int bulbColumns = 3;
+    int bulbRows = 2;
+    float variety = 0.0f;         // chance that a room deviates from the standard layout
+    uint32_t seed = 1;
+};
+
+// One model shape (mesh + material ids already in the store).
+struct CampusShape {
+    uint32_t mesh;
+    uint32_t material;
+};
+
+// Meshes and materials shared by every room, registered once by the caller.
+struct CampusAssets {
+    uint32_t floorMesh, ceilingMesh, frontBackMesh, leftRightMesh;
+    uint32_t floorMaterial, ceilingMaterial, frontBackMaterial, leftRightMaterial;
+    glm::vec2 floorTiles, ceilingTiles;   // uv scale of the unscaled room
+    uint32_t bulbMesh;
+    glm::vec3 bulbColor;
+    float lightThreshold;                 // see lightEffectiveRadius
+    uint32_t projectorMesh, projectorMaterial;
+    std::vector<CampusShape> bench, greenboard, podium;
+    std::vector<std::vector<CampusShape>> others; // any other model, placed at the room origin
+};
+
+struct CampusStats {
+    int rooms = 0;
+    int benches = 0;
+    int bulbs = 0;
+    int variedRooms = 0;
+    glm::vec2 roomSize = glm::vec2(0.0f);
+};
+
+// Adds `config.rooms` classrooms to the scene, laid out on a grid with corridors between
+// them, room 0 at the origin. Every room is a root node with its surfaces, bulbs (each a
+// node carrying a light), benches, board, podium and projector as children, sharing the
+// meshes in `assets`. With variety > 0 a room may mirror its podium side, lose its
+// projector, miss some benches or get warmer/cooler bulbs; the choices are deterministic
+// for a given seed, so benchmark runs are repeatable.
+CampusStats generateCampus(SceneStore& scene, const CampusAssets& assets, const CampusConfig& config);
+
+#endif
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <cmath>
+
+#include "dynamicresolution.hpp"
+
+namespace {
+
+// GPU times still measured at the old scale after a change (the timer's query ring)
+const int LATENCY_SAMPLES = 4;
+// then at least this many at the new scale before deciding again
+const int DECISION_SAMPLES = 8;
+// scales are multiples of this, so a noisy cost doesn't nudge the target every frame
+const float SCALE_STEP = 1.0f / 32.0f;
+// at most this much larger per change; shrinking is not limited
+const float MAX_GROWTH = 0.0625f;
+
+} // namespace
+
+bool DynamicResolution::init(const DynamicResolutionConfig& config, int width, int height, double budgetMs) {
+    destroy();
+    cfg = config;
+    cfg.minScale = std::min(std::max(cfg.minScale, 0.1f), 1.0f);
+    cfg.maxScale = std::min(std::max(cfg.maxScale, cfg.minScale), 1.0f);
+    frameBudgetMs = cfg.targetMs > 0.0 ? cfg.targetMs : budgetMs > 0.0 ? budgetMs : 1000.0 / 60.0;
+    currentScale = cfg.maxScale;
+    smoothedMs = 0.0;
+    samplesSinceChange = 0;
+    frames = changes = cpuBoundHolds = 0;
+    scaleSum = 0.0;
+    lowestScale = highestScale = currentScale;
+    outputWidth = std::max(1, width);
+    outputHeight = std::max(1, height);
+    framebuffer.create("framebuffer/scene target");
+    allocate();
+    return active();
+}
+
+void DynamicResolution::destroy() {
+    framebuffer.reset();
+    color.reset();
+    depth.reset();
+}
+
+void DynamicResolution::allocate() {
+    color.create("framebuffer/scene target color");
+    depth.create("framebuffer/scene target depth");
+    glBindRenderbuffer(GL_RENDERBUFFER, color.get());
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, outputWidth, outputHeight);
+    gpuResources().setSize(GPU_RENDERBUFFER, color.get(), gpuImageBytes(GL_RGBA8, outputWidth, outputHeight), "RGBA8");
+    glBindRenderbuffer(GL_RENDERBUFFER, depth.get());
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, outputWidth, outputHeight);
+    gpuResources().setSize(GPU_RENDERBUFFER, depth.get(), gpuImageBytes(GL_DEPTH24_STENCIL8, outputWidth, outputHeight),
+                           "DEPTH24_STENCIL8");
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.get());
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color.get());
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth.get());
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) framebuffer.reset();
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void DynamicResolution::resize(int width, int height) {
+    width = std::max(1, width);
+    height = std::max(1, height);
+    if (!active() || (width == outputWidth && height == outputHeight)) return;
+    outputWidth = width;
+    outputHeight = height;
+    allocate();
+}
+
+int DynamicResolution::sceneWidth() const {
+    return std::max(1, (int)std::lround(outputWidth * currentScale));
+}
+
+int DynamicResolution::sceneHeight() const {
+    return std::max(1, (int)std::lround(outputHeight * currentScale));
+}
+
+void DynamicResolution::beginScene() {
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.get());
+    glViewport(0, 0, sceneWidth(), sceneHeight());
+    ++frames;
+    scaleSum += currentScale;
+}
+
+void DynamicResolution::resolve(GLuint outputFramebuffer) {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer.get());
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, outputFramebuffer);
+    glBlitFramebuffer(0, 0, sceneWidth(), sceneHeight(), 0, 0, outputWidth, outputHeight,
+                      GL_COLOR_BUFFER_BIT, currentScale < 1.0f ? GL_LINEAR : GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+    glViewport(0, 0, outputWidth, outputHeight);
+}
+
+void DynamicResolution::update(double gpuMs, double cpuMs) {
+    if (!active() || gpuMs <= 0.0) return;
+    if (++samplesSinceChange <= LATENCY_SAMPLES) return;
+    smoothedMs = smoothedMs > 0.0 ? smoothedMs + 0.25 * (gpuMs - smoothedMs) : gpuMs;
+    if (samplesSinceChange < LATENCY_SAMPLES + DECISION_SAMPLES) return;
+
+    const double aim = frameBudgetMs * cfg.headroom;
+    // dead band around the aim: [0.9, 1.05] x aim keeps the current scale
+    if (smoothedMs <= aim * 1.05 && smoothedMs >= aim * 0.9) return;
+    float desired = currentScale * (float)std::sqrt(aim / smoothedMs);
+    if (desired < currentScale && cpuMs > frameBudgetMs) {
+        ++cpuBoundHolds;
+        return;
+    }
+    desired = std::min(desired, currentScale + MAX_GROWTH);
+    desired = std::floor(desired / SCALE_STEP + 0.5f) * SCALE_STEP;
+    desired = std::min(std::max(desired, cfg.minScale), cfg.maxScale);
+    if (desired == currentScale) return;
+
+    currentScale = desired;
+    lowestScale = std::min(lowestScale, currentScale);
+    highestScale = std::max(highestScale, currentScale);
+    smoothedMs = 0.0;
+    samplesSinceChange = 0;
+    ++changes;
+}
+
+void DynamicResolution::report(std::ostream& os) const {
+    if (!frames) return;
+    os << "  dynamic res    : budget " << frameBudgetMs << " ms (aim " << frameBudgetMs * cfg.headroom
+       << "), scale mean " << scaleSum / (double)frames << ", range " << lowestScale << "-" << highestScale
+       << ", last " << currentScale << " (" << sceneWidth() << "x" << sceneHeight() << "), " << changes << " changes";
+    if (cpuBoundHolds) os << ", held " << cpuBoundHolds << "x while CPU bound";
+    os << "\n";
+}
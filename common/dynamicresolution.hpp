@@ -0,0 +1,77 @@
+#ifndef DYNAMICRESOLUTION_HPP
+#define DYNAMICRESOLUTION_HPP
+
+#include <ostream>
+
+#include <glad/glad.h>
+
+#include "gpuresources.hpp"
+
+struct DynamicResolutionConfig {
+    double targetMs = 0.0;     // frame budget; 0 = the pacer's deadline (cap or refresh), else 60 Hz
+    float minScale = 0.5f;     // per axis
+    float maxScale = 1.0f;
+    float headroom = 0.85f;    // aim the scene pass at this fraction of the budget
+};
+
+// Offscreen scene target whose resolution follows the GPU cost of the scene pass.
+//
+// The target is allocated once at the output size; a frame renders into its
+// bottom-left `scale` part (viewport only, nothing is reallocated when the scale moves)
+// and resolve() stretches that part over the output with a bilinear blit. update() is
+// fed the scene pass' GPU time (GpuTimer, a few frames late) and the frame's CPU time:
+// pixel cost goes with the area, so the scale moves by sqrt(budget / cost), quickly down
+// and slowly back up, and holds while CPU time alone is over budget (fewer pixels
+// wouldn't help) or while a change is still working its way through the timer queries.
+//
+//   dynres.beginScene();                 // instead of binding the output framebuffer
+//   ... clear, draw ...
+//   dynres.resolve(outputFramebuffer);   // output bound for reading/drawing afterwards
+//   dynres.update(gpuMs, cpuMs);         // whenever a new GPU time arrives
+class DynamicResolution {
+public:
+    DynamicResolution() {}
+    ~DynamicResolution() { destroy(); }
+
+    // `budgetMs` is used when config.targetMs is 0 (0 there too = 60 Hz).
+    bool init(const DynamicResolutionConfig& config, int width, int height, double budgetMs);
+    void destroy();
+    bool active() const { return (bool)framebuffer; }
+
+    // Output size changed (window resize): reallocates the target.
+    void resize(int width, int height);
+
+    void beginScene();
+    void resolve(GLuint outputFramebuffer);
+    void update(double gpuMs, double cpuMs);
+
+    // The scene target, for passes that write the scaled image before resolve().
+    GLuint target() const { return framebuffer.get(); }
+    float scale() const { return currentScale; }
+    int sceneWidth() const;
+    int sceneHeight() const;
+
+    // Budget, scale range reached, average scale and number of changes.
+    void report(std::ostream& os) const;
+
+private:
+    DynamicResolution(const DynamicResolution&);
+    DynamicResolution& operator=(const DynamicResolution&);
+
+    void allocate();
+
+    DynamicResolutionConfig cfg;
+    GpuFramebuffer framebuffer;
+    GpuRenderbuffer color, depth;
+    int outputWidth = 0, outputHeight = 0;
+    double frameBudgetMs = 0.0;
+    float currentScale = 1.0f;
+    double smoothedMs = 0.0;      // GPU time since the last change, exponentially averaged
+    int samplesSinceChange = 0;
+
+    unsigned long long frames = 0, changes = 0, cpuBoundHolds = 0;
+    double scaleSum = 0.0;
+    float lowestScale = 1.0f, highestScale = 0.0f;
+};
+
+#endif
@@ -0,0 +1,107 @@
+#include <vector>
+
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "filewatcher.hpp"
+
+namespace {
+
+long long modifiedTime(const std::string& path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) return -1;
+    return (long long)st.st_mtime;
+}
+
+std::string directoryOf(const std::string& canonicalPath) {
+    size_t slash = canonicalPath.find_last_of('/');
+    return slash ? canonicalPath.substr(0, slash) : "/";
+}
+
+} // namespace
+
+std::string FileWatcher::canonical(const std::string& path) {
+    bool absolute = !path.empty() && (path[0] == '/' || path[0] == '\\');
+    std::vector<std::string> parts;
+    std::string part;
+    for (size_t i = 0; i <= path.size(); ++i) {
+        if (i < path.size() && path[i] != '/' && path[i] != '\\') {
+            part += path[i];
+            continue;
+        }
+        if (part == "..") {
+            if (!parts.empty() && parts.back() != "..") parts.pop_back();
+            else if (!absolute) parts.push_back(part);
+        } else if (!part.empty() && part != ".") {
+            parts.push_back(part);
+        }
+        part.clear();
+    }
+    std::string out = absolute ? "/" : (parts.size() < 2 ? "./" : "");
+    for (size_t i = 0; i < parts.size(); ++i) out += (i ? "/" : "") + parts[i];
+    return out;
+}
+
+const char* FileWatcher::backendName() const {
+    return inotifyFd >= 0 ? "inotify" : "mtime polling";
+}
+
+void FileWatcher::watch(const std::string& path) {
+    std::string file = canonical(path);
+    if (!files.insert(file).second) return;
+    mtimes[file] = modifiedTime(file);
+#ifdef __linux__
+    if (inotifyFd < 0) inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0) return; // falls back to polling
+    std::string dir = directoryOf(file);
+    for (const auto& d : directories) if (d.second == dir) return;
+    int wd = inotify_add_watch(inotifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd >= 0) directories[wd] = dir;
+#endif
+}
+
+void FileWatcher::destroy() {
+#ifdef __linux__
+    if (inotifyFd >= 0) close(inotifyFd);
+#endif
+    inotifyFd = -1;
+    directories.clear();
+    files.clear();
+    mtimes.clear();
+}
+
+std::vector<std::string> FileWatcher::changed() {
+    std::set<std::string> hits;
+#ifdef __linux__
+    if (inotifyFd >= 0) {
+        alignas(inotify_event) char buffer[4096];
+        for (;;) {
+            ssize_t n = read(inotifyFd, buffer, sizeof(buffer));
+            if (n <= 0) break; // EAGAIN: nothing more queued
+            for (char* p = buffer; p < buffer + n;) {
+                const inotify_event* ev = (const inotify_event*)p;
+                p += sizeof(inotify_event) + ev->len;
+                auto dir = directories.find(ev->wd);
+                if (dir == directories.end() || !ev->len) continue;
+                std::string file = dir->second + (dir->second == "/" ? "" : "/") + ev->name;
+                if (files.count(file)) hits.insert(file);
+            }
+        }
+        return std::vector<std::string>(hits.begin(), hits.end());
+    }
+#endif
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (now - lastScan < std::chrono::milliseconds(pollIntervalMs)) return std::vector<std::string>();
+    lastScan = now;
+    for (auto& m : mtimes) {
+        long long t = modifiedTime(m.first);
+        if (t == m.second || t < 0) continue; // mid-save deletes show up as the next write
+        m.second = t;
+        hits.insert(m.first);
+    }
+    return std::vector<std::string>(hits.begin(), hits.end());
+}
@@ -0,0 +1,49 @@
+#ifndef FILEWATCHER_HPP
+#define FILEWATCHER_HPP
+
+#include <chrono>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// Reports files that were written since the last look, without blocking. On Linux it
+// is inotify on the files' directories (close-after-write and rename-into, so both
+// editors that save in place and ones that write a temp file and rename are seen);
+// elsewhere it compares modification times, at most every pollIntervalMs.
+//
+// Paths are compared in canonical() form ("dir/name", no "." or ".." parts, forward
+// slashes); changed() returns them so.
+//
+//   watcher.watch("shaders/phong.frag");
+//   ... every frame:
+//   for (const std::string& path : watcher.changed()) reload(path);
+class FileWatcher {
+public:
+    FileWatcher() {}
+    ~FileWatcher() { destroy(); }
+
+    void watch(const std::string& path);
+    void destroy();
+    // Watched files written since the previous call, each once.
+    std::vector<std::string> changed();
+    bool empty() const { return files.empty(); }
+    // "inotify" or "mtime polling"
+    const char* backendName() const;
+
+    static std::string canonical(const std::string& path);
+
+    int pollIntervalMs = 250;
+
+private:
+    FileWatcher(const FileWatcher&);
+    FileWatcher& operator=(const FileWatcher&);
+
+    std::set<std::string> files;
+    int inotifyFd = -1;                      // Linux only
+    std::map<int, std::string> directories;  // inotify watch -> directory
+    std::map<std::string, long long> mtimes; // polling fallback
+    std::chrono::steady_clock::time_point lastScan;
+};
+
+#endif
@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "flythrough.hpp"
+
+namespace {
+
+const char FLY_MAGIC[4] = {'F', 'L', 'Y', '1'};
+
+template <typename T> void put(std::ostream& out, const T& v) {
+    out.write(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+template <typename T> bool get(std::istream& in, T& v) {
+    return (bool)in.read(reinterpret_cast<char*>(&v), sizeof(v));
+}
+
+template <typename T> T catmullRom(const T& p0, const T& p1, const T& p2, const T& p3, float t) {
+    float t2 = t * t, t3 = t2 * t;
+    return 0.5f * ((2.0f * p1) + (p2 - p0) * t +
+                   (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
+                   (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+}
+
+} // namespace
+
+glm::vec3 cameraFrontFromYawPitch(float yaw, float pitch) {
+    glm::vec3 front;
+    front.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
+    front.y = sin(glm::radians(pitch));
+    front.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
+    return glm::normalize(front);
+}
+
+bool FlythroughRecorder::save(const std::string& path) const {
+    std::ofstream out(path.c_str(), std::ios::binary);
+    if (!out) {
+        std::cerr << "[FLY] cannot write " << path << "\n";
+        return false;
+    }
+    out.write(FLY_MAGIC, sizeof(FLY_MAGIC));
+    put(out, (uint32_t)samples.size());
+    for (const CameraSample& s : samples) {
+        put(out, s.time);
+        put(out, s.position.x); put(out, s.position.y); put(out, s.position.z);
+        put(out, s.yaw); put(out, s.pitch); put(out, s.fov);
+        put(out, s.shadingMode);
+    }
+    return (bool)out;
+}
+
+bool FlythroughPlayer::loadRecording(const std::string& path) {
+    keys.clear();
+    spline = false;
+    std::ifstream in(path.c_str(), std::ios::binary);
+    char magic[4];
+    uint32_t count = 0;
+    if (!in || !in.read(magic, sizeof(magic)) || std::memcmp(magic, FLY_MAGIC, sizeof(magic)) != 0 || !get(in, count)) {
+        std::cerr << "[FLY] " << path << " is not a flythrough recording\n";
+        return false;
+    }
+    keys.resize(count);
+    for (CameraSample& s : keys) {
+        bool ok = get(in, s.time) &&
+                  get(in, s.position.x) && get(in, s.position.y) && get(in, s.position.z) &&
+                  get(in, s.yaw) && get(in, s.pitch) && get(in, s.fov) &&
+                  get(in, s.shadingMode);
+        if (!ok) {
+            std::cerr << "[FLY] " << path << " is truncated\n";
+            keys.clear();
+            return false;
+        }
+    }
+    return !keys.empty();
+}
+
+bool FlythroughPlayer::loadPath(const std::string& path) {
+    keys.clear();
+    spline = true;
+    std::ifstream in(path.c_str());
+    if (!in) {
+        std::cerr << "[FLY] cannot read " << path << "\n";
+        return false;
+    }
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        std::istringstream ls(line);
+        CameraSample k;
+        if (!(ls >> k.time)) continue; // blank line
+        if (!(ls >> k.position.x >> k.position.y >> k.position.z >> k.yaw >> k.pitch >> k.fov)) {
+            std::cerr << "[FLY] " << path << ":" << lineNo << ": expected 'time x y z yaw pitch fov [mode]'\n";
+            keys.clear();
+            return false;
+        }
+        std::string mode;
+        if (ls >> mode) {
+            if (mode == "phong" || mode == "0") k.shadingMode = 0;
+            else if (mode == "gouraud" || mode == "1") k.shadingMode = 1;
+            else if (mode == "baked" || mode == "2") k.shadingMode = 2;
+            else {
+                std::cerr << "[FLY] " << path << ":" << lineNo << ": unknown shading mode '" << mode
+                          << "' (phong|gouraud|baked|0|1|2)\n";
+                keys.clear();
+                return false;
+            }
+        } else if (!keys.empty()) {
+            k.shadingMode = keys.back().shadingMode;
+        }
+        if (!keys.empty() && k.time <= keys.back().time) {
+            std::cerr << "[FLY] " << path << ":" << lineNo << ": key times must increase\n";
+            keys.clear();
+            return false;
+        }
+        keys.push_back(k);
+    }
+    return !keys.empty();
+}
+
+bool FlythroughPlayer::sample(double time, CameraSample& out) const {
+    if (keys.empty()) return false;
+    if (time <= keys.front().time || keys.size() == 1) {
+        out = keys.front();
+        out.time = time;
+        return time <= duration();
+    }
+    if (time >= keys.back().time) {
+        out = keys.back();
+        out.time = time;
+        return time <= duration();
+    }
+
+    // first key after `time`
+    size_t i1 = (size_t)(std::upper_bound(keys.begin(), keys.end(), time,
+        [](double t, const CameraSample& k) { return t < k.time; }) - keys.begin());
+    size_t i0 = i1 - 1;
+    const CameraSample& a = keys[i0];
+    const CameraSample& b = keys[i1];
+    float t = (float)((time - a.time) / (b.time - a.time));
+
+    out.time = time;
+    out.shadingMode = a.shadingMode; // a key event: switches at the key, never blended
+    if (spline) {
+        const CameraSample& p = keys[i0 > 0 ? i0 - 1 : i0];
+        const CameraSample& n = keys[i1 + 1 < keys.size() ? i1 + 1 : i1];
+        out.position = catmullRom(p.position, a.position, b.position, n.position, t);
+        out.yaw = catmullRom(p.yaw, a.yaw, b.yaw, n.yaw, t);
+        out.pitch = catmullRom(p.pitch, a.pitch, b.pitch, n.pitch, t);
+        out.fov = catmullRom(p.fov, a.fov, b.fov, n.fov, t);
+    } else {
+        out.position = glm::mix(a.position, b.position, t);
+        out.yaw = a.yaw + (b.yaw - a.yaw) * t;
+        out.pitch = a.pitch + (b.pitch - a.pitch) * t;
+        out.fov = a.fov + (b.fov - a.fov) * t;
+    }
+    out.pitch = glm::clamp(out.pitch, -89.0f, 89.0f);
+    return true;
+}
@@ -0,0 +1,57 @@
+#ifndef FLYTHROUGH_HPP
+#define FLYTHROUGH_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Everything that decides what a frame shows from the user's side.
+struct CameraSample {
+    double time = 0.0;            // seconds since the start of the recording/path
+    glm::vec3 position = glm::vec3(0.0f);
+    float yaw = -90.0f;
+    float pitch = 0.0f;
+    float fov = 45.0f;
+    uint8_t shadingMode = 0;      // application defined (main.cpp: 0 = Phong, 1 = Gouraud, 2 = baked)
+};
+
+glm::vec3 cameraFrontFromYawPitch(float yaw, float pitch);
+
+// Collects one CameraSample per rendered frame and writes them as a compact binary
+// .fly file:
+//   "FLY1" | uint32 sampleCount | sampleCount x { f64 time, f32 pos[3], f32 yaw,
+//   f32 pitch, f32 fov, u8 shadingMode }            (little endian, 33 bytes/sample)
+class FlythroughRecorder {
+public:
+    void record(const CameraSample& sample) { samples.push_back(sample); }
+    size_t sampleCount() const { return samples.size(); }
+    bool save(const std::string& path) const;
+
+private:
+    std::vector<CameraSample> samples;
+};
+
+// Plays back a .fly recording (linear between samples) or an authored spline path
+// (Catmull-Rom through the keys). Time is whatever the caller passes in; for
+// reproducible runs drive it with frameIndex / replayFps, not the wall clock.
+//
+// Path files are text, one key per line, '#' starts a comment:
+//   time  x y z  yaw pitch  fov  [phong|gouraud|baked]
+class FlythroughPlayer {
+public:
+    bool loadRecording(const std::string& path);
+    bool loadPath(const std::string& path);
+
+    // Camera at `time` (clamped to the sequence). Returns false past the end.
+    bool sample(double time, CameraSample& out) const;
+    double duration() const { return keys.empty() ? 0.0 : keys.back().time; }
+    bool empty() const { return keys.empty(); }
+
+private:
+    std::vector<CameraSample> keys;
+    bool spline = false;
+};
+
+#endif
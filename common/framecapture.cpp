@@ -0,0 +1,83 @@
+#include <cstring>
+
+#include "framecapture.hpp"
+
+bool FrameCapture::init(int slotCount, const std::string& owner) {
+    destroy();
+    ownerTag = owner;
+    slots.resize((size_t)(slotCount < 1 ? 1 : slotCount));
+    for (Slot& s : slots) s.pbo.create(ownerTag + "/readback PBO");
+    head = 0;
+    inFlight = 0;
+    return true;
+}
+
+void FrameCapture::destroy() {
+    for (Slot& s : slots) {
+        if (s.fence) glDeleteSync(s.fence);
+        s.pbo.reset();
+    }
+    slots.clear();
+    inFlight = 0;
+}
+
+bool FrameCapture::capture(uint64_t tag, int width, int height) {
+    if (slots.empty() || width <= 0 || height <= 0) return false;
+    if (inFlight == (int)slots.size()) {
+        ++droppedCaptures;
+        return false;
+    }
+    Slot& s = slots[(size_t)head];
+    size_t bytes = (size_t)width * (size_t)height * 4;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo.get());
+    if (bytes > s.capacity) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)bytes, nullptr, GL_STREAM_READ);
+        s.capacity = bytes;
+        gpuResources().setSize(GPU_BUFFER, s.pbo.get(), bytes, "pixel pack");
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    // with a pack buffer bound the last argument is an offset, the call returns at once
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    s.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    s.tag = tag;
+    s.width = width;
+    s.height = height;
+    head = (head + 1) % (int)slots.size();
+    ++inFlight;
+    return true;
+}
+
+bool FrameCapture::poll(CapturedImage& out, bool wait) {
+    if (inFlight == 0) return false;
+    int oldest = (head - inFlight + (int)slots.size()) % (int)slots.size();
+    Slot& s = slots[(size_t)oldest];
+
+    GLenum r = glClientWaitSync(s.fence, 0, 0);
+    if (r == GL_TIMEOUT_EXPIRED) {
+        if (!wait) return false;
+        do {
+            r = glClientWaitSync(s.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        } while (r == GL_TIMEOUT_EXPIRED);
+    }
+    glDeleteSync(s.fence);
+    s.fence = 0;
+    --inFlight;
+
+    size_t bytes = (size_t)s.width * (size_t)s.height * 4;
+    out.tag = s.tag;
+    out.width = s.width;
+    out.height = s.height;
+    out.rgba.resize(bytes);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo.get());
+    void* p = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)bytes, GL_MAP_READ_BIT);
+    bool ok = (p != nullptr);
+    if (ok) {
+        std::memcpy(out.rgba.data(), p, bytes);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return ok;
+}
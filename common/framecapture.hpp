@@ -0,0 +1,62 @@
+#ifndef FRAMECAPTURE_HPP
+#define FRAMECAPTURE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "gpuresources.hpp"
+
+// RGBA8 pixels, rows bottom-up (GL order).
+struct CapturedImage {
+    uint64_t tag = 0;          // caller's id, e.g. the frame number
+    int width = 0, height = 0;
+    std::vector<unsigned char> rgba;
+};
+
+// Asynchronous framebuffer readback through a ring of pixel buffer objects.
+//
+// capture() only queues glReadPixels into a PBO and fences it, so the GL pipeline
+// keeps running; poll() maps a slot once its fence has signalled, normally 2-3 frames
+// later. Nothing ever waits on the GPU unless poll(..., true) is asked to (at exit).
+//
+//   capture.capture(frame, w, h);         // after the frame's draws, before swap
+//   CapturedImage img;
+//   while (capture.poll(img)) use(img);    // every frame
+class FrameCapture {
+public:
+    FrameCapture() {}
+    ~FrameCapture() { destroy(); }
+
+    bool init(int slots = 3, const std::string& owner = "capture");
+    void destroy();
+
+    // Reads the bound read framebuffer. Returns false (capture dropped) when every
+    // slot is still in flight.
+    bool capture(uint64_t tag, int width, int height);
+    // Oldest completed capture, if any. With `wait` blocks until the oldest is ready.
+    bool poll(CapturedImage& out, bool wait = false);
+    int pending() const { return inFlight; }
+    unsigned long long dropped() const { return droppedCaptures; }
+
+private:
+    FrameCapture(const FrameCapture&);
+    FrameCapture& operator=(const FrameCapture&);
+
+    struct Slot {
+        GpuBuffer pbo;
+        size_t capacity = 0;
+        GLsync fence = 0;
+        uint64_t tag = 0;
+        int width = 0, height = 0;
+    };
+    std::vector<Slot> slots;
+    std::string ownerTag;
+    int head = 0;         // next slot to fill
+    int inFlight = 0;     // filled, not yet polled (oldest = head - inFlight)
+    unsigned long long droppedCaptures = 0;
+};
+
+#endif
@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <mmsystem.h>   // timeBeginPeriod, link with -lwinmm
+#endif
+
+#include <GLFW/glfw3.h>
+
+#include "framepacer.hpp"
+
+// Most recent samples kept for the statistics; older frames only count towards totals.
+static const size_t TIMING_WINDOW = 8192;
+
+static double mean(const std::vector<float>& v) {
+    if (v.empty()) return 0.0;
+    double s = 0.0;
+    for (float x : v) s += x;
+    return s / (double)v.size();
+}
+
+static double stddev(const std::vector<float>& v, double m) {
+    if (v.size() < 2) return 0.0;
+    double s = 0.0;
+    for (float x : v) s += (x - m) * (x - m);
+    return std::sqrt(s / (double)(v.size() - 1));
+}
+
+static double percentile(std::vector<float> v, double p) {
+    if (v.empty()) return 0.0;
+    size_t k = (size_t)std::min((double)(v.size() - 1), p * (double)(v.size() - 1) + 0.5);
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+static void pushSample(std::vector<float>& v, float x, unsigned long long index) {
+    if (v.size() < TIMING_WINDOW) v.push_back(x);
+    else v[index % TIMING_WINDOW] = x;
+}
+
+void FramePacer::init(const FramePacerConfig& config) {
+    cfg = config;
+    if (cfg.tickRate <= 0.0) cfg.tickRate = 120.0;
+    if (cfg.maxTicksPerFrame < 1) cfg.maxTicksPerFrame = 1;
+    tickDt = 1.0 / cfg.tickRate;
+    accumulator = 0.0;
+    started = false;
+    frames = missed = droppedTicks = 0;
+    frameTimesMs.clear();
+    cpuTimesMs.clear();
+    frameTimesMs.reserve(TIMING_WINDOW);
+    cpuTimesMs.reserve(TIMING_WINDOW);
+    deadlineSec = (cfg.fpsCap > 0.0) ? 1.0 / cfg.fpsCap : 0.0;
+
+#ifdef _WIN32
+    // default scheduler granularity is ~15.6 ms, far too coarse for a frame cap
+    if (!timerPeriodSet) timeBeginPeriod(1);
+#endif
+    timerPeriodSet = true;
+}
+
+void FramePacer::shutdown() {
+    if (!timerPeriodSet) return;
+#ifdef _WIN32
+    timeEndPeriod(1); // the resolution is system-wide: every begin needs its end
+#endif
+    timerPeriodSet = false;
+}
+
+void FramePacer::applyVsync(double monitorRefreshHz) {
+    int interval = 0;
+    if (cfg.vsync == VSYNC_ON) {
+        interval = 1;
+    } else if (cfg.vsync == VSYNC_ADAPTIVE) {
+        if (glfwExtensionSupported("WGL_EXT_swap_control_tear") ||
+            glfwExtensionSupported("GLX_EXT_swap_control_tear")) {
+            interval = -1;
+        } else {
+            std::cerr << "[PACER] adaptive vsync not supported, falling back to vsync on\n";
+            interval = 1;
+        }
+    }
+    glfwSwapInterval(interval);
+
+    // With vsync the refresh interval is the deadline unless a lower cap was asked for.
+    if (interval != 0 && monitorRefreshHz > 0.0) {
+        double vsyncDeadline = 1.0 / monitorRefreshHz;
+        deadlineSec = std::max(deadlineSec, vsyncDeadline);
+    }
+}
+
+double FramePacer::secondsSince(Clock::time_point t) const {
+    return std::chrono::duration<double>(Clock::now() - t).count();
+}
+
+void FramePacer::waitUntil(Clock::time_point deadline) const {
+    // Sleep for the bulk of the wait (frees the core), spin for the tail (precision).
+    std::chrono::duration<double> margin(cfg.spinMarginMs / 1000.0);
+    Clock::time_point sleepUntil = deadline - std::chrono::duration_cast<Clock::duration>(margin);
+    if (Clock::now() < sleepUntil) std::this_thread::sleep_until(sleepUntil);
+    while (Clock::now() < deadline) std::this_thread::yield();
+}
+
+int FramePacer::beginFrame() {
+    Clock::time_point now = Clock::now();
+    double elapsed;
+    if (!started) {
+        started = true;
+        elapsed = tickDt;
+        nextFrameDeadline = now;
+    } else {
+        elapsed = std::chrono::duration<double>(now - frameStart).count();
+        pushSample(frameTimesMs, (float)(elapsed * 1000.0), frames);
+        if (deadlineSec > 0.0 && elapsed > deadlineSec * 1.2) ++missed;
+        ++frames;
+    }
+    frameStart = now;
+
+    accumulator += elapsed;
+    int ticks = (int)(accumulator / tickDt);
+    if (ticks > cfg.maxTicksPerFrame) {
+        droppedTicks += (unsigned long long)(ticks - cfg.maxTicksPerFrame);
+        ticks = cfg.maxTicksPerFrame;
+        accumulator = tickDt * ticks;
+    }
+    accumulator -= tickDt * ticks;
+    return ticks;
+}
+
+void FramePacer::markSubmitted(double waitedMs) {
+    lastCpuTimeMs = std::max(0.0, secondsSince(frameStart) * 1000.0 - waitedMs);
+    pushSample(cpuTimesMs, (float)lastCpuTimeMs, frames);
+    submitted = true;
+}
+
+void FramePacer::endFrame() {
+    if (!submitted) {
+        lastCpuTimeMs = secondsSince(frameStart) * 1000.0;
+        pushSample(cpuTimesMs, (float)lastCpuTimeMs, frames);
+    }
+    submitted = false;
+
+    if (cfg.fpsCap <= 0.0) return;
+    std::chrono::duration<double> capInterval(1.0 / cfg.fpsCap);
+    nextFrameDeadline += std::chrono::duration_cast<Clock::duration>(capInterval);
+    // If we already fell behind, restart the schedule instead of bursting to catch up.
+    if (nextFrameDeadline < Clock::now()) {
+        nextFrameDeadline = Clock::now();
+        return;
+    }
+    waitUntil(nextFrameDeadline);
+}
+
+void FramePacer::report(std::ostream& os) const {
+    double frameMean = mean(frameTimesMs);
+    double cpuMean = mean(cpuTimesMs);
+    os << "---- frame timing (" << frames << " frames, last " << frameTimesMs.size() << " sampled) ----\n";
+    os << "  tick rate      : " << cfg.tickRate << " Hz";
+    if (droppedTicks) os << " (" << droppedTicks << " ticks dropped after stalls)";
+    os << "\n";
+    os << "  frame time     : mean " << frameMean << " ms"
+       << ", p50 " << percentile(frameTimesMs, 0.50)
+       << ", p99 " << percentile(frameTimesMs, 0.99)
+       << ", max " << percentile(frameTimesMs, 1.0) << " ms\n";
+    os << "  jitter (stddev): " << stddev(frameTimesMs, frameMean) << " ms\n";
+    os << "  cpu time       : mean " << cpuMean << " ms, p99 " << percentile(cpuTimesMs, 0.99) << " ms\n";
+    if (frameMean > 0.0) os << "  average fps    : " << 1000.0 / frameMean << "\n";
+    if (deadlineSec > 0.0) {
+        os << "  deadline       : " << deadlineSec * 1000.0 << " ms, missed " << missed;
+        if (frames) os << " (" << 100.0 * (double)missed / (double)frames << "%)";
+        os << "\n";
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef FRAMEPACER_HPP
+#define FRAMEPACER_HPP
+
+#include <chrono>
+#include <ostream>
+#include <vector>
+
+// Swap interval requested from the driver.
+// Adaptive = sync when on time, tear when late (needs *_EXT_swap_control_tear).
+enum VsyncMode {
+    VSYNC_OFF = 0,
+    VSYNC_ON,
+    VSYNC_ADAPTIVE
+};
+
+struct FramePacerConfig {
+    double tickRate = 120.0;     // fixed simulation ticks per second
+    double fpsCap = 0.0;         // 0 = uncapped (vsync/swap decides)
+    VsyncMode vsync = VSYNC_ON;
+    int maxTicksPerFrame = 8;    // avoid the spiral of death after a long stall
+    double spinMarginMs = 1.5;   // last part of the cap wait is spun, not slept
+};
+
+// Fixed-timestep driver with a sleep+spin frame cap and per-frame timing log.
+//
+//   int ticks = pacer.beginFrame();
+//   for (int i = 0; i < ticks; ++i) simulate(pacer.tickDelta());
+//   render(pacer.alpha());               // blend previous/current sim state
+//   swap();
+//   pacer.endFrame();                    // waits for the frame cap, records timing
+class FramePacer {
+public:
+    FramePacer() {}
+    ~FramePacer() { shutdown(); }
+
+    void init(const FramePacerConfig& config);
+    // Gives back the 1 ms timer resolution init() asked for (Windows); init() again to reuse.
+    void shutdown();
+
+    // Sets the swap interval on the current context. Call after the context is current.
+    void applyVsync(double monitorRefreshHz);
+
+    int beginFrame();
+    // The frame's work is submitted (call right before the swap): its CPU time is taken
+    // here, less `waitedMs` spent blocked on the GPU (fence waits), so swap/vsync and
+    // GPU back-pressure don't count as CPU work. Without it endFrame() takes the time.
+    void markSubmitted(double waitedMs = 0.0);
+    void endFrame();
+
+    // The loop blocked (e.g. waiting for events while idle): restart the clock so the
+    // wait is neither recorded as a frame nor replayed as simulation ticks.
+    void resetClock() { started = false; accumulator = 0.0; }
+
+    double tickDelta() const { return tickDt; }
+    float alpha() const { return (float)(accumulator / tickDt); }
+    unsigned long long frameCount() const { return frames; }
+    // Frame budget from the cap or the refresh rate (0 = neither known), and the CPU
+    // time of the last finished frame (see markSubmitted).
+    double deadlineMs() const { return deadlineSec * 1000.0; }
+    double lastCpuMs() const { return lastCpuTimeMs; }
+
+    // Mean / jitter / percentiles over the recent window, missed deadlines over the run.
+    void report(std::ostream& os) const;
+
+private:
+    FramePacer(const FramePacer&);
+    FramePacer& operator=(const FramePacer&);
+
+    typedef std::chrono::steady_clock Clock;
+
+    double secondsSince(Clock::time_point t) const;
+    void waitUntil(Clock::time_point deadline) const;
+
+    FramePacerConfig cfg;
+    double tickDt = 1.0 / 120.0;
+    double accumulator = 0.0;
+    double deadlineSec = 0.0;   // 0 = no deadline known, only jitter is reported
+    bool started = false;
+    bool timerPeriodSet = false; // timeBeginPeriod(1) is active
+
+    Clock::time_point frameStart;
+    Clock::time_point nextFrameDeadline;
+
+    unsigned long long frames = 0;
+    unsigned long long missed = 0;
+    unsigned long long droppedTicks = 0;
+    double lastCpuTimeMs = 0.0;
+    bool submitted = false;           // markSubmitted() already took this frame's CPU time
+    std::vector<float> frameTimesMs;  // frame-to-frame interval
+    std::vector<float> cpuTimesMs;    // beginFrame -> markSubmitted less GPU waits (or -> endFrame)
+};
+
+#endif
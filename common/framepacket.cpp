@@ -0,0 +1,388 @@
+#include <algorithm>
+#include <cstring>
+
+#include <glad/glad.h>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "jobsystem.hpp"
+#include "ringbuffer.hpp"
+#include "scenestore.hpp"
+#include "framepacket.hpp"
+
+namespace {
+
+struct Frustum {
+    glm::vec4 planes[6];
+};
+
+// Gribb/Hartmann plane extraction; planes point inwards.
+Frustum extractFrustum(const glm::mat4& viewProj) {
+    Frustum f;
+    glm::vec4 row0(viewProj[0][0], viewProj[1][0], viewProj[2][0], viewProj[3][0]);
+    glm::vec4 row1(viewProj[0][1], viewProj[1][1], viewProj[2][1], viewProj[3][1]);
+    glm::vec4 row2(viewProj[0][2], viewProj[1][2], viewProj[2][2], viewProj[3][2]);
+    glm::vec4 row3(viewProj[0][3], viewProj[1][3], viewProj[2][3], viewProj[3][3]);
+    f.planes[0] = row3 + row0;
+    f.planes[1] = row3 - row0;
+    f.planes[2] = row3 + row1;
+    f.planes[3] = row3 - row1;
+    f.planes[4] = row3 + row2;
+    f.planes[5] = row3 - row2;
+    return f;
+}
+
+bool aabbVisible(const Frustum& f, const glm::vec3& mn, const glm::vec3& mx) {
+    for (int i = 0; i < 6; ++i) {
+        const glm::vec4& p = f.planes[i];
+        // corner furthest along the plane normal
+        glm::vec3 v(p.x >= 0.0f ? mx.x : mn.x,
+                    p.y >= 0.0f ? mx.y : mn.y,
+                    p.z >= 0.0f ? mx.z : mn.z);
+        if (p.x * v.x + p.y * v.y + p.z * v.z + p.w < 0.0f) return false;
+    }
+    return true;
+}
+
+const uint64_t CULLED = ~(uint64_t)0;
+const uint64_t NOT_DRAWABLE = ~(uint64_t)1;
+const uint64_t FIXTURE = ~(uint64_t)2;
+
+// DRAW_ORDER_STATE: state first (texture, then VAO), front-to-back inside a state bucket.
+// DRAW_ORDER_FRONT_TO_BACK: depth first, state only breaks ties.
+uint64_t makeSortKey(DrawOrder order, const Material& mat, const MeshGPU& mesh, float viewDepth) {
+    uint32_t depthBits;
+    float d = std::max(viewDepth, 0.0f);
+    std::memcpy(&depthBits, &d, sizeof(d)); // non-negative floats order like their bits
+    uint64_t tex = mat.hasTexture ? (uint64_t)(mat.texture & 0x7FFF) + 1 : 0;
+    uint64_t state = (tex << 16) | (uint64_t)(mesh.vao & 0xFFFF);
+    if (order == DRAW_ORDER_FRONT_TO_BACK) return ((uint64_t)depthBits << 32) | state;
+    return (state << 32) | depthBits;
+}
+
+const Material defaultMaterial = Material();
+
+} // namespace
+
+void buildFramePacket(JobSystem& jobs, const SceneSnapshot& snapshot, FramePacket& out) {
+    out.snapshot = snapshot;
+    out.items.clear();
+    out.lights.clear();
+    out.frameLights.clear();
+    out.fixtures.clear();
+    out.fixtureCount = 0;
+    out.fixturesLit = 0;
+    out.culled = 0;
+    out.lightRefs = 0;
+    out.lightsDropped = 0;
+    out.valid = true;
+    if (!snapshot.scene) return;
+
+    const SceneStore& scene = *snapshot.scene;
+    const size_t n = scene.nodeCount();
+    const Frustum frustum = extractFrustum(snapshot.projection * snapshot.view);
+    const glm::vec3 eye = snapshot.cameraPos;
+    const glm::vec3 forward = snapshot.cameraFront;
+    const bool emissiveFixtures = snapshot.emissiveProgram != 0;
+
+    auto litKey = [&](size_t i) {
+        uint32_t mat = scene.material[i];
+        glm::vec3 center = 0.5f * (scene.boundsMin[i] + scene.boundsMax[i]);
+        return makeSortKey(snapshot.order, mat != SCENE_NONE ? scene.materials[mat] : defaultMaterial,
+                           scene.meshes[scene.mesh[i]], glm::dot(center - eye, forward));
+    };
+
+    std::vector<uint64_t> keys(n);
+    jobs.parallelFor(n, 256, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t m = scene.mesh[i];
+            if (m == SCENE_NONE || scene.meshes[m].indexCount == 0) {
+                keys[i] = NOT_DRAWABLE;
+                continue;
+            }
+            if (!aabbVisible(frustum, scene.boundsMin[i], scene.boundsMax[i])) {
+                keys[i] = CULLED;
+                continue;
+            }
+            if (emissiveFixtures && scene.light[i] != SCENE_NONE) {
+                keys[i] = FIXTURE;
+                continue;
+            }
+            keys[i] = litKey(i);
+        }
+    });
+
+    // visible fixtures, as (batch, node): batches are few (one per fixture mesh and size)
+    std::vector<std::pair<uint32_t, uint32_t>> fixtureNodes;
+    out.items.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        if (keys[i] == NOT_DRAWABLE) continue;
+        if (keys[i] == CULLED) { ++out.culled; continue; }
+        if (keys[i] == FIXTURE) {
+            glm::mat4 basis = scene.world[i];
+            basis[3] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+            uint32_t b = 0;
+            while (b < out.fixtures.size() && (out.fixtures[b].mesh != scene.mesh[i] || out.fixtures[b].basis != basis)) ++b;
+            if (b == out.fixtures.size()) {
+                FixtureBatch batch;
+                batch.mesh = scene.mesh[i];
+                batch.basis = basis;
+                out.fixtures.push_back(batch);
+            }
+            fixtureNodes.push_back(std::make_pair(b, (uint32_t)i));
+            continue;
+        }
+        DrawItem item;
+        item.sortKey = keys[i];
+        item.node = (uint32_t)i;
+        out.items.push_back(item);
+    }
+    std::sort(out.items.begin(), out.items.end(),
+              [](const DrawItem& a, const DrawItem& b) { return a.sortKey < b.sortKey; });
+
+    // per-draw light lists: light spheres vs the draw's world bounds
+    out.lights.resize(out.items.size());
+    jobs.parallelFor(out.items.size(), 64, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t node = out.items[i].node;
+            DrawLightList& l = out.lights[i];
+            l.count = gatherDrawLights(scene, scene.boundsMin[node], scene.boundsMax[node], l.index);
+        }
+    });
+
+    // Visible fixtures' lights take the first slots of the frame's table, contiguous per
+    // batch, so a batch's instances index the table directly. The lit draws' lights come
+    // first, though: while those and the fixtures' would not fit, the last fixture gives
+    // up its slot and is drawn lit, so bulbs can't crowd the lights of the room they hang
+    // in out of the table. Past that a fixture is only drawn lit if its own light list
+    // costs fewer slots than its instance frees. Counts per light keep both sizes exact:
+    // coreLights = lit draws' + instanced fixtures', tableLights = + the lit fixtures'.
+    std::vector<uint32_t> litRefs(scene.lightCount(), 0), fixtureRefs(scene.lightCount(), 0),
+        litFixtureRefs(scene.lightCount(), 0);
+    long coreLights = 0, tableLights = 0;
+    auto countRef = [&](std::vector<uint32_t>& refs, uint32_t light, int delta) {
+        int coreBefore = litRefs[light] || fixtureRefs[light];
+        int tableBefore = coreBefore || litFixtureRefs[light];
+        refs[light] += delta;
+        int coreAfter = litRefs[light] || fixtureRefs[light];
+        coreLights += coreAfter - coreBefore;
+        tableLights += (coreAfter || litFixtureRefs[light]) - tableBefore;
+    };
+    for (const DrawLightList& l : out.lights) {
+        for (int k = 0; k < l.count; ++k) countRef(litRefs, l.index[k], 1);
+    }
+    std::sort(fixtureNodes.begin(), fixtureNodes.end());
+    size_t kept = 0;
+    for (const std::pair<uint32_t, uint32_t>& f : fixtureNodes) {
+        uint32_t light = scene.light[f.second];
+        if (fixtureRefs[light]) continue; // another node of the same light has the instance
+        countRef(fixtureRefs, light, 1);
+        fixtureNodes[kept++] = f;
+    }
+    fixtureNodes.resize(kept);
+    std::vector<std::pair<DrawItem, DrawLightList>> litFixtures;
+    for (size_t f = fixtureNodes.size(); f-- > 0 && tableLights > (long)MAX_FRAME_LIGHTS;) {
+        uint32_t node = fixtureNodes[f].second;
+        uint32_t light = scene.light[node];
+        // lit by the lights around it, not by the one inside it: that one would just
+        // take back the slot being given up
+        DrawLightList l;
+        int gathered = gatherDrawLights(scene, scene.boundsMin[node], scene.boundsMax[node], l.index);
+        int added = 0;
+        for (int k = 0; k < gathered; ++k) {
+            uint32_t other = l.index[k];
+            if (other == light) continue;
+            l.index[l.count++] = other;
+            if (!litRefs[other] && !fixtureRefs[other] && !litFixtureRefs[other]) ++added;
+        }
+        int freed = fixtureRefs[light] == 1 && !litRefs[light] && !litFixtureRefs[light];
+        if (coreLights <= (long)MAX_FRAME_LIGHTS && added >= freed) continue;
+        countRef(fixtureRefs, light, -1);
+        for (int k = 0; k < l.count; ++k) countRef(litFixtureRefs, l.index[k], 1);
+        DrawItem item;
+        item.sortKey = litKey(node);
+        item.node = node;
+        litFixtures.push_back(std::make_pair(item, l));
+        fixtureNodes[f].second = SCENE_NONE;
+    }
+    fixtureNodes.erase(std::remove_if(fixtureNodes.begin(), fixtureNodes.end(),
+                                      [](const std::pair<uint32_t, uint32_t>& f) { return f.second == SCENE_NONE; }),
+                       fixtureNodes.end());
+    out.lightSlot.assign(scene.lightCount(), -1);
+    for (const std::pair<uint32_t, uint32_t>& f : fixtureNodes) {
+        uint32_t light = scene.light[f.second];
+        FixtureBatch& batch = out.fixtures[f.first];
+        if (!batch.count) batch.firstSlot = (uint32_t)out.frameLights.size();
+        out.lightSlot[light] = (int32_t)out.frameLights.size();
+        out.frameLights.push_back(light);
+        ++batch.count;
+        ++out.fixtureCount;
+    }
+    out.fixtures.erase(std::remove_if(out.fixtures.begin(), out.fixtures.end(),
+                                      [](const FixtureBatch& b) { return b.count == 0; }),
+                       out.fixtures.end());
+    if (!litFixtures.empty()) {
+        // merged into the sorted lit draws
+        std::sort(litFixtures.begin(), litFixtures.end(),
+                  [](const std::pair<DrawItem, DrawLightList>& a, const std::pair<DrawItem, DrawLightList>& b) {
+                      return a.first.sortKey < b.first.sortKey;
+                  });
+        std::vector<DrawItem> items;
+        std::vector<DrawLightList> lights;
+        items.reserve(out.items.size() + litFixtures.size());
+        lights.reserve(items.capacity());
+        size_t a = 0, b = 0;
+        while (a < out.items.size() || b < litFixtures.size()) {
+            if (b == litFixtures.size() || (a < out.items.size() && out.items[a].sortKey <= litFixtures[b].first.sortKey)) {
+                items.push_back(out.items[a]);
+                lights.push_back(out.lights[a++]);
+                continue;
+            }
+            items.push_back(litFixtures[b].first);
+            lights.push_back(litFixtures[b++].second);
+        }
+        out.items.swap(items);
+        out.lights.swap(lights);
+        out.fixturesLit = litFixtures.size();
+    }
+
+    // Pack the other lights in use into the table (first come, first served in draw
+    // order, the lit fixtures' after everyone else's) and turn each list into table
+    // slots. Draws past a full table lose lights.
+    for (int pass = 0; pass < 2; ++pass) {
+        for (size_t i = 0; i < out.lights.size(); ++i) {
+            bool litFixture = emissiveFixtures && scene.light[out.items[i].node] != SCENE_NONE;
+            if (litFixture != (pass == 1)) continue;
+            DrawLightList& l = out.lights[i];
+            int kept = 0;
+            for (int k = 0; k < l.count; ++k) {
+                int32_t& slot = out.lightSlot[l.index[k]];
+                if (slot < 0) {
+                    if (out.frameLights.size() >= (size_t)MAX_FRAME_LIGHTS) { ++out.lightsDropped; continue; }
+                    slot = (int32_t)out.frameLights.size();
+                    out.frameLights.push_back(l.index[k]);
+                }
+                l.index[kept++] = (uint32_t)slot;
+            }
+            l.count = kept;
+            out.lightRefs += (size_t)kept;
+        }
+    }
+}
+
+void submitFramePacket(FramePacket& packet, RingBuffer& perDrawRing) {
+    const SceneSnapshot& snap = packet.snapshot;
+    if (!snap.scene || !snap.program) return;
+    const SceneStore& scene = *snap.scene;
+    GLuint prog = snap.program;
+
+    glUniformMatrix4fv(glGetUniformLocation(prog, "projection"), 1, GL_FALSE, glm::value_ptr(snap.projection));
+    glUniformMatrix4fv(glGetUniformLocation(prog, "view"), 1, GL_FALSE, glm::value_ptr(snap.view));
+    glUniform3fv(glGetUniformLocation(prog, "viewPos"), 1, &snap.cameraPos[0]);
+
+    const size_t uboAlign = perDrawRing.bindAlignment();
+    const size_t stride = (sizeof(PerDrawConstants) + uboAlign - 1) / uboAlign * uboAlign;
+
+    // Pass 1: stream all per-draw constants (the ring may have to be unmapped before drawing)
+    std::vector<size_t>& offsets = packet.perDrawOffsets;
+    offsets.resize(packet.items.size());
+    perDrawRing.ensureCapacity(stride * packet.items.size());
+    perDrawRing.beginFrame();
+    for (size_t i = 0; i < packet.items.size(); ++i) {
+        uint32_t node = packet.items[i].node;
+        uint32_t mat = scene.material[node];
+        const Material& m = (mat != SCENE_NONE) ? scene.materials[mat] : defaultMaterial;
+        PerDrawConstants* c = (PerDrawConstants*)perDrawRing.allocate(sizeof(PerDrawConstants), uboAlign, offsets[i]);
+        if (!c) { offsets[i] = (size_t)-1; continue; }
+        c->model = scene.world[node];
+        c->normalMatrix = scene.normalMatrix[node];
+        c->colorAndTexture = glm::vec4(m.color, m.hasTexture ? 1.0f : 0.0f);
+        c->uvScale = glm::vec4(m.uvScale, 0.0f, 0.0f);
+        const DrawLightList& lights = packet.lights[i];
+        c->lightCount = glm::ivec4(lights.count, 0, 0, 0);
+        for (int k = 0; k < MAX_DRAW_LIGHTS; ++k) {
+            c->lightIndex[k / 4][k % 4] = k < lights.count ? (int)lights.index[k] : 0;
+        }
+        c->lightmapScaleOffset = scene.lightmapScaleOffset[node];
+    }
+    perDrawRing.flush();
+
+    // Depth pre-pass: positions only, no fragment work, colour writes off. The lit pass
+    // then only passes fragments whose depth equals the nearest one; both programs
+    // compute an invariant gl_Position, so the depths match exactly.
+    if (snap.depthProgram) {
+        glUseProgram(snap.depthProgram);
+        glUniformMatrix4fv(glGetUniformLocation(snap.depthProgram, "projection"), 1, GL_FALSE, glm::value_ptr(snap.projection));
+        glUniformMatrix4fv(glGetUniformLocation(snap.depthProgram, "view"), 1, GL_FALSE, glm::value_ptr(snap.view));
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        GLuint boundVAO = 0;
+        for (size_t i = 0; i < packet.items.size(); ++i) {
+            if (offsets[i] == (size_t)-1) continue;
+            const MeshGPU& mesh = scene.meshes[scene.mesh[packet.items[i].node]];
+            GLuint vao = mesh.depthVao ? mesh.depthVao : mesh.vao;
+            if (vao != boundVAO) {
+                glBindVertexArray(vao);
+                boundVAO = vao;
+            }
+            glBindBufferRange(GL_UNIFORM_BUFFER, PER_DRAW_BINDING, perDrawRing.buffer(),
+                              (GLintptr)offsets[i], sizeof(PerDrawConstants));
+            glDrawElements(GL_TRIANGLES, (GLsizei)mesh.indexCount, GL_UNSIGNED_INT,
+                           (void*)(size_t)(mesh.firstIndex * sizeof(unsigned int)));
+        }
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDepthFunc(GL_EQUAL);
+        glDepthMask(GL_FALSE);
+        glUseProgram(prog);
+    }
+
+    // Pass 2: draws; state-sorted items only rebind when the state actually changes
+    GLuint boundVAO = 0, boundTex = 0;
+    glActiveTexture(GL_TEXTURE0);
+    for (size_t i = 0; i < packet.items.size(); ++i) {
+        if (offsets[i] == (size_t)-1) continue;
+        uint32_t node = packet.items[i].node;
+        const MeshGPU& mesh = scene.meshes[scene.mesh[node]];
+        uint32_t mat = scene.material[node];
+        const Material& m = (mat != SCENE_NONE) ? scene.materials[mat] : defaultMaterial;
+        if (mesh.vao != boundVAO) {
+            glBindVertexArray(mesh.vao);
+            boundVAO = mesh.vao;
+        }
+        if (m.hasTexture && m.texture && m.texture != boundTex) {
+            glBindTexture(GL_TEXTURE_2D, m.texture);
+            boundTex = m.texture;
+        }
+        glBindBufferRange(GL_UNIFORM_BUFFER, PER_DRAW_BINDING, perDrawRing.buffer(),
+                          (GLintptr)offsets[i], sizeof(PerDrawConstants));
+        glDrawElements(GL_TRIANGLES, (GLsizei)mesh.indexCount, GL_UNSIGNED_INT,
+                       (void*)(size_t)(mesh.firstIndex * sizeof(unsigned int)));
+    }
+    if (snap.depthProgram) {
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
+    }
+
+    // Light fixtures: unlit, one instanced draw per batch, no per-fixture constants. The
+    // shader reads each instance's position and colour from the frame's Lights block.
+    if (snap.emissiveProgram && !packet.fixtures.empty()) {
+        GLuint emissive = snap.emissiveProgram;
+        glUseProgram(emissive);
+        glUniformMatrix4fv(glGetUniformLocation(emissive, "projection"), 1, GL_FALSE, glm::value_ptr(snap.projection));
+        glUniformMatrix4fv(glGetUniformLocation(emissive, "view"), 1, GL_FALSE, glm::value_ptr(snap.view));
+        const GLint basisLoc = glGetUniformLocation(emissive, "fixtureBasis");
+        const GLint firstLoc = glGetUniformLocation(emissive, "firstLight");
+        for (const FixtureBatch& batch : packet.fixtures) {
+            const MeshGPU& mesh = scene.meshes[batch.mesh];
+            if (mesh.vao != boundVAO) {
+                glBindVertexArray(mesh.vao);
+                boundVAO = mesh.vao;
+            }
+            glUniformMatrix4fv(basisLoc, 1, GL_FALSE, glm::value_ptr(batch.basis));
+            glUniform1i(firstLoc, (GLint)batch.firstSlot);
+            glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)mesh.indexCount, GL_UNSIGNED_INT,
+                                    (void*)(size_t)(mesh.firstIndex * sizeof(unsigned int)), (GLsizei)batch.count);
+        }
+        glUseProgram(prog);
+    }
+    glBindVertexArray(0);
+    perDrawRing.endFrame();
+}
@@ -0,0 +1,107 @@
+#ifndef FRAMEPACKET_HPP
+#define FRAMEPACKET_HPP
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "lightculling.hpp"
+
+class JobSystem;
+class RingBuffer;
+class SceneStore;
+
+// std140 layout of the shaders' PerDraw uniform block, streamed through a RingBuffer.
+struct PerDrawConstants {
+    glm::mat4 model;
+    glm::mat4 normalMatrix;
+    glm::vec4 colorAndTexture;  // rgb = objectColor, a = hasTexture
+    glm::vec4 uvScale;          // xy used
+    glm::ivec4 lightCount;      // x = lights affecting this draw
+    glm::ivec4 lightIndex[MAX_DRAW_LIGHTS / 4]; // slots of the frame's Lights block, 4 per ivec4
+    glm::vec4 lightmapScaleOffset;  // this instance's atlas rectangle, zero if not lightmapped
+};
+const unsigned int PER_DRAW_BINDING = 0;
+
+// How buildFramePacket orders the (all opaque) draws.
+enum DrawOrder {
+    DRAW_ORDER_STATE,          // texture, then VAO, front-to-back inside a state bucket: fewest binds
+    DRAW_ORDER_FRONT_TO_BACK   // nearest first over the whole list: most fragments rejected by early depth
+};
+
+// Immutable input of one frame's draw list: camera plus the scene it looks at.
+struct SceneSnapshot {
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    glm::vec3 cameraPos = glm::vec3(0.0f);
+    glm::vec3 cameraFront = glm::vec3(0.0f, 0.0f, -1.0f);
+    float fov = 45.0f;
+    unsigned int program = 0;
+    bool baked = false;        // program samples the lightmap and probes (the caller binds them)
+    DrawOrder order = DRAW_ORDER_STATE;
+    // Depth-only program: when set, the draws are first laid down in depth with
+    // MeshGPU::depthVao and colour writes off, then shaded with GL_EQUAL, so every
+    // visible pixel runs the lighting shader exactly once.
+    unsigned int depthProgram = 0;
+    // Unlit program for light fixtures: when set, mesh nodes carrying a light leave the
+    // lit draw list and are drawn instanced, placed and coloured by their Lights slot.
+    unsigned int emissiveProgram = 0;
+    // Published copy of the scene; replaced (never mutated) when the scene changes.
+    std::shared_ptr<const SceneStore> scene;
+};
+
+struct DrawItem {
+    uint64_t sortKey;
+    uint32_t node;     // node id in the snapshot's scene
+};
+
+// Lights whose effective radius reaches a draw's bounds, strongest first, as slots of
+// the packet's frameLights.
+struct DrawLightList {
+    uint32_t index[MAX_DRAW_LIGHTS];
+    int count = 0;
+};
+
+// Visible light fixtures sharing a mesh and world orientation/scale: one instanced
+// draw whose instance i is the light in Lights slot firstSlot + i.
+struct FixtureBatch {
+    uint32_t mesh;
+    glm::mat4 basis;     // the fixtures' world matrix without its translation
+    uint32_t firstSlot = 0;
+    uint32_t count = 0;
+};
+
+// Output of the build step: what the GL thread submits for one frame.
+struct FramePacket {
+    SceneSnapshot snapshot;
+    std::vector<DrawItem> items;   // culled and sorted
+    std::vector<DrawLightList> lights; // parallel to items
+    std::vector<uint32_t> frameLights; // scene light id of each Lights block slot
+    std::vector<FixtureBatch> fixtures; // with the snapshot's emissiveProgram only
+    size_t fixtureCount = 0;       // sum of fixtures[i].count
+    size_t fixturesLit = 0;        // visible fixtures without a free light slot, in items instead
+    size_t culled = 0;
+    size_t lightRefs = 0;          // sum of lights[i].count
+    size_t lightsDropped = 0;      // draw->light references over MAX_FRAME_LIGHTS
+    std::vector<int32_t> lightSlot; // scratch: scene light id -> slot, -1 = unused
+    std::vector<size_t> perDrawOffsets; // scratch of submitFramePacket: ring offset per item, -1 = ring full
+    bool valid = false;
+};
+
+// Frustum-culls and sorts the snapshot's mesh nodes on the job system, then assigns each
+// surviving draw the lights that reach it and packs the lights in use into the frame's
+// light table: visible fixtures' lights first, in the slots the lit draws' lights leave
+// free (fixtures past those are drawn as lit items). Safe to run on a worker thread while
+// the GL thread submits another packet.
+void buildFramePacket(JobSystem& jobs, const SceneSnapshot& snapshot, FramePacket& out);
+
+// GL thread only: writes every item's PerDrawConstants into the ring, then binds
+// state and issues the draws of a built packet (twice with a depth pre-pass), then the
+// fixture batches with the emissive program. Expects
+// the snapshot's program in use, depth test on with GL_LESS and depth writes on, and
+// leaves them so.
+void submitFramePacket(FramePacket& packet, RingBuffer& perDrawRing);
+
+#endif
@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <utility>
+
+#include "goldenimage.hpp"
+#include "framerecorder.hpp"
+
+namespace {
+const size_t WRITE_CHUNK = 8 * 1024 * 1024; // encoder output is written in chunks this large
+}
+
+bool FrameRecorder::start(const FrameRecorderConfig& config, int width, int height) {
+    stop();
+    cfg = config;
+    cfg.queueDepth = std::max(2, cfg.queueDepth);
+    videoWidth = width & ~1;   // I420 needs even dimensions
+    videoHeight = height & ~1;
+
+    if (cfg.format == CAPTURE_Y4M) {
+        file = std::fopen(cfg.output.c_str(), "wb");
+        if (!file) {
+            std::cerr << "[CAPTURE] cannot write " << cfg.output << "\n";
+            return false;
+        }
+        char header[128];
+        int n = std::snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F%d:1000 Ip A1:1 C420jpeg\n",
+                              videoWidth, videoHeight, (int)(cfg.fps * 1000.0 + 0.5));
+        writeBuffer.reserve(WRITE_CHUNK);
+        writeBytes(header, (size_t)n);
+    }
+
+    readback.init(4, "recording");
+    freeFrames.assign((size_t)cfg.queueDepth, CapturedImage());
+    for (CapturedImage& f : freeFrames) f.rgba.reserve((size_t)width * (size_t)height * 4);
+    queue.clear();
+    framesWritten = droppedQueueFull = bytesWritten = 0;
+    encodeMs = 0.0;
+    quit = false;
+    running = true;
+    encoder = std::thread(&FrameRecorder::encoderLoop, this);
+    return true;
+}
+
+void FrameRecorder::captureFrame(unsigned long long frame, int width, int height) {
+    if (!running) return;
+    while (readback.poll(staging)) handOff(staging);
+    readback.capture(frame, width, height);
+}
+
+void FrameRecorder::handOff(CapturedImage& image) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (freeFrames.empty()) {
+            ++droppedQueueFull; // encoder is behind; never wait for it here
+            return;
+        }
+        CapturedImage slot = std::move(freeFrames.back());
+        freeFrames.pop_back();
+        std::swap(slot, image);  // hand the filled buffer over, keep the recycled one for poll()
+        queue.push_back(std::move(slot));
+    }
+    frameQueued.notify_one();
+}
+
+void FrameRecorder::stop() {
+    if (!running) return;
+    while (readback.poll(staging, true)) handOff(staging);
+    readback.destroy();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    frameQueued.notify_all();
+    encoder.join();
+    flushWrites();
+    if (file) std::fclose(file);
+    file = nullptr;
+    running = false;
+}
+
+void FrameRecorder::encoderLoop() {
+    for (;;) {
+        CapturedImage image;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            frameQueued.wait(lock, [this] { return quit || !queue.empty(); });
+            if (queue.empty()) return; // quit and drained
+            image = std::move(queue.front());
+            queue.pop_front();
+        }
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        encode(image);
+        encodeMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            freeFrames.push_back(std::move(image));
+        }
+    }
+}
+
+void FrameRecorder::encode(const CapturedImage& image) {
+    if (cfg.format == CAPTURE_BMP_SEQUENCE) {
+        char name[64];
+        std::snprintf(name, sizeof(name), "/frame_%05llu.bmp", (unsigned long long)image.tag);
+        if (writeBMP(cfg.output + name, image)) {
+            ++framesWritten;
+            bytesWritten += 54 + (((size_t)image.width * 3 + 3) & ~(size_t)3) * (size_t)image.height;
+        }
+        return;
+    }
+
+    // Y4M: BT.601 I420, rows top-down (the capture is bottom-up); odd edge rows/cols dropped
+    const int w = videoWidth, h = videoHeight;
+    if (image.width < w || image.height < h) return; // window shrank; frame can't fill the stream
+    yuv.resize((size_t)w * h * 3 / 2);
+    unsigned char* yPlane = yuv.data();
+    unsigned char* uPlane = yPlane + (size_t)w * h;
+    unsigned char* vPlane = uPlane + (size_t)(w / 2) * (h / 2);
+    for (int y = 0; y < h; ++y) {
+        const unsigned char* src = &image.rgba[(size_t)(image.height - 1 - y) * image.width * 4];
+        unsigned char* dst = yPlane + (size_t)y * w;
+        for (int x = 0; x < w; ++x) {
+            int r = src[x * 4], g = src[x * 4 + 1], b = src[x * 4 + 2];
+            dst[x] = (unsigned char)((66 * r + 129 * g + 25 * b + 128) / 256 + 16);
+        }
+    }
+    for (int y = 0; y < h / 2; ++y) {
+        const unsigned char* row0 = &image.rgba[(size_t)(image.height - 1 - 2 * y) * image.width * 4];
+        const unsigned char* row1 = &image.rgba[(size_t)(image.height - 2 - 2 * y) * image.width * 4];
+        for (int x = 0; x < w / 2; ++x) {
+            int r = 0, g = 0, b = 0;
+            const unsigned char* px[4] = {row0 + x * 8, row0 + x * 8 + 4, row1 + x * 8, row1 + x * 8 + 4};
+            for (int k = 0; k < 4; ++k) { r += px[k][0]; g += px[k][1]; b += px[k][2]; }
+            r /= 4; g /= 4; b /= 4;
+            uPlane[(size_t)y * (w / 2) + x] = (unsigned char)((-38 * r - 74 * g + 112 * b + 128) / 256 + 128);
+            vPlane[(size_t)y * (w / 2) + x] = (unsigned char)((112 * r - 94 * g - 18 * b + 128) / 256 + 128);
+        }
+    }
+    writeBytes("FRAME\n", 6);
+    writeBytes(yuv.data(), yuv.size());
+    ++framesWritten;
+}
+
+void FrameRecorder::writeBytes(const void* data, size_t size) {
+    const unsigned char* p = (const unsigned char*)data;
+    writeBuffer.insert(writeBuffer.end(), p, p + size);
+    if (writeBuffer.size() >= WRITE_CHUNK) flushWrites();
+}
+
+void FrameRecorder::flushWrites() {
+    if (!file || writeBuffer.empty()) return;
+    bytesWritten += std::fwrite(writeBuffer.data(), 1, writeBuffer.size(), file);
+    writeBuffer.clear();
+}
+
+void FrameRecorder::report(std::ostream& os) const {
+    unsigned long long dropped = droppedQueueFull + readback.dropped();
+    os << "  frame capture  : " << framesWritten << " frames to " << cfg.output << " ("
+       << bytesWritten / (1024 * 1024) << " MiB, "
+       << (framesWritten ? encodeMs / (double)framesWritten : 0.0) << " ms encode/frame), "
+       << dropped << " dropped";
+    if (dropped) os << " (" << droppedQueueFull << " encoder behind, " << readback.dropped() << " readback busy)";
+    os << "\n";
+}
@@ -0,0 +1,83 @@
+#ifndef FRAMERECORDER_HPP
+#define FRAMERECORDER_HPP
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "framecapture.hpp"
+
+enum CaptureFormat {
+    CAPTURE_BMP_SEQUENCE = 0,   // <output>/frame_NNNNN.bmp
+    CAPTURE_Y4M                 // one YUV4MPEG2 (raw I420) file, plays in ffplay/mpv, feeds ffmpeg
+};
+
+struct FrameRecorderConfig {
+    std::string output;          // directory (BMP) or .y4m file
+    CaptureFormat format = CAPTURE_Y4M;
+    int queueDepth = 8;          // frames buffered between render and encoder thread
+    double fps = 60.0;           // nominal rate written to the Y4M header
+};
+
+// Continuous capture of every rendered frame to disk.
+//
+// The render thread only queues PBO readbacks (FrameCapture) and, once a readback is
+// mapped a few frames later, copies it into a preallocated frame and hands it to the
+// encoder thread. Conversion (RGBA -> BMP/I420) and all file I/O happen on that
+// thread, written in large sequential chunks. If the encoder falls behind and the
+// queue is full the frame is dropped and counted, never waited for.
+class FrameRecorder {
+public:
+    FrameRecorder() {}
+    ~FrameRecorder() { stop(); }
+
+    bool start(const FrameRecorderConfig& config, int width, int height);
+    // GL thread, once per frame after the draws: queues this frame's readback and
+    // passes finished ones on. `frame` numbers the output.
+    void captureFrame(unsigned long long frame, int width, int height);
+    // Drains outstanding readbacks, finishes encoding and closes the output.
+    void stop();
+    bool active() const { return running; }
+    void report(std::ostream& os) const;
+
+private:
+    FrameRecorder(const FrameRecorder&);
+    FrameRecorder& operator=(const FrameRecorder&);
+
+    void handOff(CapturedImage& image);
+    void encoderLoop();
+    void encode(const CapturedImage& image);
+    void writeBytes(const void* data, size_t size);
+    void flushWrites();
+
+    FrameRecorderConfig cfg;
+    FrameCapture readback;
+    CapturedImage staging;                 // render thread: mapped readback lands here
+    bool running = false;
+
+    std::thread encoder;
+    std::mutex mutex;
+    std::condition_variable frameQueued;
+    std::deque<CapturedImage> queue;       // filled frames, oldest first
+    std::vector<CapturedImage> freeFrames; // recycled buffers (queueDepth of them)
+    bool quit = false;
+
+    // encoder thread only
+    FILE* file = nullptr;
+    std::vector<unsigned char> writeBuffer;
+    std::vector<unsigned char> yuv;
+    int videoWidth = 0, videoHeight = 0;
+
+    // stats
+    unsigned long long framesWritten = 0;
+    unsigned long long droppedQueueFull = 0;
+    unsigned long long bytesWritten = 0;
+    double encodeMs = 0.0;
+};
+
+#endif
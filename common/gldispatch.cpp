@@ -0,0 +1,437 @@
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <vector>
+
+#include "gldispatch.hpp"
+
+GlCallCounters& GlCallCounters::operator+=(const GlCallCounters& o) {
+    calls += o.calls;
+    draws += o.draws;
+    indices += o.indices;
+    programBinds += o.programBinds;
+    vertexArrayBinds += o.vertexArrayBinds;
+    bufferBinds += o.bufferBinds;
+    textureBinds += o.textureBinds;
+    framebufferBinds += o.framebufferBinds;
+    stateChanges += o.stateChanges;
+    uniformWrites += o.uniformWrites;
+    bufferBytes += o.bufferBytes;
+    textureBytes += o.textureBytes;
+    readbackBytes += o.readbackBytes;
+    return *this;
+}
+
+void GlCallCounters::takeMax(const GlCallCounters& o) {
+    calls = std::max(calls, o.calls);
+    draws = std::max(draws, o.draws);
+    indices = std::max(indices, o.indices);
+    programBinds = std::max(programBinds, o.programBinds);
+    vertexArrayBinds = std::max(vertexArrayBinds, o.vertexArrayBinds);
+    bufferBinds = std::max(bufferBinds, o.bufferBinds);
+    textureBinds = std::max(textureBinds, o.textureBinds);
+    framebufferBinds = std::max(framebufferBinds, o.framebufferBinds);
+    stateChanges = std::max(stateChanges, o.stateChanges);
+    uniformWrites = std::max(uniformWrites, o.uniformWrites);
+    bufferBytes = std::max(bufferBytes, o.bufferBytes);
+    textureBytes = std::max(textureBytes, o.textureBytes);
+    readbackBytes = std::max(readbackBytes, o.readbackBytes);
+}
+
+namespace {
+
+GlBackend activeBackend = GL_BACKEND_DRIVER;
+bool installed = false;
+GlCallCounters current, setupCounters, lastFrame, totals, peak;
+unsigned long long frames = 0;
+unsigned long long peakUploadBytes = 0; // buffer + texture, worst single frame
+
+enum HookKind {
+    HOOK_CALL,
+    HOOK_DRAW,
+    HOOK_PROGRAM,
+    HOOK_VERTEX_ARRAY,
+    HOOK_BUFFER_BIND,
+    HOOK_TEXTURE_BIND,
+    HOOK_FRAMEBUFFER_BIND,
+    HOOK_STATE,
+    HOOK_UNIFORM
+};
+
+inline void countCall(int kind) {
+    ++current.calls;
+    switch (kind) {
+    case HOOK_DRAW:             ++current.draws; break;
+    case HOOK_PROGRAM:          ++current.programBinds; break;
+    case HOOK_VERTEX_ARRAY:     ++current.vertexArrayBinds; break;
+    case HOOK_BUFFER_BIND:      ++current.bufferBinds; break;
+    case HOOK_TEXTURE_BIND:     ++current.textureBinds; break;
+    case HOOK_FRAMEBUFFER_BIND: ++current.framebufferBinds; break;
+    case HOOK_STATE:            ++current.stateChanges; break;
+    case HOOK_UNIFORM:          ++current.uniformWrites; break;
+    default: break;
+    }
+}
+
+unsigned long long pixelBytes(GLenum format, GLenum type) {
+    switch (type) {
+    case GL_UNSIGNED_INT_24_8:
+    case GL_UNSIGNED_INT_8_8_8_8:
+    case GL_UNSIGNED_INT_8_8_8_8_REV:
+    case GL_UNSIGNED_INT_2_10_10_10_REV:
+        return 4; // packed: the whole pixel
+    default: break;
+    }
+    unsigned long long components = 4;
+    switch (format) {
+    case GL_RED: case GL_RED_INTEGER: case GL_DEPTH_COMPONENT: components = 1; break;
+    case GL_RG: case GL_RG_INTEGER: components = 2; break;
+    case GL_RGB: case GL_BGR: case GL_RGB_INTEGER: components = 3; break;
+    default: break;
+    }
+    unsigned long long size = 1;
+    switch (type) {
+    case GL_SHORT: case GL_UNSIGNED_SHORT: case GL_HALF_FLOAT: size = 2; break;
+    case GL_INT: case GL_UNSIGNED_INT: case GL_FLOAT: size = 4; break;
+    default: break;
+    }
+    return components * size;
+}
+
+// ---- argument inspection, run before forwarding ----
+
+struct NoNote {
+    template <typename... T> static void note(T...) {}
+};
+struct DrawElementsNote {
+    template <typename... T> static void note(GLenum, GLsizei count, T...) { current.indices += (unsigned long long)count; }
+};
+struct DrawElementsInstancedNote {
+    template <typename P> static void note(GLenum, GLsizei count, GLenum, P, GLsizei instances) {
+        current.indices += (unsigned long long)count * (unsigned long long)instances;
+    }
+};
+struct DrawArraysNote {
+    static void note(GLenum, GLint, GLsizei count) { current.indices += (unsigned long long)count; }
+};
+struct DrawArraysInstancedNote {
+    static void note(GLenum, GLint, GLsizei count, GLsizei instances) {
+        current.indices += (unsigned long long)count * (unsigned long long)instances;
+    }
+};
+struct BufferDataNote {
+    template <typename P> static void note(GLenum, GLsizeiptr size, P, GLenum) {
+        if (size > 0) current.bufferBytes += (unsigned long long)size;
+    }
+};
+struct BufferSubDataNote {
+    template <typename P> static void note(GLenum, GLintptr, GLsizeiptr size, P) {
+        if (size > 0) current.bufferBytes += (unsigned long long)size;
+    }
+};
+struct MapBufferRangeNote {
+    static void note(GLenum, GLintptr, GLsizeiptr length, GLbitfield access) {
+        if ((access & GL_MAP_WRITE_BIT) && length > 0) current.bufferBytes += (unsigned long long)length;
+    }
+};
+struct TexImage2DNote {
+    template <typename P>
+    static void note(GLenum, GLint, GLint, GLsizei w, GLsizei h, GLint, GLenum format, GLenum type, P pixels) {
+        if (pixels) current.textureBytes += (unsigned long long)w * (unsigned long long)h * pixelBytes(format, type);
+    }
+};
+struct TexImage3DNote {
+    template <typename P>
+    static void note(GLenum, GLint, GLint, GLsizei w, GLsizei h, GLsizei d, GLint, GLenum format, GLenum type, P pixels) {
+        if (pixels) {
+            current.textureBytes += (unsigned long long)w * (unsigned long long)h * (unsigned long long)d * pixelBytes(format, type);
+        }
+    }
+};
+struct TexSubImage2DNote {
+    template <typename P>
+    static void note(GLenum, GLint, GLint, GLint, GLsizei w, GLsizei h, GLenum format, GLenum type, P) {
+        current.textureBytes += (unsigned long long)w * (unsigned long long)h * pixelBytes(format, type);
+    }
+};
+struct CompressedTexImage2DNote {
+    template <typename P>
+    static void note(GLenum, GLint, GLenum, GLsizei, GLsizei, GLint, GLsizei imageSize, P) {
+        current.textureBytes += (unsigned long long)imageSize;
+    }
+};
+struct ReadPixelsNote {
+    template <typename P>
+    static void note(GLint, GLint, GLsizei w, GLsizei h, GLenum format, GLenum type, P) {
+        current.readbackBytes += (unsigned long long)w * (unsigned long long)h * pixelBytes(format, type);
+    }
+};
+
+// ---- null backend ----
+
+GLuint nextName = 0;
+std::map<GLenum, std::vector<unsigned char>> mappedScratch;
+int fenceToken = 0;
+
+template <typename N, typename P>
+void APIENTRY nullGenNames(N n, P* names) {
+    for (N i = 0; i < n; ++i) names[i] = ++nextName;
+}
+template <typename... T>
+GLuint APIENTRY nullCreateObject(T...) { return ++nextName; }
+
+void APIENTRY nullGetIntegerv(GLenum pname, GLint* value) {
+    switch (pname) {
+    case GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT: *value = 256; break;
+    case GL_MAX_UNIFORM_BLOCK_SIZE: *value = 65536; break;
+    case GL_MAX_TEXTURE_SIZE: *value = 16384; break;
+    case GL_MAX_SAMPLES: *value = 8; break;
+    default: *value = 0; break;
+    }
+}
+// glGetShaderiv / glGetProgramiv: everything compiles and links, logs are empty
+void APIENTRY nullGetObjectiv(GLuint, GLenum pname, GLint* value) {
+    *value = (pname == GL_COMPILE_STATUS || pname == GL_LINK_STATUS) ? GL_TRUE : 0;
+}
+// timer queries: results are always ready (and zero)
+void APIENTRY nullGetQueryObjectiv(GLuint, GLenum pname, GLint* value) {
+    *value = (pname == GL_QUERY_RESULT_AVAILABLE) ? GL_TRUE : 0;
+}
+void APIENTRY nullGetQueryObjectui64v(GLuint, GLenum, GLuint64* value) { *value = 0; }
+GLenum APIENTRY nullCheckFramebufferStatus(GLenum) { return GL_FRAMEBUFFER_COMPLETE; }
+GLsync APIENTRY nullFenceSync(GLenum, GLbitfield) { return reinterpret_cast<GLsync>(&fenceToken); }
+GLenum APIENTRY nullClientWaitSync(GLsync, GLbitfield, GLuint64) { return GL_ALREADY_SIGNALED; }
+// one scratch block per target, valid until the next map of that target
+void* APIENTRY nullMapBufferRange(GLenum target, GLintptr, GLsizeiptr length, GLbitfield) {
+    std::vector<unsigned char>& scratch = mappedScratch[target];
+    if (scratch.size() < (size_t)length) scratch.resize((size_t)length);
+    return scratch.empty() ? nullptr : &scratch[0];
+}
+GLboolean APIENTRY nullUnmapBuffer(GLenum) { return GL_TRUE; }
+
+// One wrapper per entry point: counts, inspects the arguments, forwards to the driver
+// (or the null stub) saved at install time.
+template <typename Fn> struct GlHook;
+template <typename R, typename... A>
+struct GlHook<R (APIENTRYP)(A...)> {
+    typedef R (APIENTRYP Fn)(A...);
+
+    static R APIENTRY nullCall(A...) { return R(); }
+
+    template <Fn* Slot, int Kind, typename Note>
+    struct Entry {
+        static Fn& next() { static Fn fn = 0; return fn; }
+        static R APIENTRY call(A... args) {
+            countCall(Kind);
+            Note::note(args...);
+            return next()(args...);
+        }
+        static void install(Fn nullImpl) {
+            Fn target = *Slot;
+            if (activeBackend == GL_BACKEND_NULL) target = nullImpl ? nullImpl : &nullCall;
+            // not exported by this driver: leave it null so callers can still test for it
+            if (!target) return;
+            next() = target;
+            *Slot = &call;
+        }
+    };
+};
+
+#define GL_HOOK(name, kind, note, nullImpl) \
+    GlHook<decltype(glad_##name)>::Entry<&glad_##name, kind, note>::install(nullImpl)
+
+void installHooks() {
+    // draws
+    GL_HOOK(glDrawElements, HOOK_DRAW, DrawElementsNote, 0);
+    GL_HOOK(glDrawArrays, HOOK_DRAW, DrawArraysNote, 0);
+    GL_HOOK(glDrawElementsInstanced, HOOK_DRAW, DrawElementsInstancedNote, 0);
+    GL_HOOK(glDrawArraysInstanced, HOOK_DRAW, DrawArraysInstancedNote, 0);
+    GL_HOOK(glClear, HOOK_CALL, NoNote, 0);
+
+    // binds
+    GL_HOOK(glUseProgram, HOOK_PROGRAM, NoNote, 0);
+    GL_HOOK(glBindVertexArray, HOOK_VERTEX_ARRAY, NoNote, 0);
+    GL_HOOK(glBindBuffer, HOOK_BUFFER_BIND, NoNote, 0);
+    GL_HOOK(glBindBufferBase, HOOK_BUFFER_BIND, NoNote, 0);
+    GL_HOOK(glBindBufferRange, HOOK_BUFFER_BIND, NoNote, 0);
+    GL_HOOK(glBindTexture, HOOK_TEXTURE_BIND, NoNote, 0);
+    GL_HOOK(glBindFramebuffer, HOOK_FRAMEBUFFER_BIND, NoNote, 0);
+    GL_HOOK(glBindRenderbuffer, HOOK_FRAMEBUFFER_BIND, NoNote, 0);
+
+    // fixed-function state
+    GL_HOOK(glEnable, HOOK_STATE, NoNote, 0);
+    GL_HOOK(glDisable, HOOK_STATE, NoNote, 0);
+    GL_HOOK(glBlendFunc, HOOK_STATE, NoNote, 0);
+    GL_HOOK(glDepthFunc, HOOK_STATE, NoNote, 0);
+    GL_HOOK(glDepthMask, HOOK_STATE, NoNote, 0);
+    GL_HOOK(glColorMask, HOOK_STATE, NoNote, 0);
+    GL_HOOK(glCullFace, HOOK_STATE, NoNote, 0);
+    GL_HOOK(glViewport, HOOK_STATE, NoNote, 0);
+    GL_HOOK(glClearColor, HOOK_STATE, NoNote, 0);
+    GL_HOOK(glActiveTexture, HOOK_STATE, NoNote, 0);
+    GL_HOOK(glPixelStorei, HOOK_STATE, NoNote, 0);
+    GL_HOOK(glTexParameteri, HOOK_STATE, NoNote, 0);
+
+    // uniforms
+    GL_HOOK(glUniform1i, HOOK_UNIFORM, NoNote, 0);
+    GL_HOOK(glUniform1f, HOOK_UNIFORM, NoNote, 0);
+    GL_HOOK(glUniform2f, HOOK_UNIFORM, NoNote, 0);
+    GL_HOOK(glUniform2fv, HOOK_UNIFORM, NoNote, 0);
+    GL_HOOK(glUniform3f, HOOK_UNIFORM, NoNote, 0);
+    GL_HOOK(glUniform3fv, HOOK_UNIFORM, NoNote, 0);
+    GL_HOOK(glUniform4fv, HOOK_UNIFORM, NoNote, 0);
+    GL_HOOK(glUniformMatrix4fv, HOOK_UNIFORM, NoNote, 0);
+    GL_HOOK(glUniformBlockBinding, HOOK_UNIFORM, NoNote, 0);
+    GL_HOOK(glGetUniformLocation, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glGetUniformBlockIndex, HOOK_CALL, NoNote, 0);
+
+    // data in and out
+    GL_HOOK(glBufferData, HOOK_CALL, BufferDataNote, 0);
+    GL_HOOK(glBufferSubData, HOOK_CALL, BufferSubDataNote, 0);
+    GL_HOOK(glMapBufferRange, HOOK_CALL, MapBufferRangeNote, &nullMapBufferRange);
+    GL_HOOK(glUnmapBuffer, HOOK_CALL, NoNote, &nullUnmapBuffer);
+    GL_HOOK(glTexImage2D, HOOK_CALL, TexImage2DNote, 0);
+    GL_HOOK(glTexSubImage2D, HOOK_CALL, TexSubImage2DNote, 0);
+    GL_HOOK(glTexImage3D, HOOK_CALL, TexImage3DNote, 0);
+    GL_HOOK(glCompressedTexImage2D, HOOK_CALL, CompressedTexImage2DNote, 0);
+    GL_HOOK(glGenerateMipmap, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glReadPixels, HOOK_CALL, ReadPixelsNote, 0);
+    GL_HOOK(glVertexAttribPointer, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glEnableVertexAttribArray, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glDisableVertexAttribArray, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glVertexAttribDivisor, HOOK_CALL, NoNote, 0);
+
+    // object lifetime
+    GL_HOOK(glGenBuffers, HOOK_CALL, NoNote, &nullGenNames);
+    GL_HOOK(glGenVertexArrays, HOOK_CALL, NoNote, &nullGenNames);
+    GL_HOOK(glGenTextures, HOOK_CALL, NoNote, &nullGenNames);
+    GL_HOOK(glGenFramebuffers, HOOK_CALL, NoNote, &nullGenNames);
+    GL_HOOK(glGenRenderbuffers, HOOK_CALL, NoNote, &nullGenNames);
+    GL_HOOK(glDeleteBuffers, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glDeleteVertexArrays, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glDeleteTextures, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glDeleteFramebuffers, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glDeleteRenderbuffers, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glRenderbufferStorage, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glRenderbufferStorageMultisample, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glFramebufferRenderbuffer, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glFramebufferTexture2D, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glCheckFramebufferStatus, HOOK_CALL, NoNote, &nullCheckFramebufferStatus);
+    GL_HOOK(glBlitFramebuffer, HOOK_CALL, NoNote, 0);
+
+    // shaders
+    GL_HOOK(glCreateShader, HOOK_CALL, NoNote, &nullCreateObject);
+    GL_HOOK(glShaderSource, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glCompileShader, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glGetShaderiv, HOOK_CALL, NoNote, &nullGetObjectiv);
+    GL_HOOK(glGetShaderInfoLog, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glDeleteShader, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glCreateProgram, HOOK_CALL, NoNote, &nullCreateObject);
+    GL_HOOK(glAttachShader, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glDetachShader, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glLinkProgram, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glGetProgramiv, HOOK_CALL, NoNote, &nullGetObjectiv);
+    GL_HOOK(glGetProgramInfoLog, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glDeleteProgram, HOOK_CALL, NoNote, 0);
+
+    // sync and queries
+    GL_HOOK(glFenceSync, HOOK_CALL, NoNote, &nullFenceSync);
+    GL_HOOK(glClientWaitSync, HOOK_CALL, NoNote, &nullClientWaitSync);
+    GL_HOOK(glDeleteSync, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glGetIntegerv, HOOK_CALL, NoNote, &nullGetIntegerv);
+    GL_HOOK(glGetError, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glFlush, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glFinish, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glGenQueries, HOOK_CALL, NoNote, &nullGenNames);
+    GL_HOOK(glDeleteQueries, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glBeginQuery, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glEndQuery, HOOK_CALL, NoNote, 0);
+    GL_HOOK(glGetQueryObjectiv, HOOK_CALL, NoNote, &nullGetQueryObjectiv);
+    GL_HOOK(glGetQueryObjectui64v, HOOK_CALL, NoNote, &nullGetQueryObjectui64v);
+}
+
+#undef GL_HOOK
+
+double kib(unsigned long long bytes) { return (double)bytes / 1024.0; }
+
+void printCounters(std::ostream& os, const char* label, const GlCallCounters& c, double scale) {
+    os << std::setprecision(scale == 1.0 ? 0 : 1);
+    os << "  " << std::left << std::setw(15) << label << std::right << ": "
+       << c.calls * scale << " calls, " << c.draws * scale << " draws (" << c.indices * scale << " indices), "
+       << c.stateChanges * scale << " state changes, " << c.uniformWrites * scale << " uniform writes\n"
+       << "                   " << c.binds() * scale << " binds (program " << c.programBinds * scale
+       << ", vao " << c.vertexArrayBinds * scale << ", buffer " << c.bufferBinds * scale
+       << ", texture " << c.textureBinds * scale << ", framebuffer " << c.framebufferBinds * scale << ")\n"
+       << std::setprecision(1)
+       << "                   upload " << kib(c.bufferBytes) * scale << " KiB buffers + "
+       << kib(c.textureBytes) * scale << " KiB textures, readback " << kib(c.readbackBytes) * scale << " KiB\n";
+}
+
+} // namespace
+
+bool glDispatchInstall(GlBackend backend) {
+    if (installed) return activeBackend == backend;
+    activeBackend = backend;
+    if (backend == GL_BACKEND_NULL) {
+        // what the rest of the code checks before using optional features
+        GLVersion.major = 3;
+        GLVersion.minor = 3;
+    }
+    installHooks();
+    installed = true;
+    return true;
+}
+
+bool glDispatchInstalled() { return installed; }
+GlBackend glDispatchBackend() { return activeBackend; }
+
+void glDispatchEndSetup() {
+    setupCounters += current;
+    current = GlCallCounters();
+}
+
+void glDispatchEndFrame() {
+    lastFrame = current;
+    totals += current;
+    peak.takeMax(current);
+    peakUploadBytes = std::max(peakUploadBytes, current.bufferBytes + current.textureBytes);
+    ++frames;
+    current = GlCallCounters();
+}
+
+const GlCallCounters& glDispatchLastFrame() { return lastFrame; }
+
+void glDispatchReport(std::ostream& os) {
+    if (!installed) return;
+    std::ios::fmtflags f = os.flags();
+    std::streamsize p = os.precision();
+    os << std::fixed;
+    os << "  gl backend     : " << (activeBackend == GL_BACKEND_NULL ? "null (no driver)" : "driver, counted")
+       << ", " << frames << " frames\n";
+    printCounters(os, "gl setup", setupCounters, 1.0);
+    if (frames) {
+        printCounters(os, "gl per frame", totals, 1.0 / (double)frames);
+        printCounters(os, "gl peak frame", peak, 1.0);
+    }
+    os.precision(p);
+    os.flags(f);
+}
+
+bool glDispatchCheckLimits(const GlCallLimits& limits, std::ostream& os) {
+    struct Field { const char* name; unsigned long long limit, peak; };
+    const Field fields[] = {
+        { "calls", limits.calls, peak.calls },
+        { "draws", limits.draws, peak.draws },
+        { "binds", limits.binds, peak.binds() },
+        { "state changes", limits.stateChanges, peak.stateChanges },
+        { "uniform writes", limits.uniformWrites, peak.uniformWrites },
+        { "upload bytes", limits.uploadBytes, peakUploadBytes },
+    };
+    bool ok = true;
+    for (const Field& field : fields) {
+        if (!field.limit || field.peak <= field.limit) continue;
+        os << "[GL] worst frame: " << field.peak << " " << field.name << ", limit " << field.limit << "\n";
+        ok = false;
+    }
+    return ok;
+}
@@ -0,0 +1,72 @@
+#ifndef GLDISPATCH_HPP
+#define GLDISPATCH_HPP
+
+#include <ostream>
+
+#include <glad/glad.h>
+
+enum GlBackend {
+    GL_BACKEND_DRIVER,  // real entry points, counted
+    GL_BACKEND_NULL     // no driver: names, mappings, fences and statuses are faked
+};
+
+// What went through the GL entry points, per frame (or summed, or per-frame peak).
+struct GlCallCounters {
+    unsigned long long calls = 0;
+    unsigned long long draws = 0;
+    unsigned long long indices = 0;        // vertices/indices submitted, times instances
+    unsigned long long programBinds = 0;
+    unsigned long long vertexArrayBinds = 0;
+    unsigned long long bufferBinds = 0;    // glBindBuffer/Base/Range
+    unsigned long long textureBinds = 0;
+    unsigned long long framebufferBinds = 0; // framebuffers and renderbuffers
+    unsigned long long stateChanges = 0;   // enable/disable, blend, viewport, active texture...
+    unsigned long long uniformWrites = 0;
+    unsigned long long bufferBytes = 0;    // glBuffer(Sub)Data + ranges mapped for writing
+    unsigned long long textureBytes = 0;   // glTex(Sub)Image, compressed uploads
+    unsigned long long readbackBytes = 0;  // glReadPixels
+
+    unsigned long long binds() const {
+        return programBinds + vertexArrayBinds + bufferBinds + textureBinds + framebufferBinds;
+    }
+    GlCallCounters& operator+=(const GlCallCounters& o);
+    void takeMax(const GlCallCounters& o);
+};
+
+// Thin dispatch layer over glad's function pointers: every entry point the renderer uses
+// is routed through a wrapper that counts it and forwards to the driver, or, with
+// GL_BACKEND_NULL, to a stub. The null backend runs all renderer logic (draw lists,
+// rings, streaming, readback scheduling) with no context at all, so CPU-side cost and
+// call counts can be measured on a machine without a GPU. GL thread only.
+//
+// Install once: after gladLoadGLLoader for GL_BACKEND_DRIVER, instead of it for
+// GL_BACKEND_NULL. Without install() there is no wrapper and no overhead.
+// Entry points loaded by hand through glfwGetProcAddress (glBufferStorage) are not
+// routed and are simply unavailable on the null backend.
+bool glDispatchInstall(GlBackend backend);
+bool glDispatchInstalled();
+GlBackend glDispatchBackend();
+
+// Everything counted so far belongs to loading/setup, not to a frame.
+void glDispatchEndSetup();
+// Closes the current frame's counters.
+void glDispatchEndFrame();
+const GlCallCounters& glDispatchLastFrame();
+
+// Per-frame ceilings for CI; 0 = unchecked.
+struct GlCallLimits {
+    unsigned long long calls = 0;
+    unsigned long long draws = 0;
+    unsigned long long binds = 0;
+    unsigned long long stateChanges = 0;
+    unsigned long long uniformWrites = 0;
+    unsigned long long uploadBytes = 0;    // buffer + texture bytes
+};
+
+// Setup, per-frame mean and per-frame peak.
+void glDispatchReport(std::ostream& os);
+// Compares the worst frame against the limits and reports every one exceeded.
+// Returns true if all are within.
+bool glDispatchCheckLimits(const GlCallLimits& limits, std::ostream& os);
+
+#endif
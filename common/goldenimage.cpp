@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#include "stb_image.h"
+#include "goldenimage.hpp"
+
+namespace {
+
+template <typename T> void putLE(std::ostream& out, T v) {
+    for (size_t i = 0; i < sizeof(T); ++i) out.put((char)((v >> (8 * i)) & 0xFF));
+}
+
+// YIQ colour delta (Kotsarenko & Ramos), squared, 0..35215 for 8-bit channels
+double yiqDelta(const unsigned char* a, const unsigned char* b) {
+    double r1 = a[0], g1 = a[1], b1 = a[2];
+    double r2 = b[0], g2 = b[1], b2 = b[2];
+    double y = (r1 - r2) * 0.29889531 + (g1 - g2) * 0.58662247 + (b1 - b2) * 0.11448223;
+    double i = (r1 - r2) * 0.59597799 - (g1 - g2) * 0.27417610 - (b1 - b2) * 0.32180189;
+    double q = (r1 - r2) * 0.21147017 - (g1 - g2) * 0.52261711 + (b1 - b2) * 0.31114694;
+    return 0.5053 * y * y + 0.299 * i * i + 0.1957 * q * q;
+}
+const double MAX_YIQ_DELTA = 35215.0;
+
+std::string goldenName(const std::string& dir, uint64_t tag, const char* suffix) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "frame_%05llu%s.bmp", (unsigned long long)tag, suffix);
+    return dir.empty() ? std::string(name) : dir + "/" + name;
+}
+
+} // namespace
+
+bool writeBMP(const std::string& path, const CapturedImage& image) {
+    std::ofstream out(path.c_str(), std::ios::binary);
+    if (!out) {
+        std::cerr << "[GOLDEN] cannot write " << path << "\n";
+        return false;
+    }
+    const uint32_t rowBytes = ((uint32_t)image.width * 3 + 3) & ~3u;
+    const uint32_t dataBytes = rowBytes * (uint32_t)image.height;
+    out.put('B'); out.put('M');
+    putLE<uint32_t>(out, 54 + dataBytes);
+    putLE<uint32_t>(out, 0);
+    putLE<uint32_t>(out, 54);               // pixel data offset
+    putLE<uint32_t>(out, 40);               // BITMAPINFOHEADER
+    putLE<int32_t>(out, image.width);
+    putLE<int32_t>(out, image.height);      // positive = bottom-up
+    putLE<uint16_t>(out, 1);
+    putLE<uint16_t>(out, 24);
+    putLE<uint32_t>(out, 0);
+    putLE<uint32_t>(out, dataBytes);
+    putLE<uint32_t>(out, 3780);             // 96 dpi
+    putLE<uint32_t>(out, 3780);
+    putLE<uint32_t>(out, 0);
+    putLE<uint32_t>(out, 0);
+
+    std::vector<char> row(rowBytes, 0);
+    for (int y = 0; y < image.height; ++y) {
+        const unsigned char* src = &image.rgba[(size_t)y * (size_t)image.width * 4];
+        for (int x = 0; x < image.width; ++x) {
+            row[(size_t)x * 3 + 0] = (char)src[x * 4 + 2];
+            row[(size_t)x * 3 + 1] = (char)src[x * 4 + 1];
+            row[(size_t)x * 3 + 2] = (char)src[x * 4 + 0];
+        }
+        out.write(row.data(), rowBytes);
+    }
+    return (bool)out;
+}
+
+bool loadImage(const std::string& path, CapturedImage& image) {
+    int w = 0, h = 0, n = 0;
+    stbi_set_flip_vertically_on_load(true); // bottom-up, like glReadPixels
+    unsigned char* data = stbi_load(path.c_str(), &w, &h, &n, 4);
+    if (!data) return false;
+    image.width = w;
+    image.height = h;
+    image.rgba.assign(data, data + (size_t)w * (size_t)h * 4);
+    stbi_image_free(data);
+    return true;
+}
+
+ImageDiff compareImages(const CapturedImage& actual, const CapturedImage& golden,
+                        float threshold, CapturedImage* diff) {
+    ImageDiff d;
+    if (actual.width != golden.width || actual.height != golden.height) {
+        d.sizeMismatch = true;
+        return d;
+    }
+    d.total = (size_t)actual.width * (size_t)actual.height;
+    const double limit = MAX_YIQ_DELTA * (double)threshold * (double)threshold;
+    if (diff) {
+        diff->width = actual.width;
+        diff->height = actual.height;
+        diff->tag = actual.tag;
+        diff->rgba.resize(d.total * 4);
+    }
+    double maxDelta = 0.0;
+    for (size_t p = 0; p < d.total; ++p) {
+        const unsigned char* a = &actual.rgba[p * 4];
+        const unsigned char* g = &golden.rgba[p * 4];
+        double delta = yiqDelta(a, g);
+        maxDelta = std::max(maxDelta, delta);
+        bool differs = delta > limit;
+        if (differs) ++d.differing;
+        if (diff) {
+            unsigned char* o = &diff->rgba[p * 4];
+            if (differs) {
+                o[0] = 255; o[1] = 0; o[2] = 0;
+            } else {
+                unsigned char grey = (unsigned char)(((int)g[0] + g[1] + g[2]) / 12 + 170); // faded reference
+                o[0] = o[1] = o[2] = grey;
+            }
+            o[3] = 255;
+        }
+    }
+    d.maxDelta = std::sqrt(maxDelta / MAX_YIQ_DELTA);
+    return d;
+}
+
+bool GoldenImageSet::check(const CapturedImage& image) {
+    std::string ref = goldenName(directory, image.tag, "");
+    if (update) {
+        if (!writeBMP(ref, image)) { ++failCount; return false; }
+        ++writtenCount;
+        return true;
+    }
+
+    CapturedImage golden;
+    if (!loadImage(ref, golden)) {
+        std::cerr << "[GOLDEN] frame " << image.tag << ": no reference " << ref << " (run with --update-golden)\n";
+        writeBMP(goldenName(directory, image.tag, ".actual"), image);
+        ++failCount;
+        return false;
+    }
+
+    CapturedImage diffImage;
+    ImageDiff d = compareImages(image, golden, pixelThreshold, &diffImage);
+    double fraction = d.total ? (double)d.differing / (double)d.total : 1.0;
+    bool ok = !d.sizeMismatch && fraction <= maxDifferingFraction;
+    if (ok) {
+        ++passCount;
+        return true;
+    }
+    ++failCount;
+    if (d.sizeMismatch) {
+        std::cerr << "[GOLDEN] frame " << image.tag << ": size " << image.width << "x" << image.height
+                  << " vs reference " << golden.width << "x" << golden.height << "\n";
+    } else {
+        std::cerr << "[GOLDEN] frame " << image.tag << ": " << d.differing << " pixels differ ("
+                  << fraction * 100.0 << "%, max delta " << d.maxDelta << ")\n";
+        writeBMP(goldenName(directory, image.tag, ".diff"), diffImage);
+    }
+    writeBMP(goldenName(directory, image.tag, ".actual"), image);
+    return false;
+}
+
+void GoldenImageSet::report(std::ostream& os) const {
+    if (update) {
+        os << "  golden images  : wrote " << writtenCount << " references to " << directory << "/\n";
+    } else {
+        os << "  golden images  : " << passCount << " passed, " << failCount << " failed"
+           << " (threshold " << pixelThreshold << ", max " << maxDifferingFraction * 100.0 << "% pixels)\n";
+    }
+}
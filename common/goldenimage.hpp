@@ -0,0 +1,48 @@
+#ifndef GOLDENIMAGE_HPP
+#define GOLDENIMAGE_HPP
+
+#include <ostream>
+#include <string>
+
+#include "framecapture.hpp"
+
+// 24-bit BMP (what distrib/screenshot.h wrote); rows bottom-up like CapturedImage.
+bool writeBMP(const std::string& path, const CapturedImage& image);
+// Any format stb_image reads (BMP, PNG, ...).
+bool loadImage(const std::string& path, CapturedImage& image);
+
+struct ImageDiff {
+    bool sizeMismatch = false;
+    size_t differing = 0;       // pixels whose perceptual delta exceeds the threshold
+    size_t total = 0;
+    double maxDelta = 0.0;      // 0..1
+};
+
+// Perceptual per-pixel comparison: colour difference in YIQ space weighted like the
+// eye (luma dominates), normalised to 0..1. `threshold` is the per-pixel delta below
+// which two pixels count as equal (0.1 hides AA/dither noise). `diff` (optional)
+// gets the golden image dimmed with differing pixels in red.
+ImageDiff compareImages(const CapturedImage& actual, const CapturedImage& golden,
+                        float threshold, CapturedImage* diff = nullptr);
+
+// Golden-image regression check: captures are compared against <dir>/frame_NNNNN.bmp,
+// or written there when updating. Failures leave .actual.bmp/.diff.bmp next to the
+// reference.
+class GoldenImageSet {
+public:
+    std::string directory = "golden";
+    float pixelThreshold = 0.1f;
+    double maxDifferingFraction = 0.002;   // share of pixels allowed to differ
+    bool update = false;
+
+    // Returns false on a mismatch or a missing reference.
+    bool check(const CapturedImage& image);
+    int passed() const { return passCount; }
+    int failed() const { return failCount; }
+    void report(std::ostream& os) const;
+
+private:
+    int passCount = 0, failCount = 0, writtenCount = 0;
+};
+
+#endif
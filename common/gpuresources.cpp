@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "gldispatch.hpp"
+#include "gpuresources.hpp"
+
+namespace {
+
+const char* kindName(int kind) {
+    static const char* names[GPU_KIND_COUNT] = {
+        "buffers", "vertex arrays", "textures", "renderbuffers", "framebuffers", "programs"
+    };
+    return (kind >= 0 && kind < GPU_KIND_COUNT) ? names[kind] : "?";
+}
+
+std::string category(const std::string& owner) {
+    size_t slash = owner.find('/');
+    return slash == std::string::npos ? owner : owner.substr(0, slash);
+}
+
+double mib(size_t bytes) { return (double)bytes / (1024.0 * 1024.0); }
+
+GLuint genName(GpuResourceKind kind) {
+    GLuint id = 0;
+    switch (kind) {
+    case GPU_BUFFER:       glGenBuffers(1, &id); break;
+    case GPU_VERTEX_ARRAY: glGenVertexArrays(1, &id); break;
+    case GPU_TEXTURE:      glGenTextures(1, &id); break;
+    case GPU_RENDERBUFFER: glGenRenderbuffers(1, &id); break;
+    case GPU_FRAMEBUFFER:  glGenFramebuffers(1, &id); break;
+    case GPU_PROGRAM:      id = glCreateProgram(); break;
+    default: break;
+    }
+    return id;
+}
+
+void deleteName(GpuResourceKind kind, GLuint id) {
+    // context already gone (handle outlived glfwTerminate): nothing left to free
+    if (!glfwGetCurrentContext() && glDispatchBackend() != GL_BACKEND_NULL) return;
+    switch (kind) {
+    case GPU_BUFFER:       glDeleteBuffers(1, &id); break;
+    case GPU_VERTEX_ARRAY: glDeleteVertexArrays(1, &id); break;
+    case GPU_TEXTURE:      glDeleteTextures(1, &id); break;
+    case GPU_RENDERBUFFER: glDeleteRenderbuffers(1, &id); break;
+    case GPU_FRAMEBUFFER:  glDeleteFramebuffers(1, &id); break;
+    case GPU_PROGRAM:      glDeleteProgram(id); break;
+    default: break;
+    }
+}
+
+} // namespace
+
+GpuResourceRegistry& gpuResources() {
+    static GpuResourceRegistry registry;
+    return registry;
+}
+
+size_t gpuImageBytes(GLenum internalFormat, int width, int height) {
+    size_t texel = 4;
+    switch (internalFormat) {
+    case GL_R8:                 texel = 1; break;
+    case GL_RG8:                texel = 2; break;
+    case GL_RGB8:               texel = 3; break;
+    case GL_RGBA16F:            texel = 8; break;
+    case GL_RGBA32F:            texel = 16; break;
+    case GL_DEPTH_COMPONENT16:  texel = 2; break;
+    case GL_DEPTH_COMPONENT24:
+    case GL_DEPTH24_STENCIL8:
+    case GL_DEPTH_COMPONENT32F: texel = 4; break;
+    default:                    texel = 4; break;
+    }
+    return texel * (size_t)std::max(width, 0) * (size_t)std::max(height, 0);
+}
+
+void GpuResourceRegistry::track(GpuResourceKind kind, GLuint id, const std::string& owner) {
+    if (!id) return;
+    GpuResourceInfo& info = live[std::make_pair((int)kind, id)];
+    currentBytes -= info.bytes;  // name reused without untrack: replace
+    info = GpuResourceInfo();
+    info.kind = kind;
+    info.id = id;
+    info.owner = owner;
+}
+
+void GpuResourceRegistry::setSize(GpuResourceKind kind, GLuint id, size_t bytes, const std::string& format) {
+    std::map<std::pair<int, GLuint>, GpuResourceInfo>::iterator it = live.find(std::make_pair((int)kind, id));
+    if (it == live.end()) return;
+    currentBytes = currentBytes - it->second.bytes + bytes;
+    peakBytes = std::max(peakBytes, currentBytes);
+    it->second.bytes = bytes;
+    it->second.format = format;
+}
+
+void GpuResourceRegistry::untrack(GpuResourceKind kind, GLuint id) {
+    std::map<std::pair<int, GLuint>, GpuResourceInfo>::iterator it = live.find(std::make_pair((int)kind, id));
+    if (it == live.end()) return;
+    currentBytes -= it->second.bytes;
+    live.erase(it);
+}
+
+void GpuResourceRegistry::report(std::ostream& os) const {
+    size_t kindCount[GPU_KIND_COUNT] = {0}, kindBytes[GPU_KIND_COUNT] = {0};
+    std::map<std::string, std::pair<size_t, size_t>> byCategory; // count, bytes
+    for (const auto& kv : live) {
+        const GpuResourceInfo& info = kv.second;
+        ++kindCount[info.kind];
+        kindBytes[info.kind] += info.bytes;
+        std::pair<size_t, size_t>& c = byCategory[category(info.owner)];
+        ++c.first;
+        c.second += info.bytes;
+    }
+    std::ios::fmtflags f = os.flags();
+    std::streamsize p = os.precision();
+    os << std::fixed << std::setprecision(2);
+    os << "  gpu memory     : " << mib(currentBytes) << " MiB in " << live.size() << " objects (peak "
+       << mib(peakBytes) << " MiB)\n";
+    for (int k = 0; k < GPU_KIND_COUNT; ++k) {
+        if (!kindCount[k]) continue;
+        os << "    " << std::left << std::setw(16) << kindName(k) << std::right << std::setw(6) << kindCount[k]
+           << std::setw(10) << mib(kindBytes[k]) << " MiB\n";
+    }
+    std::vector<std::pair<std::string, std::pair<size_t, size_t>>> cats(byCategory.begin(), byCategory.end());
+    std::sort(cats.begin(), cats.end(), [](const std::pair<std::string, std::pair<size_t, size_t>>& a,
+                                           const std::pair<std::string, std::pair<size_t, size_t>>& b) {
+        return a.second.second > b.second.second;
+    });
+    os << "    by owner:\n";
+    for (const auto& c : cats) {
+        os << "    " << std::left << std::setw(16) << c.first << std::right << std::setw(6) << c.second.first
+           << std::setw(10) << mib(c.second.second) << " MiB\n";
+    }
+    os.precision(p);
+    os.flags(f);
+}
+
+bool GpuResourceRegistry::reportLeaks(std::ostream& os) const {
+    if (live.empty()) return false;
+    os << "  gpu leaks      : " << live.size() << " objects (" << mib(currentBytes) << " MiB) not released:\n";
+    for (const auto& kv : live) {
+        const GpuResourceInfo& info = kv.second;
+        os << "    " << kindName(info.kind) << " #" << info.id << "  " << info.owner;
+        if (!info.format.empty()) os << "  [" << info.format << "]";
+        if (info.bytes) os << "  " << info.bytes << " bytes";
+        os << "\n";
+    }
+    return true;
+}
+
+template <GpuResourceKind K>
+GLuint GpuHandle<K>::create(const std::string& owner) {
+    reset();
+    name = genName(K);
+    gpuResources().track(K, name, owner);
+    return name;
+}
+
+template <GpuResourceKind K>
+void GpuHandle<K>::adopt(GLuint id, const std::string& owner) {
+    reset();
+    name = id;
+    gpuResources().track(K, name, owner);
+}
+
+template <GpuResourceKind K>
+void GpuHandle<K>::reset() {
+    if (!name) return;
+    gpuResources().untrack(K, name);
+    deleteName(K, name);
+    name = 0;
+}
+
+template class GpuHandle<GPU_BUFFER>;
+template class GpuHandle<GPU_VERTEX_ARRAY>;
+template class GpuHandle<GPU_TEXTURE>;
+template class GpuHandle<GPU_RENDERBUFFER>;
+template class GpuHandle<GPU_FRAMEBUFFER>;
+template class GpuHandle<GPU_PROGRAM>;
+
+void gpuBufferData(GLenum target, const GpuBuffer& buffer, size_t bytes, const void* data,
+                   GLenum usage, const std::string& format) {
+    glBindBuffer(target, buffer.get());
+    glBufferData(target, (GLsizeiptr)bytes, data, usage);
+    gpuResources().setSize(GPU_BUFFER, buffer.get(), bytes, format);
+}
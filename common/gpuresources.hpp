@@ -0,0 +1,94 @@
+#ifndef GPURESOURCES_HPP
+#define GPURESOURCES_HPP
+
+#include <cstddef>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+
+#include <glad/glad.h>
+
+enum GpuResourceKind {
+    GPU_BUFFER = 0,
+    GPU_VERTEX_ARRAY,
+    GPU_TEXTURE,
+    GPU_RENDERBUFFER,
+    GPU_FRAMEBUFFER,
+    GPU_PROGRAM,
+    GPU_KIND_COUNT
+};
+
+struct GpuResourceInfo {
+    GpuResourceKind kind = GPU_BUFFER;
+    GLuint id = 0;
+    size_t bytes = 0;          // what we asked the driver for (it may pad)
+    std::string format;        // "vertex", "index", "RGBA8 1024x1024 +mips", ...
+    std::string owner;         // "room", "mesh/bench/seat", "ring/per-draw", ...
+};
+
+// Every GL object the renderer creates, with the memory it was sized for. GL thread only.
+// Owners are free text; the part before the first '/' is the category of the breakdown.
+class GpuResourceRegistry {
+public:
+    void track(GpuResourceKind kind, GLuint id, const std::string& owner);
+    void setSize(GpuResourceKind kind, GLuint id, size_t bytes, const std::string& format);
+    void untrack(GpuResourceKind kind, GLuint id);
+
+    size_t liveCount() const { return live.size(); }
+    size_t liveBytes() const { return currentBytes; }
+    // Per kind and per owner category, plus the peak.
+    void report(std::ostream& os) const;
+    // Lists everything still alive; returns false if there was nothing to report.
+    bool reportLeaks(std::ostream& os) const;
+
+private:
+    std::map<std::pair<int, GLuint>, GpuResourceInfo> live;
+    size_t currentBytes = 0;
+    size_t peakBytes = 0;
+};
+
+GpuResourceRegistry& gpuResources();
+
+// Bytes of one w x h image in the given sized internal format (RGBA8, DEPTH24_STENCIL8...).
+size_t gpuImageBytes(GLenum internalFormat, int width, int height);
+
+// Owning, move-only GL object name. Generates on create(), deletes (and untracks) on
+// reset()/destruction. Destroy before the context goes away; anything still alive
+// then shows up in the leak report.
+template <GpuResourceKind K>
+class GpuHandle {
+public:
+    GpuHandle() {}
+    ~GpuHandle() { reset(); }
+    GpuHandle(GpuHandle&& o) noexcept : name(o.name) { o.name = 0; }
+    GpuHandle& operator=(GpuHandle&& o) noexcept {
+        if (this != &o) { reset(); name = o.name; o.name = 0; }
+        return *this;
+    }
+
+    GLuint create(const std::string& owner);
+    // Takes ownership of an existing name (e.g. from glCreateProgram).
+    void adopt(GLuint id, const std::string& owner);
+    void reset();
+    GLuint get() const { return name; }
+    explicit operator bool() const { return name != 0; }
+
+private:
+    GpuHandle(const GpuHandle&);
+    GpuHandle& operator=(const GpuHandle&);
+    GLuint name = 0;
+};
+
+typedef GpuHandle<GPU_BUFFER> GpuBuffer;
+typedef GpuHandle<GPU_VERTEX_ARRAY> GpuVertexArray;
+typedef GpuHandle<GPU_TEXTURE> GpuTexture;
+typedef GpuHandle<GPU_RENDERBUFFER> GpuRenderbuffer;
+typedef GpuHandle<GPU_FRAMEBUFFER> GpuFramebuffer;
+typedef GpuHandle<GPU_PROGRAM> GpuProgram;
+
+// glBindBuffer + glBufferData, recording the size against the buffer. Leaves it bound.
+void gpuBufferData(GLenum target, const GpuBuffer& buffer, size_t bytes, const void* data,
+                   GLenum usage, const std::string& format);
+
+#endif
@@ -0,0 +1,83 @@
+#include <algorithm>
+
+#include "gputimer.hpp"
+
+// Most recent spans kept for the statistics.
+static const size_t SAMPLE_WINDOW = 8192;
+
+static double percentile(std::vector<float> v, double p) {
+    if (v.empty()) return 0.0;
+    size_t k = (size_t)std::min((double)(v.size() - 1), p * (double)(v.size() - 1) + 0.5);
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+void GpuTimer::init(int depth) {
+    destroy();
+    queries.resize((size_t)std::max(2, depth));
+    glGenQueries((GLsizei)queries.size(), queries.data());
+    pending.assign(queries.size(), false);
+    samplesMs.reserve(1024);
+}
+
+void GpuTimer::destroy() {
+    if (!queries.empty()) glDeleteQueries((GLsizei)queries.size(), queries.data());
+    queries.clear();
+    pending.clear();
+    next = oldest = inFlight = 0;
+    open = false;
+}
+
+void GpuTimer::collect(bool wait) {
+    while (inFlight) {
+        GLuint q = queries[oldest];
+        if (!wait) {
+            GLint available = 0;
+            glGetQueryObjectiv(q, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) break;
+        }
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(q, GL_QUERY_RESULT, &ns);
+        float ms = (float)((double)ns * 1e-6);
+        if (samplesMs.size() < SAMPLE_WINDOW) samplesMs.push_back(ms);
+        else samplesMs[(size_t)(timed % SAMPLE_WINDOW)] = ms;
+        ++timed;
+        lastMs = ms;
+        pending[oldest] = false;
+        oldest = (oldest + 1) % queries.size();
+        --inFlight;
+    }
+}
+
+void GpuTimer::begin() {
+    if (queries.empty() || open) return;
+    collect(false);
+    if (pending[next]) { ++skipped; return; }
+    glBeginQuery(GL_TIME_ELAPSED, queries[next]);
+    open = true;
+}
+
+void GpuTimer::end() {
+    if (!open) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    open = false;
+    pending[next] = true;
+    next = (next + 1) % queries.size();
+    ++inFlight;
+}
+
+void GpuTimer::finish() {
+    if (open) end();
+    collect(true);
+}
+
+void GpuTimer::report(std::ostream& os, const std::string& label) const {
+    if (samplesMs.empty()) return;
+    double sum = 0.0;
+    for (float x : samplesMs) sum += x;
+    os << "  " << label << ": mean " << sum / (double)samplesMs.size() << " ms"
+       << ", p50 " << percentile(samplesMs, 0.50)
+       << ", p99 " << percentile(samplesMs, 0.99) << " ms";
+    if (skipped) os << " (" << skipped << " frames untimed, queries busy)";
+    os << "\n";
+}
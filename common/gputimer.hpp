@@ -0,0 +1,56 @@
+#ifndef GPUTIMER_HPP
+#define GPUTIMER_HPP
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+// GPU time of a span of GL commands, once per frame, through GL_TIME_ELAPSED queries.
+//
+// Results arrive a few frames late, so the timer keeps a small ring of queries and
+// collects whichever have finished at the start of each span; the CPU never waits for
+// the GPU. Spans that find every query of the ring still in flight are skipped (and
+// counted), not timed.
+//
+//   timer.begin();
+//   ... GL commands ...
+//   timer.end();
+class GpuTimer {
+public:
+    GpuTimer() {}
+    ~GpuTimer() { destroy(); }
+
+    void init(int depth = 4);
+    void destroy();
+    bool active() const { return !queries.empty(); }
+
+    void begin();
+    void end();
+    // Blocks until the spans still in flight are resolved (call before report at exit).
+    void finish();
+
+    // Spans resolved so far, and the GPU time of the most recent one (feedback loops).
+    unsigned long long resolved() const { return timed; }
+    float latestMs() const { return lastMs; }
+
+    // One line, "  <label>: mean/p50/p99 ms", nothing if no span was timed.
+    void report(std::ostream& os, const std::string& label) const;
+
+private:
+    GpuTimer(const GpuTimer&);
+    GpuTimer& operator=(const GpuTimer&);
+
+    void collect(bool wait);
+
+    std::vector<GLuint> queries;
+    std::vector<bool> pending;
+    size_t next = 0, oldest = 0, inFlight = 0;
+    bool open = false;
+    std::vector<float> samplesMs;
+    float lastMs = 0.0f;
+    unsigned long long timed = 0, skipped = 0;
+};
+
+#endif
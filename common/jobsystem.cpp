@@ -0,0 +1,99 @@
+#include <algorithm>
+
+#include "jobsystem.hpp"
+
+void JobSystem::start(int workers) {
+    stop();
+    if (workers < 0) {
+        unsigned hw = std::thread::hardware_concurrency();
+        workers = (hw > 1) ? (int)hw - 1 : 0;
+    }
+    quit = false;
+    for (int i = 0; i < workers; ++i) threads.push_back(std::thread(&JobSystem::workerLoop, this));
+}
+
+void JobSystem::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    workAvailable.notify_all();
+    for (auto& t : threads) t.join();
+    threads.clear();
+    // jobs nobody waited for are dropped with the pool
+    queue.clear();
+}
+
+JobHandle JobSystem::submit(std::function<void()> fn) {
+    JobHandle handle = std::make_shared<JobCounter>();
+    submit(handle, std::move(fn));
+    return handle;
+}
+
+void JobSystem::submit(const JobHandle& handle, std::function<void()> fn) {
+    handle->pending.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Job job;
+        job.fn = std::move(fn);
+        job.counter = handle;
+        queue.push_back(std::move(job));
+    }
+    workAvailable.notify_one();
+}
+
+bool JobSystem::runOne() {
+    Job job;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (queue.empty()) return false;
+        job = std::move(queue.front());
+        queue.pop_front();
+    }
+    job.fn();
+    if (job.counter->pending.fetch_sub(1) == 1) {
+        // notify under the lock so a waiter between its check and its wait can't miss it
+        std::lock_guard<std::mutex> lock(mutex);
+        jobFinished.notify_all();
+    }
+    return true;
+}
+
+void JobSystem::wait(const JobHandle& handle) {
+    if (!handle) return;
+    while (handle->pending.load() > 0) {
+        if (runOne()) continue;
+        std::unique_lock<std::mutex> lock(mutex);
+        jobFinished.wait(lock, [&] { return handle->pending.load() == 0 || !queue.empty(); });
+    }
+}
+
+void JobSystem::workerLoop() {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workAvailable.wait(lock, [this] { return quit || !queue.empty(); });
+            if (quit) return;
+        }
+        runOne();
+    }
+}
+
+void JobSystem::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn) {
+    if (count == 0) return;
+    grain = std::max<size_t>(grain, 1);
+    size_t chunks = std::min((count + grain - 1) / grain, (size_t)(workerCount() + 1) * 4);
+    if (chunks <= 1) {
+        fn(0, count);
+        return;
+    }
+    size_t chunkSize = (count + chunks - 1) / chunks;
+    JobHandle handle = std::make_shared<JobCounter>();
+    for (size_t begin = chunkSize; begin < count; begin += chunkSize) {
+        size_t end = std::min(count, begin + chunkSize);
+        submit(handle, [&fn, begin, end] { fn(begin, end); });
+    }
+    // the caller takes the first chunk itself
+    fn(0, std::min(count, chunkSize));
+    wait(handle);
+}
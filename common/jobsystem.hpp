@@ -0,0 +1,59 @@
+#ifndef JOBSYSTEM_HPP
+#define JOBSYSTEM_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Counts the unfinished jobs of one submission; wait() on it to join them.
+struct JobCounter {
+    std::atomic<int> pending;
+    JobCounter() : pending(0) {}
+};
+typedef std::shared_ptr<JobCounter> JobHandle;
+
+// Small fixed-size thread pool shared by the renderer's CPU-side work.
+// Waiting threads (including the GL thread) run queued jobs instead of sleeping,
+// so nested parallelFor calls from inside a job cannot deadlock. With zero workers
+// every job simply runs inside wait(), i.e. the renderer falls back to serial.
+class JobSystem {
+public:
+    JobSystem() : quit(false) {}
+    ~JobSystem() { stop(); }
+
+    // workers < 0: one per hardware thread minus the caller's
+    void start(int workers = -1);
+    void stop();
+    unsigned workerCount() const { return (unsigned)threads.size(); }
+
+    JobHandle submit(std::function<void()> fn);
+    // Adds fn to an existing submission.
+    void submit(const JobHandle& handle, std::function<void()> fn);
+    void wait(const JobHandle& handle);
+
+    // Runs fn(begin, end) over [0, count) in chunks of at least `grain`, blocks until done.
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn);
+
+private:
+    struct Job {
+        std::function<void()> fn;
+        JobHandle counter;
+    };
+
+    bool runOne();
+    void workerLoop();
+
+    std::vector<std::thread> threads;
+    std::deque<Job> queue;
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable jobFinished;
+    bool quit;
+};
+
+#endif
@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include <glad/glad.h>
+
+#include "scenestore.hpp"
+#include "lightculling.hpp"
+
+namespace {
+
+float luminance(const glm::vec3& c) {
+    return glm::dot(c, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+}
+
+float attenuate(float dist, const LightAttenuation& att) {
+    return 1.0f / (att.constant + att.linear * dist + att.quadratic * dist * dist);
+}
+
+} // namespace
+
+float lightEffectiveRadius(const glm::vec3& color, float threshold, const LightAttenuation& att) {
+    float lum = luminance(color);
+    if (threshold <= 0.0f) return 1e30f;           // never cull
+    float k = lum / threshold;                       // want constant + linear*d + quadratic*d^2 = k
+    if (k <= att.constant) return 0.0f;              // below threshold even at the light
+    if (att.quadratic <= 0.0f) {
+        return att.linear > 0.0f ? (k - att.constant) / att.linear : 1e30f;
+    }
+    float disc = att.linear * att.linear + 4.0f * att.quadratic * (k - att.constant);
+    return (-att.linear + std::sqrt(disc)) / (2.0f * att.quadratic);
+}
+
+int gatherDrawLights(const SceneStore& scene, const glm::vec3& mn, const glm::vec3& mx,
+                     uint32_t out[MAX_DRAW_LIGHTS]) {
+    const LightAttenuation att;
+    float strength[MAX_DRAW_LIGHTS];
+    int count = 0;
+
+    auto consider = [&](uint32_t l) {
+        const glm::vec3& p = scene.lightPosition[l];
+        float r = scene.lightRadius[l];
+        glm::vec3 closest = glm::clamp(p, mn, mx);
+        glm::vec3 dv = closest - p;
+        float d2 = glm::dot(dv, dv);
+        if (d2 > r * r) return;
+        // a light spanning several of the box's cells comes up once per cell
+        for (int k = 0; k < count; ++k) {
+            if (out[k] == l) return;
+        }
+
+        // keep the list sorted by the light's strength at the nearest point of the box
+        float s = luminance(scene.lightColor[l]) * attenuate(std::sqrt(d2), att);
+        int pos = count;
+        while (pos > 0 && strength[pos - 1] < s) --pos;
+        if (pos >= MAX_DRAW_LIGHTS) return;
+        int last = std::min(count, MAX_DRAW_LIGHTS - 1);
+        for (int k = last; k > pos; --k) {
+            out[k] = out[k - 1];
+            strength[k] = strength[k - 1];
+        }
+        out[pos] = l;
+        strength[pos] = s;
+        if (count < MAX_DRAW_LIGHTS) ++count;
+    };
+
+    const LightGrid& grid = scene.lightGrid;
+    if (grid.width == 0) {
+        // no grid (unbounded radii): every light is a candidate
+        for (size_t l = 0; l < scene.lightCount(); ++l) consider((uint32_t)l);
+        return count;
+    }
+    int x0, z0, x1, z1;
+    grid.cellOf(mn.x, mn.z, x0, z0);
+    grid.cellOf(mx.x, mx.z, x1, z1);
+    for (int z = z0; z <= z1; ++z) {
+        for (int x = x0; x <= x1; ++x) {
+            size_t cell = (size_t)z * (size_t)grid.width + (size_t)x;
+            for (uint32_t i = grid.cellStart[cell]; i < grid.cellStart[cell + 1]; ++i) consider(grid.lights[i]);
+        }
+    }
+    return count;
+}
+
+void uploadFrameLights(const SceneStore& scene, const std::vector<uint32_t>& frameLights, unsigned int ubo) {
+    static LightsBlock block;
+    const size_t n = std::min(frameLights.size(), (size_t)MAX_FRAME_LIGHTS);
+    for (size_t slot = 0; slot < n; ++slot) {
+        uint32_t l = frameLights[slot];
+        block.positionRadius[slot] = glm::vec4(scene.lightPosition[l], scene.lightRadius[l]);
+        block.color[slot] = glm::vec4(scene.lightColor[l], 1.0f);
+    }
+    // only the used prefix of each array changes
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, n * sizeof(glm::vec4), block.positionRadius);
+    glBufferSubData(GL_UNIFORM_BUFFER, offsetof(LightsBlock, color), n * sizeof(glm::vec4), block.color);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
@@ -0,0 +1,46 @@
+#ifndef LIGHTCULLING_HPP
+#define LIGHTCULLING_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class SceneStore;
+
+// Must match the shaders' Lights/PerDraw blocks (MAX_FRAME_LIGHTS, MAX_DRAW_LIGHTS).
+// The scene may hold any number of lights; each frame uploads only the ones its draws
+// reference, up to MAX_FRAME_LIGHTS (16 KiB, the smallest uniform block GL 3.3 allows).
+const int MAX_FRAME_LIGHTS = 512;
+const int MAX_DRAW_LIGHTS = 8;
+const unsigned int LIGHTS_BINDING = 1;
+
+// Point light falloff used by the shaders: 1 / (constant + linear*d + quadratic*d^2).
+struct LightAttenuation {
+    float constant = 1.0f;
+    float linear = 0.09f;
+    float quadratic = 0.032f;
+};
+
+// Distance at which a light of `color` drops below `threshold` luminance. The shaders
+// fade the light to zero at this radius, so culling it beyond is invisible.
+float lightEffectiveRadius(const glm::vec3& color, float threshold,
+                           const LightAttenuation& att = LightAttenuation());
+
+// Lights of the scene whose sphere touches the world AABB [mn, mx], strongest first,
+// at most MAX_DRAW_LIGHTS. Only the lights of the grid cells the box overlaps are tested
+// (see SceneStore::lightGrid). Returns the number of scene light ids written to `out`.
+int gatherDrawLights(const SceneStore& scene, const glm::vec3& mn, const glm::vec3& mx,
+                     uint32_t out[MAX_DRAW_LIGHTS]);
+
+// std140 layout of the shaders' Lights uniform block.
+struct LightsBlock {
+    glm::vec4 positionRadius[MAX_FRAME_LIGHTS];  // xyz = world position, w = effective radius
+    glm::vec4 color[MAX_FRAME_LIGHTS];
+};
+
+// GL thread only: writes the listed scene lights, in order, into `ubo` (a LightsBlock
+// sized buffer); draws index them by their position in `frameLights`.
+void uploadFrameLights(const SceneStore& scene, const std::vector<uint32_t>& frameLights, unsigned int ubo);
+
+#endif
@@ -0,0 +1,563 @@
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <numeric>
+#include <tuple>
+
+#include "bvh.hpp"
+#include "jobsystem.hpp"
+#include "lightculling.hpp"
+#include "scenestore.hpp"
+#include "lightmap.hpp"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+const uint32_t FILE_VERSION = 1;
+// textures only live on the GPU; textured surfaces bounce as a mid grey
+const float TEXTURED_ALBEDO = 0.6f;
+
+template <typename T>
+uint64_t hashVector(uint64_t h, const std::vector<T>& v) {
+    return v.empty() ? h : bakeHashBytes(h, v.data(), v.size() * sizeof(T));
+}
+
+// Direction around `n` with density cos(theta) / pi (unit `n`).
+glm::vec3 cosineDirection(const glm::vec3& n, BakeRandom& rng) {
+    // orthonormal basis without branches on the normal's direction (Duff et al. 2017)
+    float sign = std::copysign(1.0f, n.z);
+    float a = -1.0f / (sign + n.z);
+    float b = n.x * n.y * a;
+    glm::vec3 t(1.0f + sign * n.x * n.x * a, sign * b, -sign * n.x);
+    glm::vec3 bt(b, sign + n.y * n.y * a, -n.y);
+    float u = rng.next(), phi = 6.2831853f * rng.next();
+    float r = std::sqrt(u);
+    return t * (r * std::cos(phi)) + bt * (r * std::sin(phi)) + n * std::sqrt(std::max(0.0f, 1.0f - u));
+}
+
+// Shelf packing, tallest first, into a strip `width` wide with `gap` between
+// rectangles. Returns the height used; `usedWidth` is the widest shelf.
+float shelfPack(const std::vector<glm::vec2>& sizes, float width, float gap, std::vector<glm::vec2>& offsets,
+                float& usedWidth) {
+    std::vector<size_t> order(sizes.size());
+    std::iota(order.begin(), order.end(), (size_t)0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sizes[a].y > sizes[b].y; });
+    offsets.assign(sizes.size(), glm::vec2(0.0f));
+    float x = 0.0f, y = 0.0f, row = 0.0f;
+    usedWidth = 0.0f;
+    for (size_t i : order) {
+        if (x > 0.0f && x + sizes[i].x > width) {
+            y += row + gap;
+            x = 0.0f;
+            row = 0.0f;
+        }
+        offsets[i] = glm::vec2(x, y);
+        usedWidth = std::max(usedWidth, x + sizes[i].x);
+        x += sizes[i].x + gap;
+        row = std::max(row, sizes[i].y);
+    }
+    return y + row;
+}
+
+int roundUpPow2(int v) {
+    int p = 1;
+    while (p < v) p <<= 1;
+    return p;
+}
+
+} // namespace
+
+BakeRandom::BakeRandom(uint32_t seed) : state(seed ? seed : 0x9E3779B9u) {}
+
+float BakeRandom::next() {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return (float)(state >> 8) * (1.0f / 16777216.0f);
+}
+
+uint32_t bakeHash(uint32_t x) {
+    x ^= x >> 16; x *= 0x7feb352du;
+    x ^= x >> 15; x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// FNV-1a
+uint64_t bakeHashBytes(uint64_t h, const void* data, size_t size) {
+    const unsigned char* p = (const unsigned char*)data;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+uint64_t bakeSceneKey(const SceneStore& scene) {
+    uint64_t h = 14695981039346656037ull;
+    h = hashVector(h, scene.world);
+    h = hashVector(h, scene.mesh);
+    h = hashVector(h, scene.material);
+    h = hashVector(h, scene.lightNode);
+    h = hashVector(h, scene.lightColor);
+    h = hashVector(h, scene.lightRadius);
+    for (const Material& mat : scene.materials) {
+        h = bakeHashBytes(h, &mat.color, sizeof(mat.color));
+        h = bakeHashBytes(h, &mat.hasTexture, sizeof(mat.hasTexture));
+    }
+    return h;
+}
+
+glm::vec3 bakeAlbedo(const SceneStore& scene, uint32_t node) {
+    uint32_t mat = scene.material[node];
+    if (mat == SCENE_NONE) return glm::vec3(TEXTURED_ALBEDO);
+    const Material& m = scene.materials[mat];
+    return m.hasTexture ? glm::vec3(TEXTURED_ALBEDO) : glm::clamp(m.color, glm::vec3(0.0f), glm::vec3(1.0f));
+}
+
+float bakeFalloff(const SceneStore& scene, uint32_t light, float d) {
+    const LightAttenuation att;
+    float r = scene.lightRadius[light];
+    if (d >= r) return 0.0f;
+    float a = 1.0f / (att.constant + att.linear * d + att.quadratic * d * d);
+    float fade = glm::clamp(1.0f - std::pow(d / r, 4.0f), 0.0f, 1.0f);
+    return a * fade * fade;
+}
+
+float bakeVisibility(const SceneStore& scene, const SceneBVH& rays, uint32_t light, const glm::vec3& from, int samples,
+                     BakeRandom& rng, unsigned long long& traced) {
+    uint32_t node = scene.lightNode[light];
+    const glm::vec3 &mn = scene.boundsMin[node], &mx = scene.boundsMax[node];
+    const bool volume = mn.x <= mx.x;
+    samples = std::max(1, samples);
+    int visible = 0;
+    for (int s = 0; s < samples; ++s) {
+        glm::vec3 to = volume ? mn + (mx - mn) * glm::vec3(rng.next(), rng.next(), rng.next()) : scene.lightPosition[light];
+        ++traced;
+        if (!rays.occluded(from, to, node)) ++visible;
+    }
+    return (float)visible / (float)samples;
+}
+
+glm::vec3 bakeDirectLight(const SceneStore& scene, const SceneBVH& rays, const glm::vec3& p, const glm::vec3& n,
+                          int shadowSamples, BakeRandom& rng, unsigned long long& traced) {
+    glm::vec3 sum(0.0f);
+    const glm::vec3 from = p + n * BAKE_SURFACE_EPSILON;
+    auto light = [&](uint32_t l) {
+        glm::vec3 L = scene.lightPosition[l] - p;
+        float d = glm::length(L);
+        if (d < 1e-4f) return;
+        float ndl = glm::dot(n, L / d);
+        float falloff = bakeFalloff(scene, l, d);
+        if (ndl <= 0.0f || falloff <= 0.0f) return;
+        sum += scene.lightColor[l] * (ndl * falloff * bakeVisibility(scene, rays, l, from, shadowSamples, rng, traced));
+    };
+    const LightGrid& grid = scene.lightGrid;
+    if (grid.width == 0) {
+        for (uint32_t l = 0; l < (uint32_t)scene.lightCount(); ++l) light(l);
+        return sum;
+    }
+    int cx, cz;
+    grid.cellOf(p.x, p.z, cx, cz);
+    size_t cell = (size_t)cz * (size_t)grid.width + (size_t)cx;
+    for (uint32_t k = grid.cellStart[cell]; k < grid.cellStart[cell + 1]; ++k) light(grid.lights[k]);
+    return sum;
+}
+
+bool Lightmap::save(const std::string& path) const {
+    std::ofstream f(path.c_str(), std::ios::binary);
+    if (!f) return false;
+    int32_t size[2] = { width, height };
+    f.write("LMAP", 4);
+    f.write((const char*)&FILE_VERSION, sizeof(FILE_VERSION));
+    f.write((const char*)&key, sizeof(key));
+    f.write((const char*)size, sizeof(size));
+    f.write((const char*)texels.data(), texels.size() * sizeof(glm::vec4));
+    return (bool)f;
+}
+
+bool Lightmap::load(const std::string& path) {
+    std::ifstream f(path.c_str(), std::ios::binary);
+    if (!f) return false;
+    char magic[4];
+    uint32_t version = 0;
+    uint64_t fileKey = 0;
+    int32_t size[2] = { 0, 0 };
+    f.read(magic, 4);
+    f.read((char*)&version, sizeof(version));
+    f.read((char*)&fileKey, sizeof(fileKey));
+    f.read((char*)size, sizeof(size));
+    if (!f || std::memcmp(magic, "LMAP", 4) != 0 || version != FILE_VERSION || fileKey != key ||
+        size[0] != width || size[1] != height) {
+        return false;
+    }
+    std::vector<glm::vec4> data((size_t)width * (size_t)height);
+    f.read((char*)data.data(), data.size() * sizeof(glm::vec4));
+    if (!f) return false;
+    texels.swap(data);
+    return true;
+}
+
+void LightmapBaker::setMesh(uint32_t meshId, const std::vector<glm::vec3>& positions,
+                            const std::vector<glm::vec3>& normals, const std::vector<uint32_t>& indices) {
+    if (meshId >= meshes.size()) meshes.resize(meshId + 1);
+    Mesh& m = meshes[meshId];
+    m.positions = positions;
+    m.normals = normals.size() == positions.size() ? normals : std::vector<glm::vec3>();
+    m.indices.assign(indices.begin(), indices.end() - indices.size() % 3);
+    buildCharts(m);
+}
+
+// Triangles facing the same major axis that touch each other form a chart, projected
+// onto that axis' plane. The index buffer is drawn as is, so a vertex shared by two
+// differently facing triangles (smooth shading over an edge) ties them into one chart,
+// projected along its dominant axis.
+void LightmapBaker::buildCharts(Mesh& m) {
+    m.charts.clear();
+    m.vertexChart.assign(m.positions.size(), SCENE_NONE);
+    m.projected.assign(m.positions.size(), glm::vec2(0.0f));
+    const size_t triangleCount = m.indices.size() / 3;
+    if (!triangleCount) return;
+
+    std::vector<glm::vec3> faceNormal(triangleCount);
+    std::vector<uint32_t> parent(triangleCount);
+    std::iota(parent.begin(), parent.end(), 0u);
+    auto find = [&](uint32_t t) {
+        while (parent[t] != t) t = parent[t] = parent[parent[t]];
+        return t;
+    };
+    auto unite = [&](uint32_t a, uint32_t b) {
+        a = find(a);
+        b = find(b);
+        if (a != b) parent[std::max(a, b)] = std::min(a, b);
+    };
+
+    // neighbours: same facing and a corner at the same (quantized) position, or the
+    // very same vertex
+    std::map<std::tuple<int, long long, long long, long long>, uint32_t> corners;
+    std::vector<uint32_t> vertexTriangle(m.positions.size(), SCENE_NONE);
+    for (uint32_t t = 0; t < triangleCount; ++t) {
+        const uint32_t* tri = &m.indices[3 * t];
+        const glm::vec3 &a = m.positions[tri[0]], &b = m.positions[tri[1]], &c = m.positions[tri[2]];
+        glm::vec3 n = glm::cross(b - a, c - a);
+        // orient by the vertex normals: the winding of the hand-made meshes isn't consistent
+        if (!m.normals.empty() && glm::dot(n, m.normals[tri[0]] + m.normals[tri[1]] + m.normals[tri[2]]) < 0.0f) n = -n;
+        faceNormal[t] = n;
+        glm::vec3 an = glm::abs(n);
+        int axis = an.x >= an.y && an.x >= an.z ? 0 : (an.y >= an.z ? 1 : 2);
+        int facing = axis * 2 + (n[axis] < 0.0f ? 1 : 0);
+        for (int k = 0; k < 3; ++k) {
+            const glm::vec3& p = m.positions[tri[k]];
+            auto key = std::make_tuple(facing, std::llround(p.x * 1e4), std::llround(p.y * 1e4), std::llround(p.z * 1e4));
+            auto it = corners.insert(std::make_pair(key, t)).first;
+            unite(t, it->second);
+            if (vertexTriangle[tri[k]] == SCENE_NONE) vertexTriangle[tri[k]] = t;
+            else unite(t, vertexTriangle[tri[k]]);
+        }
+    }
+
+    // number the charts and pick each one's projection axis
+    std::vector<uint32_t> chartOf(triangleCount, SCENE_NONE);
+    std::vector<glm::vec3> chartNormal;
+    for (uint32_t t = 0; t < triangleCount; ++t) {
+        uint32_t root = find(t);
+        if (chartOf[root] == SCENE_NONE) {
+            chartOf[root] = (uint32_t)chartNormal.size();
+            chartNormal.push_back(glm::vec3(0.0f));
+        }
+        chartOf[t] = chartOf[root];
+        chartNormal[chartOf[t]] += glm::abs(faceNormal[t]);
+    }
+    m.charts.resize(chartNormal.size());
+    for (Chart& c : m.charts) {
+        c.min = glm::vec2(FLT_MAX);
+        c.max = glm::vec2(-FLT_MAX);
+        c.offset = glm::vec2(0.0f);
+    }
+    for (uint32_t t = 0; t < triangleCount; ++t) {
+        uint32_t chart = chartOf[t];
+        const glm::vec3& n = chartNormal[chart];
+        int axis = n.x >= n.y && n.x >= n.z ? 0 : (n.y >= n.z ? 1 : 2);
+        for (int k = 0; k < 3; ++k) {
+            uint32_t v = m.indices[3 * t + k];
+            const glm::vec3& p = m.positions[v];
+            glm::vec2 uv(p[(axis + 1) % 3], p[(axis + 2) % 3]);
+            m.vertexChart[v] = chart;
+            m.projected[v] = uv;
+            m.charts[chart].min = glm::min(m.charts[chart].min, uv);
+            m.charts[chart].max = glm::max(m.charts[chart].max, uv);
+        }
+    }
+}
+
+bool LightmapBaker::layout(const SceneStore& scene, const LightmapConfig& config, Lightmap& out) {
+    cfg = config;
+    baked = false;
+    out = Lightmap();
+    out.meshUV.resize(meshes.size());
+    out.nodeScaleOffset.assign(scene.nodeCount(), glm::vec4(0.0f));
+
+    // static mesh nodes that don't carry a light (bulbs are emissive), with their scale
+    std::vector<uint8_t> isLight(scene.nodeCount(), 0);
+    for (uint32_t node : scene.lightNode) isLight[node] = 1;
+    std::vector<uint32_t> nodes;
+    std::vector<float> nodeScale;
+    std::vector<float> meshMinScale(meshes.size(), FLT_MAX);
+    for (uint32_t i = 0; i < (uint32_t)scene.nodeCount(); ++i) {
+        uint32_t mesh = scene.mesh[i];
+        if (mesh == SCENE_NONE || mesh >= meshes.size() || meshes[mesh].charts.empty()) continue;
+        if (isLight[i] || !(scene.flags[i] & NODE_STATIC)) continue;
+        const glm::mat4& w = scene.world[i];
+        float s = std::max(glm::length(glm::vec3(w[0])), std::max(glm::length(glm::vec3(w[1])), glm::length(glm::vec3(w[2]))));
+        if (!(s > 0.0f)) continue;
+        nodes.push_back(i);
+        nodeScale.push_back(s);
+        meshMinScale[mesh] = std::min(meshMinScale[mesh], s);
+    }
+    instances = nodes.size();
+    charts = 0;
+    if (nodes.empty()) return false;
+
+    std::vector<glm::vec2> layoutSize(meshes.size(), glm::vec2(0.0f));
+    std::vector<glm::vec2> sizes, offsets;
+    float density = cfg.texelsPerMeter;
+    for (int attempt = 0; attempt < 64; ++attempt, density *= 0.85f) {
+        // chart layout of each mesh, in local units; the gap is `padding` texels on
+        // the smallest instance
+        for (size_t mesh = 0; mesh < meshes.size(); ++mesh) {
+            if (meshMinScale[mesh] == FLT_MAX) continue;
+            Mesh& m = meshes[mesh];
+            float gap = (float)cfg.padding / (density * meshMinScale[mesh]);
+            float area = 0.0f, widest = 0.0f;
+            sizes.resize(m.charts.size());
+            for (size_t c = 0; c < m.charts.size(); ++c) {
+                sizes[c] = m.charts[c].max - m.charts[c].min;
+                area += (sizes[c].x + gap) * (sizes[c].y + gap);
+                widest = std::max(widest, sizes[c].x);
+            }
+            float used = 0.0f;
+            float height = shelfPack(sizes, std::max(widest, std::sqrt(area)), gap, offsets, used);
+            for (size_t c = 0; c < m.charts.size(); ++c) m.charts[c].offset = offsets[c];
+            layoutSize[mesh] = glm::max(glm::vec2(used, height), glm::vec2(1e-6f));
+        }
+
+        // one rectangle per instance, whole texels plus the padding
+        sizes.resize(nodes.size());
+        float area = 0.0f, widest = 0.0f;
+        for (size_t k = 0; k < nodes.size(); ++k) {
+            glm::vec2 texels = layoutSize[scene.mesh[nodes[k]]] * nodeScale[k] * density;
+            sizes[k] = glm::ceil(texels) + glm::vec2(1.0f);
+            area += (sizes[k].x + cfg.padding) * (sizes[k].y + cfg.padding);
+            widest = std::max(widest, sizes[k].x);
+        }
+        if (widest > (float)cfg.maxAtlasSize) continue;
+        int width = std::min(cfg.maxAtlasSize, std::max(64, roundUpPow2((int)std::ceil(std::max(widest, std::sqrt(area * 1.1f))))));
+        float used = 0.0f, height = 0.0f;
+        for (;; width *= 2) {
+            height = shelfPack(sizes, (float)width, (float)cfg.padding, offsets, used);
+            if (height <= (float)width || width * 2 > cfg.maxAtlasSize) break;
+        }
+        if (height > (float)cfg.maxAtlasSize) continue;
+
+        out.width = width;
+        out.height = std::max(4, ((int)std::ceil(height) + 3) & ~3);
+        out.texelsPerMeter = density;
+        const glm::vec2 atlas((float)out.width, (float)out.height);
+        for (size_t k = 0; k < nodes.size(); ++k) {
+            glm::vec2 texels = layoutSize[scene.mesh[nodes[k]]] * nodeScale[k] * density;
+            out.nodeScaleOffset[nodes[k]] = glm::vec4(texels / atlas, offsets[k] / atlas);
+        }
+        for (size_t mesh = 0; mesh < meshes.size(); ++mesh) {
+            if (meshMinScale[mesh] == FLT_MAX) continue;
+            const Mesh& m = meshes[mesh];
+            std::vector<glm::vec2>& uv = out.meshUV[mesh];
+            uv.assign(m.positions.size(), glm::vec2(0.0f));
+            for (size_t v = 0; v < m.positions.size(); ++v) {
+                if (m.vertexChart[v] == SCENE_NONE) continue;
+                const Chart& c = m.charts[m.vertexChart[v]];
+                uv[v] = (c.offset + m.projected[v] - c.min) / layoutSize[mesh];
+            }
+            charts += m.charts.size();
+        }
+
+        // the cache is valid for this layout, scene and these bake settings only
+        uint64_t h = bakeSceneKey(scene);
+        h = bakeHashBytes(h, &out.width, sizeof(out.width));
+        h = bakeHashBytes(h, &out.height, sizeof(out.height));
+        h = bakeHashBytes(h, &cfg, sizeof(cfg));
+        h = hashVector(h, out.nodeScaleOffset);
+        for (const Mesh& m : meshes) {
+            h = hashVector(h, m.positions);
+            h = hashVector(h, m.indices);
+        }
+        out.key = h;
+        return true;
+    }
+    return false;
+}
+
+void LightmapBaker::bake(const SceneStore& scene, const SceneBVH& rays, JobSystem& jobs, Lightmap& out) {
+    Clock::time_point start = Clock::now();
+    const int W = out.width, H = out.height;
+    out.texels.assign((size_t)W * (size_t)H, glm::vec4(0.0f));
+    threads = jobs.workerCount() + 1;
+
+    // 1. rasterize every lightmapped instance into the atlas: one world position and
+    // normal per covered texel centre
+    struct Sample {
+        glm::vec3 position, normal;
+        uint32_t texel;
+    };
+    std::vector<Sample> samples;
+    std::vector<uint8_t> covered((size_t)W * (size_t)H, 0);
+    const glm::vec2 atlas((float)W, (float)H);
+    for (uint32_t i = 0; i < (uint32_t)out.nodeScaleOffset.size(); ++i) {
+        const glm::vec4& so = out.nodeScaleOffset[i];
+        if (so.x <= 0.0f) continue;
+        const Mesh& m = meshes[scene.mesh[i]];
+        const std::vector<glm::vec2>& uv = out.meshUV[scene.mesh[i]];
+        const glm::mat4& world = scene.world[i];
+        const glm::mat3 normalMatrix(scene.normalMatrix[i]);
+        for (size_t t = 0; t + 2 < m.indices.size(); t += 3) {
+            const uint32_t* tri = &m.indices[t];
+            glm::vec2 p[3];
+            glm::vec3 wp[3], wn[3];
+            for (int k = 0; k < 3; ++k) {
+                p[k] = (uv[tri[k]] * glm::vec2(so.x, so.y) + glm::vec2(so.z, so.w)) * atlas;
+                wp[k] = glm::vec3(world * glm::vec4(m.positions[tri[k]], 1.0f));
+            }
+            glm::vec3 face = glm::cross(wp[1] - wp[0], wp[2] - wp[0]);
+            if (glm::dot(face, face) < 1e-20f) continue;
+            for (int k = 0; k < 3; ++k) {
+                wn[k] = m.normals.empty() ? face : normalMatrix * m.normals[tri[k]];
+            }
+            float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[2].x - p[0].x) * (p[1].y - p[0].y);
+            if (std::fabs(area) < 1e-12f) continue;
+
+            auto addSample = [&](int x, int y, float w0, float w1, float w2) {
+                size_t texel = (size_t)y * (size_t)W + (size_t)x;
+                if (covered[texel]) return;
+                covered[texel] = 1;
+                Sample s;
+                s.position = wp[0] * w0 + wp[1] * w1 + wp[2] * w2;
+                s.normal = wn[0] * w0 + wn[1] * w1 + wn[2] * w2;
+                float len = glm::length(s.normal);
+                s.normal = len > 0.0f ? s.normal / len : glm::normalize(face);
+                s.texel = (uint32_t)texel;
+                samples.push_back(s);
+            };
+            int x0 = std::max(0, (int)std::floor(std::min(p[0].x, std::min(p[1].x, p[2].x))));
+            int y0 = std::max(0, (int)std::floor(std::min(p[0].y, std::min(p[1].y, p[2].y))));
+            int x1 = std::min(W - 1, (int)std::ceil(std::max(p[0].x, std::max(p[1].x, p[2].x))));
+            int y1 = std::min(H - 1, (int)std::ceil(std::max(p[0].y, std::max(p[1].y, p[2].y))));
+            bool any = false;
+            for (int y = y0; y <= y1; ++y) {
+                for (int x = x0; x <= x1; ++x) {
+                    glm::vec2 c((float)x + 0.5f, (float)y + 0.5f);
+                    float w0 = ((p[1].x - c.x) * (p[2].y - c.y) - (p[2].x - c.x) * (p[1].y - c.y)) / area;
+                    float w1 = ((p[2].x - c.x) * (p[0].y - c.y) - (p[0].x - c.x) * (p[2].y - c.y)) / area;
+                    float w2 = 1.0f - w0 - w1;
+                    if (w0 < -1e-4f || w1 < -1e-4f || w2 < -1e-4f) continue;
+                    addSample(x, y, w0, w1, w2);
+                    any = true;
+                }
+            }
+            // a sliver between texel centres still gets the texel under its centroid
+            if (!any) {
+                glm::vec2 c = (p[0] + p[1] + p[2]) / 3.0f;
+                addSample(glm::clamp((int)c.x, 0, W - 1), glm::clamp((int)c.y, 0, H - 1), 1.0f / 3, 1.0f / 3, 1.0f / 3);
+            }
+        }
+    }
+
+    // 2. trace: direct light with soft shadows from the bulb volumes, plus diffuse paths
+    std::vector<uint8_t> isLight(scene.nodeCount(), 0);
+    for (uint32_t node : scene.lightNode) isLight[node] = 1;
+    std::atomic<unsigned long long> traced(0);
+    const int shadowSamples = std::max(1, cfg.shadowSamples);
+    jobs.parallelFor(samples.size(), 64, [&](size_t begin, size_t end) {
+        unsigned long long local = 0;
+        for (size_t i = begin; i < end; ++i) {
+            const Sample& s = samples[i];
+            BakeRandom rng(bakeHash(s.texel * 0x9E3779B9u ^ cfg.seed));
+            glm::vec3 E = bakeDirectLight(scene, rays, s.position, s.normal, shadowSamples, rng, local);
+
+            // cosine-weighted paths: each hit adds its albedo times the direct light there
+            glm::vec3 indirect(0.0f);
+            for (int k = 0; k < cfg.indirectSamples; ++k) {
+                glm::vec3 pos = s.position + s.normal * BAKE_SURFACE_EPSILON, nrm = s.normal, throughput(1.0f);
+                for (int b = 0; b < cfg.bounces; ++b) {
+                    Ray ray;
+                    ray.origin = pos;
+                    ray.direction = cosineDirection(nrm, rng);
+                    RayHit hit;
+                    ++local;
+                    // the bulbs' own light is already the direct term
+                    if (!rays.intersect(ray, hit) || isLight[hit.node]) break;
+                    throughput *= bakeAlbedo(scene, hit.node);
+                    indirect += throughput * bakeDirectLight(scene, rays, hit.position, hit.normal, 1, rng, local);
+                    pos = hit.position + hit.normal * BAKE_SURFACE_EPSILON;
+                    nrm = hit.normal;
+                }
+            }
+            if (cfg.indirectSamples > 0) E += indirect / (float)cfg.indirectSamples;
+            out.texels[s.texel] = glm::vec4(E, 1.0f);
+        }
+        traced += local;
+    });
+
+    // 3. dilate into the padding so bilinear filtering at chart edges doesn't pull in black
+    std::vector<glm::vec4> source;
+    for (int pass = 0; pass < std::max(1, cfg.padding); ++pass) {
+        source = out.texels;
+        for (int y = 0; y < H; ++y) {
+            for (int x = 0; x < W; ++x) {
+                if (source[(size_t)y * W + x].a > 0.0f) continue;
+                glm::vec3 sum(0.0f);
+                int n = 0;
+                for (int dy = -1; dy <= 1; ++dy) {
+                    for (int dx = -1; dx <= 1; ++dx) {
+                        int nx = x + dx, ny = y + dy;
+                        if (nx < 0 || ny < 0 || nx >= W || ny >= H) continue;
+                        const glm::vec4& t = source[(size_t)ny * W + nx];
+                        if (t.a <= 0.0f) continue;
+                        sum += glm::vec3(t);
+                        ++n;
+                    }
+                }
+                if (n) out.texels[(size_t)y * W + x] = glm::vec4(sum / (float)n, 1.0f);
+            }
+        }
+    }
+
+    bakedTexels = samples.size();
+    raysTraced = traced;
+    bakeMs = msSince(start);
+    baked = true;
+}
+
+void LightmapBaker::report(std::ostream& os) const {
+    if (!instances) return;
+    size_t meshCount = 0;
+    for (const Mesh& m : meshes) {
+        if (!m.charts.empty()) ++meshCount;
+    }
+    os << "  lightmap       : " << instances << " instances, " << charts << " charts over " << meshCount << " meshes, ";
+    if (baked) {
+        os << bakedTexels << " texels baked in " << bakeMs << " ms on " << threads << " threads ("
+           << (bakeMs > 0.0 ? (double)raysTraced / (bakeMs * 1000.0) : 0.0) << " Mrays/s, " << cfg.indirectSamples
+           << " paths x " << cfg.bounces << " bounces, " << cfg.shadowSamples << " shadow rays)\n";
+    } else {
+        os << "read from the cache file\n";
+    }
+}
@@ -0,0 +1,111 @@
+#ifndef LIGHTMAP_HPP
+#define LIGHTMAP_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class JobSystem;
+class SceneBVH;
+class SceneStore;
+
+struct LightmapConfig {
+    float texelsPerMeter = 8.0f;   // lowered until the atlas fits
+    int maxAtlasSize = 2048;
+    int padding = 2;               // texels around every chart, filled by dilation
+    int shadowSamples = 4;         // points on each bulb per texel (soft shadows)
+    int indirectSamples = 32;      // hemisphere paths per texel
+    int bounces = 1;               // diffuse bounces per path
+    uint32_t seed = 1;
+};
+
+// Baked diffuse lighting of the static scene: irradiance (direct + indirect, shadowed,
+// not multiplied by the surface colour) in one atlas, and the second UV set that maps
+// the meshes into it. A mesh has one chart layout shared by all its instances; each
+// instance gets its own rectangle of the atlas, selected per draw by a scale/offset.
+struct Lightmap {
+    int width = 0, height = 0;
+    float texelsPerMeter = 0.0f;
+    std::vector<glm::vec4> texels;              // rgb = irradiance, a = 1 where a surface was baked
+    std::vector<std::vector<glm::vec2>> meshUV; // by mesh id, per vertex, [0,1] over the chart layout
+    std::vector<glm::vec4> nodeScaleOffset;     // by node: atlas uv = meshUV * xy + zw; 0 = not lightmapped
+    uint64_t key = 0;                           // layout + bake settings, guards the cache file
+
+    // Raw little-endian file: "LMAP", version, key, width, height, RGBA32F texels.
+    bool save(const std::string& path) const;
+    // Reads texels baked for the same key; false if the file is missing or stale.
+    bool load(const std::string& path);
+};
+
+// ---- shared by the bakers (lightmap, probe grid) ----
+
+// offset of ray origins from the surface they leave, metres
+const float BAKE_SURFACE_EPSILON = 1e-3f;
+
+// xorshift32. Bakes seed one per texel/probe, so results don't depend on the thread count.
+struct BakeRandom {
+    uint32_t state;
+    explicit BakeRandom(uint32_t seed);
+    float next(); // [0, 1)
+};
+uint32_t bakeHash(uint32_t x);
+// Cache keys: FNV-1a over bytes, and over what a bake sees of the scene (transforms,
+// mesh/material ids, material colours, lights).
+uint64_t bakeHashBytes(uint64_t h, const void* data, size_t size);
+uint64_t bakeSceneKey(const SceneStore& scene);
+
+// Diffuse reflectance of a node: its material colour. Textures only live on the GPU, so
+// textured surfaces count as a mid grey.
+glm::vec3 bakeAlbedo(const SceneStore& scene, uint32_t node);
+// The shaders' attenuation times the radius fade of `light` at distance d.
+float bakeFalloff(const SceneStore& scene, uint32_t light, float d);
+// Fraction of `samples` random points inside the light's bulb visible from `from`.
+float bakeVisibility(const SceneStore& scene, const SceneBVH& rays, uint32_t light, const glm::vec3& from, int samples,
+                     BakeRandom& rng, unsigned long long& traced);
+// Shadowed irradiance at a surface point (unit normal n) from the lights in range.
+glm::vec3 bakeDirectLight(const SceneStore& scene, const SceneBVH& rays, const glm::vec3& p, const glm::vec3& n,
+                          int shadowSamples, BakeRandom& rng, unsigned long long& traced);
+
+// CPU lightmap baker. Charts are groups of connected triangles facing the same major
+// axis, projected onto that axis' plane and shelf-packed; every texel is then path
+// traced through the scene's SceneBVH on the job system, with the same attenuation and
+// radius fade the shaders use for the bulbs.
+class LightmapBaker {
+public:
+    // Local-space geometry of a mesh, with per-vertex normals (interpolated when baking).
+    void setMesh(uint32_t meshId, const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& normals,
+                 const std::vector<uint32_t>& indices);
+    // Second UV set and atlas rectangles for every static mesh node that doesn't carry a
+    // light. Returns false if nothing can be lightmapped.
+    bool layout(const SceneStore& scene, const LightmapConfig& config, Lightmap& out);
+    // Fills out.texels. `rays` must have been built for `scene`.
+    void bake(const SceneStore& scene, const SceneBVH& rays, JobSystem& jobs, Lightmap& out);
+    void report(std::ostream& os) const;
+
+private:
+    struct Chart {
+        glm::vec2 min, max;              // projected bounds, local units
+        glm::vec2 offset;                // placement in the mesh layout
+    };
+    struct Mesh {
+        std::vector<glm::vec3> positions, normals;
+        std::vector<uint32_t> indices;
+        std::vector<Chart> charts;
+        std::vector<uint32_t> vertexChart; // chart of each vertex
+        std::vector<glm::vec2> projected;  // per vertex, on its chart's plane
+    };
+    void buildCharts(Mesh& mesh);
+
+    std::vector<Mesh> meshes;
+    LightmapConfig cfg;
+    size_t charts = 0, instances = 0, bakedTexels = 0;
+    double bakeMs = 0.0;
+    unsigned long long raysTraced = 0;
+    unsigned threads = 0;
+    bool baked = false;
+};
+
+#endif
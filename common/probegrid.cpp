@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#include "bvh.hpp"
+#include "jobsystem.hpp"
+#include "lightmap.hpp"
+#include "scenestore.hpp"
+#include "probegrid.hpp"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+const uint32_t FILE_VERSION = 1;
+
+} // namespace
+
+glm::vec3 ProbeGrid::probePosition(int x, int y, int z) const {
+    return boundsMin + (boundsMax - boundsMin) * (glm::vec3((float)x, (float)y, (float)z) + 0.5f) / glm::vec3(size);
+}
+
+glm::vec3 ProbeGrid::irradiance(const glm::vec3& p, const glm::vec3& n) const {
+    if (!probeCount()) return glm::vec3(0.0f);
+    // texel space of a 3D texture with one texel per probe
+    glm::vec3 t = (p - boundsMin) / (boundsMax - boundsMin) * glm::vec3(size) - 0.5f;
+    t = glm::clamp(t, glm::vec3(0.0f), glm::vec3(size - 1));
+    glm::ivec3 i0 = glm::ivec3(glm::floor(t));
+    glm::ivec3 i1 = glm::min(i0 + 1, size - 1);
+    glm::vec3 f = t - glm::vec3(i0);
+    glm::vec3 result(0.0f);
+    for (int c = 0; c < 3; ++c) {
+        glm::vec4 sh(0.0f);
+        for (int k = 0; k < 8; ++k) {
+            glm::ivec3 i((k & 1) ? i1.x : i0.x, (k & 2) ? i1.y : i0.y, (k & 4) ? i1.z : i0.z);
+            float w = ((k & 1) ? f.x : 1.0f - f.x) * ((k & 2) ? f.y : 1.0f - f.y) * ((k & 4) ? f.z : 1.0f - f.z);
+            sh += w * channels[c][((size_t)i.z * size.y + i.y) * size.x + i.x];
+        }
+        result[c] = std::max(sh.x + glm::dot(glm::vec3(sh.y, sh.z, sh.w), n), 0.0f);
+    }
+    return result;
+}
+
+bool ProbeGrid::save(const std::string& path) const {
+    std::ofstream f(path.c_str(), std::ios::binary);
+    if (!f) return false;
+    f.write("PRBG", 4);
+    f.write((const char*)&FILE_VERSION, sizeof(FILE_VERSION));
+    f.write((const char*)&key, sizeof(key));
+    f.write((const char*)&size, sizeof(size));
+    f.write((const char*)&boundsMin, sizeof(boundsMin));
+    f.write((const char*)&boundsMax, sizeof(boundsMax));
+    for (int c = 0; c < 3; ++c) f.write((const char*)channels[c].data(), channels[c].size() * sizeof(glm::vec4));
+    return (bool)f;
+}
+
+bool ProbeGrid::load(const std::string& path) {
+    std::ifstream f(path.c_str(), std::ios::binary);
+    if (!f) return false;
+    char magic[4];
+    uint32_t version = 0;
+    uint64_t fileKey = 0;
+    glm::ivec3 fileSize(0);
+    glm::vec3 fileMin(0.0f), fileMax(0.0f);
+    f.read(magic, 4);
+    f.read((char*)&version, sizeof(version));
+    f.read((char*)&fileKey, sizeof(fileKey));
+    f.read((char*)&fileSize, sizeof(fileSize));
+    f.read((char*)&fileMin, sizeof(fileMin));
+    f.read((char*)&fileMax, sizeof(fileMax));
+    if (!f || std::memcmp(magic, "PRBG", 4) != 0 || version != FILE_VERSION || fileKey != key || fileSize != size) {
+        return false;
+    }
+    std::vector<glm::vec4> data[3];
+    for (int c = 0; c < 3; ++c) {
+        data[c].resize(probeCount());
+        f.read((char*)data[c].data(), data[c].size() * sizeof(glm::vec4));
+    }
+    if (!f) return false;
+    for (int c = 0; c < 3; ++c) channels[c].swap(data[c]);
+    return true;
+}
+
+bool ProbeBaker::layout(const SceneStore& scene, const SceneBVH& rays, const ProbeGridConfig& config, ProbeGrid& out) {
+    cfg = config;
+    baked = false;
+    out = ProbeGrid();
+    if (!rays.instanceCount()) return false;
+    out.boundsMin = rays.boundsMin();
+    out.boundsMax = rays.boundsMax();
+    const glm::vec3 extent = glm::max(out.boundsMax - out.boundsMin, glm::vec3(1e-3f));
+    out.boundsMax = out.boundsMin + extent;
+
+    spacing = std::max(cfg.spacing, 0.05f);
+    for (;;) {
+        size = glm::max(glm::ivec3(glm::ceil(extent / spacing)), glm::ivec3(1));
+        bool fits = size.x <= cfg.maxAxis && size.y <= cfg.maxAxis && size.z <= cfg.maxAxis &&
+                    (long long)size.x * size.y * size.z <= (long long)cfg.maxProbes;
+        if (fits) break;
+        spacing *= 1.25f;
+    }
+    out.size = size;
+    for (int c = 0; c < 3; ++c) out.channels[c].assign(out.probeCount(), glm::vec4(0.0f));
+
+    uint64_t h = bakeSceneKey(scene);
+    size_t triangles = rays.instancedTriangles();
+    h = bakeHashBytes(h, &triangles, sizeof(triangles));
+    h = bakeHashBytes(h, &out.boundsMin, sizeof(out.boundsMin));
+    h = bakeHashBytes(h, &out.boundsMax, sizeof(out.boundsMax));
+    h = bakeHashBytes(h, &out.size, sizeof(out.size));
+    h = bakeHashBytes(h, &cfg.raysPerProbe, sizeof(cfg.raysPerProbe));
+    h = bakeHashBytes(h, &cfg.shadowSamples, sizeof(cfg.shadowSamples));
+    h = bakeHashBytes(h, &cfg.seed, sizeof(cfg.seed));
+    out.key = h;
+    return true;
+}
+
+void ProbeBaker::bake(const SceneStore& scene, const SceneBVH& rays, JobSystem& jobs, ProbeGrid& out) {
+    Clock::time_point start = Clock::now();
+    threads = jobs.workerCount() + 1;
+    std::vector<uint8_t> isLight(scene.nodeCount(), 0);
+    for (uint32_t node : scene.lightNode) isLight[node] = 1;
+
+    // Projecting radiance L(w) onto L1 harmonics and convolving with the clamped cosine
+    // collapses to a = sum(L dw) / 4, b = sum(L w dw) / 2 (irradiance = a + dot(b, n)).
+    // A bulb is a delta of irradiance I along its direction, a uniform ray carries
+    // 4 pi / N of the sphere, and a diffuse surface sends albedo * E / pi.
+    std::atomic<unsigned long long> traced(0);
+    const int raysPerProbe = std::max(0, cfg.raysPerProbe);
+    const int nx = out.size.x, ny = out.size.y;
+    jobs.parallelFor(out.probeCount(), 4, [&](size_t begin, size_t end) {
+        unsigned long long local = 0;
+        for (size_t probe = begin; probe < end; ++probe) {
+            const glm::vec3 p = out.probePosition((int)(probe % nx), (int)(probe / nx % ny), (int)(probe / nx / ny));
+            BakeRandom rng(bakeHash((uint32_t)probe * 0x9E3779B9u ^ cfg.seed));
+            glm::vec3 sum0(0.0f);   // sum(L dw), rgb
+            glm::mat3 sum1(0.0f);   // sum(L w dw): column = rgb, one per axis
+
+            auto light = [&](uint32_t l) {
+                glm::vec3 L = scene.lightPosition[l] - p;
+                float d = glm::length(L);
+                float falloff = d > 1e-4f ? bakeFalloff(scene, l, d) : 0.0f;
+                if (falloff <= 0.0f) return;
+                glm::vec3 I = scene.lightColor[l] * (falloff * bakeVisibility(scene, rays, l, p, cfg.shadowSamples, rng, local));
+                glm::vec3 dir = L / d;
+                sum0 += I;
+                for (int a = 0; a < 3; ++a) sum1[a] += I * dir[a];
+            };
+            const LightGrid& grid = scene.lightGrid;
+            if (grid.width == 0) {
+                for (uint32_t l = 0; l < (uint32_t)scene.lightCount(); ++l) light(l);
+            } else {
+                int cx, cz;
+                grid.cellOf(p.x, p.z, cx, cz);
+                size_t cell = (size_t)cz * (size_t)grid.width + (size_t)cx;
+                for (uint32_t k = grid.cellStart[cell]; k < grid.cellStart[cell + 1]; ++k) light(grid.lights[k]);
+            }
+
+            const float weight = raysPerProbe ? 4.0f / (float)raysPerProbe : 0.0f; // (4 pi / N) / pi
+            for (int k = 0; k < raysPerProbe; ++k) {
+                float z = 1.0f - 2.0f * rng.next(), phi = 6.2831853f * rng.next();
+                float s = std::sqrt(std::max(0.0f, 1.0f - z * z));
+                Ray ray;
+                ray.origin = p;
+                ray.direction = glm::vec3(s * std::cos(phi), z, s * std::sin(phi));
+                RayHit hit;
+                ++local;
+                // the bulbs themselves are already counted as direct light
+                if (!rays.intersect(ray, hit) || isLight[hit.node]) continue;
+                glm::vec3 E = bakeDirectLight(scene, rays, hit.position, hit.normal, 1, rng, local);
+                glm::vec3 L = bakeAlbedo(scene, hit.node) * E * weight;
+                sum0 += L;
+                for (int a = 0; a < 3; ++a) sum1[a] += L * ray.direction[a];
+            }
+
+            for (int c = 0; c < 3; ++c) {
+                out.channels[c][probe] = glm::vec4(sum0[c] * 0.25f, sum1[0][c] * 0.5f, sum1[1][c] * 0.5f, sum1[2][c] * 0.5f);
+            }
+        }
+        traced += local;
+    });
+
+    raysTraced = traced;
+    bakeMs = msSince(start);
+    baked = true;
+}
+
+void ProbeBaker::report(std::ostream& os) const {
+    if (!size.x) return;
+    os << "  probe grid     : " << size.x << "x" << size.y << "x" << size.z << " probes, " << spacing
+       << " m apart, L1 SH, ";
+    if (baked) {
+        os << "baked in " << bakeMs << " ms on " << threads << " threads ("
+           << (bakeMs > 0.0 ? (double)raysTraced / (bakeMs * 1000.0) : 0.0) << " Mrays/s, " << cfg.raysPerProbe
+           << " rays per probe)\n";
+    } else {
+        os << "read from the cache file\n";
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef PROBEGRID_HPP
+#define PROBEGRID_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class JobSystem;
+class SceneBVH;
+class SceneStore;
+
+struct ProbeGridConfig {
+    float spacing = 1.0f;      // metres between probes, grown until the grid fits
+    int maxProbes = 65536;
+    int maxAxis = 256;         // probes along one axis (smallest GL 3.3 3D texture limit)
+    int raysPerProbe = 256;    // over the sphere, for the bounced light
+    int shadowSamples = 4;     // points on each bulb when testing if a probe sees it
+    uint32_t seed = 1;
+};
+
+// Irradiance probes on a regular grid, stored as L1 spherical harmonics already
+// convolved with the cosine lobe: per probe and colour channel the irradiance for a
+// normal n is max(a + dot(b, n), 0), kept as one vec4 (a, b). Red, green and blue live
+// in three 3D textures, so a lookup is three trilinear fetches whatever the number of
+// lights.
+struct ProbeGrid {
+    glm::vec3 boundsMin = glm::vec3(0.0f), boundsMax = glm::vec3(0.0f); // probes sit at cell centres
+    glm::ivec3 size = glm::ivec3(0);   // probes per axis
+    std::vector<glm::vec4> channels[3]; // r, g, b; x fastest, then y, then z
+    uint64_t key = 0;                   // layout + scene + bake settings, guards the cache file
+
+    size_t probeCount() const { return (size_t)size.x * (size_t)size.y * (size_t)size.z; }
+    glm::vec3 probePosition(int x, int y, int z) const;
+    // What the shader computes (trilinear between the 8 surrounding probes).
+    glm::vec3 irradiance(const glm::vec3& p, const glm::vec3& n) const;
+
+    // Raw little-endian file: "PRBG", version, key, size, bounds, RGBA32F per channel.
+    bool save(const std::string& path) const;
+    // Reads probes baked for the same key; false if the file is missing or stale.
+    bool load(const std::string& path);
+};
+
+// Bakes a ProbeGrid over everything the SceneBVH can hit (one classroom: the
+// w=10, h=5, d=8 box of setupGeometry). Each probe sees every bulb in range as a
+// direction of light (shadow tested against the bulb's volume) and gathers the light the
+// surfaces around it bounce, with rays spread over the sphere; probes run in parallel on
+// the job system. Surfaces use the same falloff and albedo as the lightmap baker.
+class ProbeBaker {
+public:
+    // `rays` must have been built for `scene`.
+    bool layout(const SceneStore& scene, const SceneBVH& rays, const ProbeGridConfig& config, ProbeGrid& out);
+    void bake(const SceneStore& scene, const SceneBVH& rays, JobSystem& jobs, ProbeGrid& out);
+    void report(std::ostream& os) const;
+
+private:
+    ProbeGridConfig cfg;
+    glm::ivec3 size = glm::ivec3(0);
+    float spacing = 0.0f;
+    double bakeMs = 0.0;
+    unsigned long long raysTraced = 0;
+    unsigned threads = 0;
+    bool baked = false;
+};
+
+#endif
@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "ringbuffer.hpp"
+
+// GL 4.4 / ARB_buffer_storage, not part of the 3.3 core loader
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+typedef void (APIENTRYP PFNGLBUFFERSTORAGE_PROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+static double allStallsMs = 0.0;
+
+static PFNGLBUFFERSTORAGE_PROC loadBufferStorage() {
+    if (GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 4) ||
+        glfwExtensionSupported("GL_ARB_buffer_storage")) {
+        return (PFNGLBUFFERSTORAGE_PROC)glfwGetProcAddress("glBufferStorage");
+    }
+    return nullptr;
+}
+
+bool RingBuffer::init(GLenum target, size_t bytesPerFrame, int frames, const std::string& owner) {
+    destroy();
+    bufferTarget = target;
+    ownerTag = owner;
+    sectionCount = std::max(1, std::min(frames, 4));
+    // keep every section start aligned for any binding alignment we may be asked for
+    sectionBytes = (bytesPerFrame + 255) & ~(size_t)255;
+    GLint align = 0;
+    if (target == GL_UNIFORM_BUFFER) glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &align);
+    offsetAlignment = (size_t)std::max(align, 1);
+    size_t total = sectionBytes * (size_t)sectionCount;
+
+    storage.create(ownerTag);
+    glBindBuffer(target, storage.get());
+
+    static PFNGLBUFFERSTORAGE_PROC bufferStorage = loadBufferStorage();
+    if (bufferStorage) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        bufferStorage(target, (GLsizeiptr)total, nullptr, flags);
+        persistentPtr = (unsigned char*)glMapBufferRange(target, 0, (GLsizeiptr)total, flags);
+        isPersistent = (persistentPtr != nullptr);
+    }
+    if (!isPersistent) {
+        if (bufferStorage) {
+            // immutable storage can't be respecified; start over with a mutable buffer
+            glBindBuffer(target, 0);
+            storage.create(ownerTag);
+            glBindBuffer(target, storage.get());
+        }
+        glBufferData(target, (GLsizeiptr)total, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(target, 0);
+    current = 0;
+    head = 0;
+    gpuResources().setSize(GPU_BUFFER, storage.get(), total,
+                           isPersistent ? "persistent ring" : "stream ring");
+    return (bool)storage;
+}
+
+void RingBuffer::destroy() {
+    for (int i = 0; i < 4; ++i) {
+        if (fences[i]) glDeleteSync(fences[i]);
+        fences[i] = 0;
+    }
+    if (storage) {
+        if (persistentPtr) {
+            glBindBuffer(bufferTarget, storage.get());
+            glUnmapBuffer(bufferTarget);
+            glBindBuffer(bufferTarget, 0);
+        }
+        storage.reset();
+    }
+    persistentPtr = nullptr;
+    sectionPtr = nullptr;
+    isPersistent = false;
+}
+
+void RingBuffer::ensureCapacity(size_t bytesPerFrame) {
+    if (bytesPerFrame <= sectionBytes) return;
+    for (int i = 0; i < sectionCount; ++i) waitForSection(i);
+    size_t grown = std::max(bytesPerFrame + bytesPerFrame / 2, sectionBytes * 2);
+    init(bufferTarget, grown, sectionCount, ownerTag);
+}
+
+void RingBuffer::waitForSection(int section) {
+    GLsync& fence = fences[section];
+    if (!fence) return;
+    GLenum r = glClientWaitSync(fence, 0, 0);
+    if (r == GL_TIMEOUT_EXPIRED) {
+        // the CPU is a full ring ahead of the GPU
+        ++stalls;
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        do {
+            r = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms slices
+        } while (r == GL_TIMEOUT_EXPIRED);
+        double waitedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        stallMs += waitedMs;
+        allStallsMs += waitedMs;
+    }
+    glDeleteSync(fence);
+    fence = 0;
+}
+
+double RingBuffer::totalStallMs() {
+    return allStallsMs;
+}
+
+void RingBuffer::beginFrame() {
+    current = (int)(frames % (unsigned long long)sectionCount);
+    waitForSection(current);
+    head = 0;
+    size_t base = sectionBytes * (size_t)current;
+    if (isPersistent) {
+        sectionPtr = persistentPtr + base;
+    } else {
+        glBindBuffer(bufferTarget, storage.get());
+        sectionPtr = (unsigned char*)glMapBufferRange(bufferTarget, (GLintptr)base, (GLsizeiptr)sectionBytes,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        glBindBuffer(bufferTarget, 0);
+    }
+}
+
+void* RingBuffer::allocate(size_t size, size_t alignment, size_t& offset) {
+    if (!sectionPtr) return nullptr;
+    if (alignment == 0) alignment = 1;
+    size_t aligned = (head + alignment - 1) / alignment * alignment;
+    if (aligned + size > sectionBytes) {
+        ++overflows;
+        return nullptr;
+    }
+    head = aligned + size;
+    peakBytes = std::max(peakBytes, head);
+    offset = sectionBytes * (size_t)current + aligned;
+    return sectionPtr + aligned;
+}
+
+void RingBuffer::flush() {
+    if (isPersistent || !sectionPtr) return;
+    // a buffer can't be sourced by draws while mapped on a 3.3 context
+    glBindBuffer(bufferTarget, storage.get());
+    glUnmapBuffer(bufferTarget);
+    glBindBuffer(bufferTarget, 0);
+    sectionPtr = nullptr;
+}
+
+void RingBuffer::endFrame() {
+    flush();
+    sectionPtr = nullptr;
+    fences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    ++frames;
+}
+
+void RingBuffer::report(std::ostream& os) const {
+    os << "  ring buffer    : " << (isPersistent ? "persistent" : "map-range") << ", "
+       << sectionCount << " x " << sectionBytes / 1024 << " KiB, peak " << peakBytes / 1024 << " KiB/frame, "
+       << stalls << " stalls (" << stallMs << " ms waiting)";
+    if (overflows) os << ", " << overflows << " overflowed allocations";
+    os << "\n";
+}
@@ -0,0 +1,84 @@
+#ifndef RINGBUFFER_HPP
+#define RINGBUFFER_HPP
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+#include <glad/glad.h>
+
+#include "gpuresources.hpp"
+
+// Per-frame dynamic data (per-draw constants, instance data, indirect commands...).
+//
+// One GL buffer split into `frames` sections; frame N writes section N % frames while
+// the GPU may still read the previous ones. Each section is fenced when the frame's
+// draws are queued and waited on before it is reused, so the CPU never overwrites data
+// in flight. With GL 4.4 / ARB_buffer_storage the buffer is mapped once, persistent and
+// coherent; otherwise each section is mapped with glMapBufferRange (unsynchronized,
+// the fence already guarantees the GPU is done with it) and unmapped before drawing.
+//
+//   ring.beginFrame();
+//   void* p = ring.allocate(size, align, offset);   // write data, remember offsets
+//   ring.flush();                                   // before any draw that reads it
+//   ... glBindBufferRange(target, slot, ring.buffer(), offset, size); draw ...
+//   ring.endFrame();                                // fence this frame's section
+class RingBuffer {
+public:
+    RingBuffer() {}
+    ~RingBuffer() { destroy(); }
+
+    // `owner` labels the buffer in the GPU memory report.
+    bool init(GLenum target, size_t bytesPerFrame, int frames = 3, const std::string& owner = "ring");
+    void destroy();
+
+    // Grows the sections if a frame needs more than they hold. Waits for the GPU to
+    // finish with the old buffer, so call it outside beginFrame/endFrame.
+    void ensureCapacity(size_t bytesPerFrame);
+
+    void beginFrame();
+    // Sub-allocates from the current section; offset is relative to the buffer start.
+    // Returns nullptr if the section is full (the overflow is counted).
+    void* allocate(size_t size, size_t alignment, size_t& offset);
+    void flush();
+    void endFrame();
+
+    GLuint buffer() const { return storage.get(); }
+    GLenum target() const { return bufferTarget; }
+    bool persistent() const { return isPersistent; }
+    size_t sectionSize() const { return sectionBytes; }
+    // Offset alignment of bound ranges (glBindBufferRange) for the target, from init().
+    size_t bindAlignment() const { return offsetAlignment; }
+
+    // Stalls = frames where the CPU caught up with the GPU and had to wait on a fence.
+    void report(std::ostream& os) const;
+    // Fence waits of every ring so far (GL thread), to take GPU waits out of CPU timings.
+    static double totalStallMs();
+
+private:
+    RingBuffer(const RingBuffer&);
+    RingBuffer& operator=(const RingBuffer&);
+
+    void waitForSection(int section);
+
+    GLenum bufferTarget = GL_UNIFORM_BUFFER;
+    GpuBuffer storage;
+    std::string ownerTag;
+    bool isPersistent = false;
+    unsigned char* persistentPtr = nullptr;
+    unsigned char* sectionPtr = nullptr;   // mapping of the current section
+    size_t sectionBytes = 0;
+    size_t offsetAlignment = 1;
+    size_t head = 0;                        // bytes used in the current section
+    int sectionCount = 0;
+    int current = 0;
+    GLsync fences[4] = { 0, 0, 0, 0 };
+
+    unsigned long long frames = 0;
+    unsigned long long stalls = 0;
+    double stallMs = 0.0;
+    unsigned long long overflows = 0;
+    size_t peakBytes = 0;
+};
+
+#endif
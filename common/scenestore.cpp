@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+
+#include "scenestore.hpp"
+
+void transformBounds(const glm::mat4& model, const glm::vec3& localMin, const glm::vec3& localMax,
+                     glm::vec3& worldMin, glm::vec3& worldMax) {
+    // Arvo: per-axis min/max of the rotated extents
+    glm::vec3 t(model[3]);
+    worldMin = t;
+    worldMax = t;
+    for (int c = 0; c < 3; ++c) {
+        for (int r = 0; r < 3; ++r) {
+            float a = model[c][r] * localMin[c];
+            float b = model[c][r] * localMax[c];
+            worldMin[r] += std::min(a, b);
+            worldMax[r] += std::max(a, b);
+        }
+    }
+}
+
+void LightGrid::build(const std::vector<glm::vec3>& positions, const std::vector<float>& radii) {
+    width = depth = 0;
+    cellStart.clear();
+    lights.clear();
+    if (positions.empty()) return;
+
+    float maxRadius = 0.0f;
+    glm::vec2 mn(FLT_MAX), mx(-FLT_MAX);
+    for (size_t l = 0; l < positions.size(); ++l) {
+        float r = radii[l];
+        maxRadius = std::max(maxRadius, r);
+        mn = glm::min(mn, glm::vec2(positions[l].x - r, positions[l].z - r));
+        mx = glm::max(mx, glm::vec2(positions[l].x + r, positions[l].z + r));
+    }
+    if (maxRadius > 1e6f) return; // culling disabled: every light reaches everything
+
+    // a cell about one light radius wide: each light lands in ~9 cells, each draw
+    // looks at 1-4 of them
+    cellSize = std::max(maxRadius, 1.0f);
+    const long long maxCells = 1 << 20;
+    for (;;) {
+        width = (int)((mx.x - mn.x) / cellSize) + 1;
+        depth = (int)((mx.y - mn.y) / cellSize) + 1;
+        if ((long long)width * depth <= maxCells) break;
+        cellSize *= 2.0f;
+    }
+    origin = mn;
+
+    // counting sort by cell, lights in id order
+    cellStart.assign((size_t)width * depth + 1, 0);
+    for (int pass = 0; pass < 2; ++pass) {
+        std::vector<uint32_t> fill;
+        if (pass == 1) {
+            for (size_t c = 1; c < cellStart.size(); ++c) cellStart[c] += cellStart[c - 1];
+            lights.resize(cellStart.back());
+            fill.assign(cellStart.begin(), cellStart.end() - 1);
+        }
+        for (size_t l = 0; l < positions.size(); ++l) {
+            int x0, z0, x1, z1;
+            cellOf(positions[l].x - radii[l], positions[l].z - radii[l], x0, z0);
+            cellOf(positions[l].x + radii[l], positions[l].z + radii[l], x1, z1);
+            for (int z = z0; z <= z1; ++z) {
+                for (int x = x0; x <= x1; ++x) {
+                    size_t cell = (size_t)z * width + x;
+                    if (pass == 0) ++cellStart[cell + 1];
+                    else lights[fill[cell]++] = (uint32_t)l;
+                }
+            }
+        }
+    }
+}
+
+void LightGrid::cellOf(float x, float z, int& cx, int& cz) const {
+    cx = std::min(std::max((int)std::floor((x - origin.x) / cellSize), 0), width - 1);
+    cz = std::min(std::max((int)std::floor((z - origin.y) / cellSize), 0), depth - 1);
+}
+
+uint32_t SceneStore::addMesh(const MeshGPU& m, const std::string& name) {
+    meshes.push_back(m);
+    meshNames.push_back(name);
+    return (uint32_t)(meshes.size() - 1);
+}
+
+uint32_t SceneStore::addMaterial(const Material& m) {
+    materials.push_back(m);
+    return (uint32_t)(materials.size() - 1);
+}
+
+uint32_t SceneStore::addNode(uint32_t parentNode, const glm::mat4& localTransform,
+                             uint32_t meshId, uint32_t materialId, bool isStatic) {
+    uint32_t id = (uint32_t)parent.size();
+    if (parentNode != SCENE_NONE && parentNode >= id) {
+        std::cerr << "[SCENE] parent " << parentNode << " must exist before child " << id << "\n";
+        parentNode = SCENE_NONE;
+    }
+    parent.push_back(parentNode);
+    local.push_back(localTransform);
+    world.push_back(glm::mat4(1.0f));
+    normalMatrix.push_back(glm::mat4(1.0f));
+    boundsMin.push_back(glm::vec3(1.0f));
+    boundsMax.push_back(glm::vec3(-1.0f));
+    mesh.push_back(meshId);
+    material.push_back(materialId);
+    flags.push_back((uint8_t)(NODE_DIRTY | (isStatic ? NODE_STATIC : 0)));
+    lightmapScaleOffset.push_back(glm::vec4(0.0f));
+    light.push_back(SCENE_NONE);
+    return id;
+}
+
+uint32_t SceneStore::addLight(uint32_t node, const glm::vec3& color, float radius) {
+    if (node < light.size() && light[node] == SCENE_NONE) light[node] = (uint32_t)lightNode.size();
+    lightNode.push_back(node);
+    lightColor.push_back(color);
+    lightRadius.push_back(radius);
+    lightPosition.push_back(glm::vec3(0.0f));
+    return (uint32_t)(lightNode.size() - 1);
+}
+
+void SceneStore::setLocal(uint32_t node, const glm::mat4& localTransform) {
+    if (flags[node] & NODE_DONE) {
+        std::cerr << "[SCENE] moving static node " << node << ", recomputing it\n";
+        flags[node] = (uint8_t)(flags[node] & ~NODE_DONE);
+    }
+    local[node] = localTransform;
+    flags[node] |= NODE_DIRTY;
+}
+
+bool SceneStore::update() {
+    const size_t n = parent.size();
+    changedThisPass.assign(n, 0);
+    bool any = false;
+
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t p = parent[i];
+        bool parentChanged = (p != SCENE_NONE) && changedThisPass[p];
+        // a computed static node is only skipped while its parent holds still: under a
+        // parent that moved it must follow, and pass the change on to its children
+        if (!(flags[i] & NODE_DIRTY) && !parentChanged) continue;
+
+        world[i] = (p != SCENE_NONE) ? world[p] * local[i] : local[i];
+        uint32_t m = mesh[i];
+        if (m != SCENE_NONE) {
+            normalMatrix[i] = glm::mat4(glm::transpose(glm::inverse(glm::mat3(world[i]))));
+            transformBounds(world[i], meshes[m].boundsMin, meshes[m].boundsMax, boundsMin[i], boundsMax[i]);
+        }
+        flags[i] = (uint8_t)(flags[i] & ~NODE_DIRTY);
+        if (flags[i] & NODE_STATIC) flags[i] |= NODE_DONE;
+        changedThisPass[i] = 1;
+        any = true;
+    }
+
+    if (any) {
+        for (size_t l = 0; l < lightNode.size(); ++l) {
+            lightPosition[l] = glm::vec3(world[lightNode[l]][3]);
+        }
+        lightGrid.build(lightPosition, lightRadius);
+    }
+    return any;
+}
+
+void SceneStore::clear() {
+    *this = SceneStore();
+}
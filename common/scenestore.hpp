@@ -0,0 +1,110 @@
+#ifndef SCENESTORE_HPP
+#define SCENESTORE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+const uint32_t SCENE_NONE = 0xFFFFFFFFu;
+
+// GPU side of a mesh: just the handles and what a draw needs. Names live in
+// SceneStore::meshNames so the hot array stays small.
+struct MeshGPU {
+    unsigned int vao = 0, vbo = 0, ebo = 0;
+    unsigned int depthVao = 0;     // positions only + the same ebo, for the depth pre-pass; 0 = use vao
+    unsigned int indexCount = 0;
+    unsigned int firstIndex = 0;   // offset into the element buffer, in indices
+    glm::vec3 boundsMin = glm::vec3(0.0f), boundsMax = glm::vec3(0.0f); // local AABB
+};
+
+struct Material {
+    glm::vec3 color = glm::vec3(1.0f);
+    bool hasTexture = false;
+    unsigned int texture = 0;
+    glm::vec2 uvScale = glm::vec2(1.0f);
+};
+
+// Lights binned by the xz grid cells their sphere overlaps (rooms are flat, so y is
+// ignored), so gathering a draw's lights only tests the lights near it.
+struct LightGrid {
+    glm::vec2 origin = glm::vec2(0.0f);
+    float cellSize = 1.0f;
+    int width = 0, depth = 0;             // 0 = no grid (no lights or unbounded radii)
+    std::vector<uint32_t> cellStart;      // width*depth + 1 offsets into `lights`
+    std::vector<uint32_t> lights;         // light ids, ascending within a cell
+
+    void build(const std::vector<glm::vec3>& positions, const std::vector<float>& radii);
+    // Cell containing (x, z), clamped to the grid.
+    void cellOf(float x, float z, int& cx, int& cz) const;
+};
+
+enum SceneNodeFlags {
+    NODE_DIRTY  = 1 << 0,   // local transform changed since the last update()
+    NODE_STATIC = 1 << 1,   // world matrix/bounds computed once, again only if a parent moves
+    NODE_DONE   = 1 << 2    // static node already computed
+};
+
+// Scene graph stored as parallel arrays (structure of arrays), indexed by node id.
+//
+// Parents are always created before their children, so one linear pass in index order
+// propagates transforms down the hierarchy (update()). Culling, sorting and light
+// assignment only touch the arrays they need (world bounds, mesh/material ids), which
+// keeps them cache friendly at tens of thousands of nodes.
+class SceneStore {
+public:
+    uint32_t addMesh(const MeshGPU& mesh, const std::string& name);
+    uint32_t addMaterial(const Material& material);
+    // mesh/material may be SCENE_NONE for pure transform (grouping) nodes.
+    uint32_t addNode(uint32_t parentNode, const glm::mat4& localTransform,
+                     uint32_t meshId = SCENE_NONE, uint32_t materialId = SCENE_NONE, bool isStatic = true);
+    // Lights are attached to nodes; their world position follows the node. `radius` is
+    // the distance beyond which the light is ignored (see lightEffectiveRadius).
+    uint32_t addLight(uint32_t node, const glm::vec3& color, float radius);
+
+    void setLocal(uint32_t node, const glm::mat4& localTransform);
+
+    // Recomputes world matrices/bounds of dirty nodes and their descendants in a single
+    // pass. Returns true if anything changed (callers republish their snapshot then).
+    bool update();
+
+    size_t nodeCount() const { return parent.size(); }
+    size_t lightCount() const { return lightNode.size(); }
+    void clear();
+
+    // ---- node arrays (index = node id) ----
+    std::vector<uint32_t> parent;
+    std::vector<glm::mat4> local;
+    std::vector<glm::mat4> world;
+    std::vector<glm::mat4> normalMatrix;  // inverse-transpose of world's 3x3
+    std::vector<glm::vec3> boundsMin;     // world AABB, empty (min > max) for mesh-less nodes
+    std::vector<glm::vec3> boundsMax;
+    std::vector<uint32_t> mesh;
+    std::vector<uint32_t> material;
+    std::vector<uint8_t> flags;
+    std::vector<glm::vec4> lightmapScaleOffset; // atlas uv = uv2 * xy + zw; zero = not lightmapped
+    std::vector<uint32_t> light;          // light carried by the node, SCENE_NONE if none; a mesh
+                                          // node with a light is that light's fixture
+
+    // ---- lights ----
+    std::vector<uint32_t> lightNode;
+    std::vector<glm::vec3> lightColor;
+    std::vector<float> lightRadius;
+    std::vector<glm::vec3> lightPosition; // world, refreshed by update()
+    LightGrid lightGrid;                  // rebuilt by update() when lights move
+
+    // ---- shared tables ----
+    std::vector<MeshGPU> meshes;
+    std::vector<std::string> meshNames;
+    std::vector<Material> materials;
+
+private:
+    std::vector<uint8_t> changedThisPass;
+};
+
+// World AABB of a local AABB under `model`.
+void transformBounds(const glm::mat4& model, const glm::vec3& localMin, const glm::vec3& localMax,
+                     glm::vec3& worldMin, glm::vec3& worldMax);
+
+#endif
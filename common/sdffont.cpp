@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include "sdffont.hpp"
+
+namespace {
+
+const uint32_t FILE_VERSION = 1;
+
+} // namespace
+
+const SdfGlyph* SdfFont::glyph(uint32_t codepoint) const {
+    std::vector<SdfGlyph>::const_iterator it = std::lower_bound(glyphs.begin(), glyphs.end(), codepoint,
+        [](const SdfGlyph& g, uint32_t cp) { return g.codepoint < cp; });
+    return (it != glyphs.end() && it->codepoint == codepoint) ? &*it : nullptr;
+}
+
+float SdfFont::kern(uint32_t left, uint32_t right) const {
+    uint64_t key = (uint64_t)left << 32 | right;
+    std::vector<uint64_t>::const_iterator it = std::lower_bound(kerningPairs.begin(), kerningPairs.end(), key);
+    return (it != kerningPairs.end() && *it == key) ? kerning[it - kerningPairs.begin()] : 0.0f;
+}
+
+bool SdfFont::save(const std::string& path) const {
+    std::ofstream f(path.c_str(), std::ios::binary);
+    if (!f) return false;
+    uint32_t glyphCount = (uint32_t)glyphs.size(), pairCount = (uint32_t)kerningPairs.size();
+    f.write("SDFF", 4);
+    f.write((const char*)&FILE_VERSION, sizeof(FILE_VERSION));
+    f.write((const char*)&emPixels, sizeof(emPixels));
+    f.write((const char*)&spread, sizeof(spread));
+    f.write((const char*)&ascender, sizeof(ascender));
+    f.write((const char*)&descender, sizeof(descender));
+    f.write((const char*)&lineGap, sizeof(lineGap));
+    f.write((const char*)&atlasWidth, sizeof(atlasWidth));
+    f.write((const char*)&atlasHeight, sizeof(atlasHeight));
+    f.write((const char*)&glyphCount, sizeof(glyphCount));
+    f.write((const char*)&pairCount, sizeof(pairCount));
+    f.write((const char*)glyphs.data(), glyphs.size() * sizeof(SdfGlyph));
+    f.write((const char*)kerningPairs.data(), kerningPairs.size() * sizeof(uint64_t));
+    f.write((const char*)kerning.data(), kerning.size() * sizeof(float));
+    f.write((const char*)atlas.data(), atlas.size());
+    return (bool)f;
+}
+
+bool SdfFont::load(const std::string& path) {
+    std::ifstream f(path.c_str(), std::ios::binary);
+    if (!f) return false;
+    char magic[4];
+    uint32_t version = 0, glyphCount = 0, pairCount = 0;
+    SdfFont in;
+    f.read(magic, 4);
+    f.read((char*)&version, sizeof(version));
+    f.read((char*)&in.emPixels, sizeof(in.emPixels));
+    f.read((char*)&in.spread, sizeof(in.spread));
+    f.read((char*)&in.ascender, sizeof(in.ascender));
+    f.read((char*)&in.descender, sizeof(in.descender));
+    f.read((char*)&in.lineGap, sizeof(in.lineGap));
+    f.read((char*)&in.atlasWidth, sizeof(in.atlasWidth));
+    f.read((char*)&in.atlasHeight, sizeof(in.atlasHeight));
+    f.read((char*)&glyphCount, sizeof(glyphCount));
+    f.read((char*)&pairCount, sizeof(pairCount));
+    if (!f || std::memcmp(magic, "SDFF", 4) != 0 || version != FILE_VERSION || in.atlasWidth <= 0 ||
+        in.atlasHeight <= 0 || in.atlasWidth > 16384 || in.atlasHeight > 16384 || glyphCount > 0x110000u ||
+        pairCount > (1u << 24)) {
+        return false;
+    }
+    in.glyphs.resize(glyphCount);
+    in.kerningPairs.resize(pairCount);
+    in.kerning.resize(pairCount);
+    in.atlas.resize((size_t)in.atlasWidth * (size_t)in.atlasHeight);
+    f.read((char*)in.glyphs.data(), in.glyphs.size() * sizeof(SdfGlyph));
+    f.read((char*)in.kerningPairs.data(), in.kerningPairs.size() * sizeof(uint64_t));
+    f.read((char*)in.kerning.data(), in.kerning.size() * sizeof(float));
+    f.read((char*)in.atlas.data(), in.atlas.size());
+    if (!f) return false;
+    *this = in;
+    return true;
+}
@@ -0,0 +1,41 @@
+#ifndef SDFFONT_HPP
+#define SDFFONT_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One glyph of an SdfFont. Plane bounds are in em units relative to the pen position on
+// the baseline and include the spread margin, so a quad scaled by the text size and
+// textured with the atlas rectangle shows the glyph wherever its distance is in range.
+struct SdfGlyph {
+    uint32_t codepoint = 0;
+    float advance = 0.0f;          // em units
+    float planeLeft = 0.0f, planeBottom = 0.0f, planeRight = 0.0f, planeTop = 0.0f;
+    uint16_t atlasX = 0, atlasY = 0, atlasWidth = 0, atlasHeight = 0; // texels, y up; 0 wide = nothing to draw
+};
+
+// Signed-distance-field font: one R8 atlas (0.5 = on the outline, 1 = spread texels
+// inside, 0 = spread texels outside), per-glyph metrics and kerning pairs, all in em
+// units so one atlas serves every text size. Bilinear filtering of a distance stays a
+// good distance, so edges are sharp when magnified and an outline is just a second
+// threshold. Fonts are built offline from TrueType files (tools/sdffontbuild.hpp,
+// `make sdf-font`); the renderer only loads them.
+struct SdfFont {
+    float emPixels = 0.0f, spread = 0.0f;
+    float ascender = 0.0f, descender = 0.0f, lineGap = 0.0f; // em units, descender < 0
+    int atlasWidth = 0, atlasHeight = 0;
+    std::vector<uint8_t> atlas;        // atlasWidth x atlasHeight, rows bottom-up (GL order)
+    std::vector<SdfGlyph> glyphs;      // sorted by codepoint
+    std::vector<uint64_t> kerningPairs; // (left << 32 | right), sorted; parallel to kerning
+    std::vector<float> kerning;         // em units added to the advance between the pair
+
+    const SdfGlyph* glyph(uint32_t codepoint) const;
+    float kern(uint32_t left, uint32_t right) const;
+
+    // Raw little-endian file: "SDFF", version, metrics, glyphs, kerning, R8 atlas.
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+};
+
+#endif
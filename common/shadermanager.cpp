@@ -0,0 +1,502 @@
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <utility>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "gldispatch.hpp"
+#include "shadermanager.hpp"
+
+// KHR_parallel_shader_compile (same values as the ARB extension), not in the 3.3 loader
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADS_PROC)(GLuint count);
+
+namespace {
+
+std::string shaderLog(GLuint shader, const char* stage) {
+    GLint ok = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (ok) return std::string();
+    char log[1024] = { 0 };
+    glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+    return std::string(stage) + " shader: " + log;
+}
+
+// Reads the link status (and the logs if it failed); waits for the driver if needed.
+bool linkResult(GLuint program, GLuint vs, GLuint fs, std::string& log) {
+    GLint ok = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (ok) return true;
+    log = shaderLog(vs, "vertex") + shaderLog(fs, "fragment");
+    char linkLog[1024] = { 0 };
+    glGetProgramInfoLog(program, sizeof(linkLog), NULL, linkLog);
+    log += linkLog;
+    return false;
+}
+
+// Compile + link, blocking. The shaders are deleted (the program keeps them alive).
+GLuint compileAndLink(const char* vertexSrc, const char* fragmentSrc, bool& ok, std::string& log) {
+    GLuint vs = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vs, 1, &vertexSrc, NULL);
+    glCompileShader(vs);
+    GLuint fs = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fs, 1, &fragmentSrc, NULL);
+    glCompileShader(fs);
+    GLuint prog = glCreateProgram();
+    glAttachShader(prog, vs); glAttachShader(prog, fs);
+    glLinkProgram(prog);
+    ok = linkResult(prog, vs, fs, log);
+    glDeleteShader(vs); glDeleteShader(fs);
+    return prog;
+}
+
+PFNGLMAXSHADERCOMPILERTHREADS_PROC loadParallelCompile() {
+    if (glfwExtensionSupported("GL_KHR_parallel_shader_compile")) {
+        return (PFNGLMAXSHADERCOMPILERTHREADS_PROC)glfwGetProcAddress("glMaxShaderCompilerThreadsKHR");
+    }
+    if (glfwExtensionSupported("GL_ARB_parallel_shader_compile")) {
+        return (PFNGLMAXSHADERCOMPILERTHREADS_PROC)glfwGetProcAddress("glMaxShaderCompilerThreadsARB");
+    }
+    return nullptr;
+}
+
+// `#include "file"` (leading blanks allowed): true with the quoted path in `target`.
+// Other directives and text are left to the GLSL compiler.
+bool includeLine(const std::string& line, std::string& target, bool& malformed) {
+    size_t p = line.find_first_not_of(" \t");
+    if (p == std::string::npos || line.compare(p, 8, "#include") != 0) return false;
+    size_t open = line.find('"', p + 8);
+    size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+    malformed = close == std::string::npos;
+    if (!malformed) target = line.substr(open + 1, close - open - 1);
+    return true;
+}
+
+bool expandFile(const std::string& path, std::string& out, std::vector<std::string>& files, std::string& error) {
+    int index = (int)files.size();
+    files.push_back(path);
+    std::ifstream in(path.c_str());
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::string line;
+    for (int lineNo = 1; std::getline(in, line); ++lineNo) {
+        std::string target;
+        bool malformed = false;
+        if (!includeLine(line, target, malformed)) {
+            out += line;
+            out += '\n';
+            continue;
+        }
+        if (malformed) {
+            std::ostringstream msg;
+            msg << path << ":" << lineNo << ": #include wants a \"file\"";
+            error = msg.str();
+            return false;
+        }
+        std::string dir = path.substr(0, path.find_last_of('/') + 1);
+        std::string included = FileWatcher::canonical(dir + target);
+        if (std::find(files.begin(), files.end(), included) == files.end()) {
+            // GLSL 3.30 numbering: the line after "#line n s" is line n + 1 of string s
+            std::ostringstream enter;
+            enter << "#line 0 " << files.size() << "\n";
+            out += enter.str();
+            if (!expandFile(included, out, files, error)) return false;
+        }
+        std::ostringstream back;
+        back << "#line " << lineNo << " " << index << "\n";
+        out += back.str();
+    }
+    return true;
+}
+
+std::string describeSources(const char* stage, const std::vector<std::string>& files) {
+    std::ostringstream os;
+    os << stage << ":";
+    for (size_t i = 0; i < files.size(); ++i) os << (i ? ", " : " ") << i << " = " << files[i];
+    return os.str();
+}
+
+} // namespace
+
+GLuint compileProgramNow(const std::string& name, const char* vertexSrc, const char* fragmentSrc) {
+    bool ok = false;
+    std::string log;
+    GLuint prog = compileAndLink(vertexSrc, fragmentSrc, ok, log);
+    if (ok) return prog;
+    std::cerr << "[SHADERS] " << name << " failed:\n" << log << std::endl;
+    glDeleteProgram(prog);
+    return 0;
+}
+
+bool preprocessShaderFile(const std::string& path, std::string& source, std::vector<std::string>& files,
+                          std::string& error) {
+    source.clear();
+    files.clear();
+    return expandFile(FileWatcher::canonical(path), source, files, error);
+}
+
+const char* ShaderManager::modeName(ShaderCompileMode mode) {
+    switch (mode) {
+    case SHADER_COMPILE_PARALLEL: return "parallel_shader_compile";
+    case SHADER_COMPILE_WORKER: return "shared-context worker";
+    default: return "synchronous";
+    }
+}
+
+void ShaderManager::init(GLFWwindow* mainWindow, bool allowAsync) {
+    destroy();
+    compileMode = SHADER_COMPILE_SYNC;
+    if (!mainWindow || !allowAsync || glDispatchBackend() == GL_BACKEND_NULL) return;
+
+    if (PFNGLMAXSHADERCOMPILERTHREADS_PROC maxThreads = loadParallelCompile()) {
+        maxThreads(0xFFFFFFFFu); // as many as the driver likes
+        compileMode = SHADER_COMPILE_PARALLEL;
+        return;
+    }
+    // The call counters are GL-thread only: a second thread must not go through them.
+    if (glDispatchInstalled()) return;
+
+    glfwDefaultWindowHints();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+    workerWindow = glfwCreateWindow(1, 1, "shader compiler", NULL, mainWindow);
+    glfwDefaultWindowHints();
+    if (!workerWindow) {
+        std::cerr << "[SHADERS] no shared context for the compile thread, compiling synchronously\n";
+        return;
+    }
+    quit = false;
+    worker = std::thread(&ShaderManager::workerLoop, this);
+    compileMode = SHADER_COMPILE_WORKER;
+}
+
+void ShaderManager::destroy() {
+    if (worker.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        jobsAvailable.notify_all();
+        worker.join();
+    }
+    if (workerWindow) {
+        glfwDestroyWindow(workerWindow);
+        workerWindow = nullptr;
+    }
+    jobs.clear();
+    for (const Result& r : results) glDeleteProgram(r.program);
+    results.clear();
+    for (Entry& e : entries) {
+        if (e.linking) {
+            glDeleteShader(e.vertexShader);
+            glDeleteShader(e.fragmentShader);
+            glDeleteProgram(e.linking);
+        }
+    }
+    retired.clear();
+    entries.clear(); // GpuProgram deletes the linked ones
+    pending = 0;
+    watcher.destroy();
+    hotReload = false;
+    compileMode = SHADER_COMPILE_SYNC;
+}
+
+ShaderHandle ShaderManager::addEntry(const std::string& name, const std::vector<ShaderBlockBinding>& blocks) {
+    entries.push_back(Entry());
+    Entry& e = entries.back();
+    e.name = name;
+    e.blocks = blocks;
+    e.submitted = std::chrono::steady_clock::now();
+    return (ShaderHandle)(entries.size() - 1);
+}
+
+ShaderHandle ShaderManager::submit(const std::string& name, const char* vertexSrc, const char* fragmentSrc,
+                                   const std::vector<ShaderBlockBinding>& blocks) {
+    ShaderHandle handle = addEntry(name, blocks);
+    ++pending;
+    compile(handle, vertexSrc, fragmentSrc);
+    return handle;
+}
+
+ShaderHandle ShaderManager::submitFiles(const std::string& name, const std::string& vertexPath,
+                                        const std::string& fragmentPath, const std::vector<ShaderBlockBinding>& blocks) {
+    ShaderHandle handle = addEntry(name, blocks);
+    Entry& e = entries[handle];
+    e.vertexPath = vertexPath;
+    e.fragmentPath = fragmentPath;
+    std::string vertexSrc, fragmentSrc, error;
+    if (!readFiles(e, vertexSrc, fragmentSrc, error)) {
+        std::cerr << "[SHADERS] " << name << ": " << error << ", keeping its fallback" << std::endl;
+        e.state = FAILED;
+        return handle;
+    }
+    ++pending;
+    compile(handle, vertexSrc, fragmentSrc);
+    return handle;
+}
+
+bool ShaderManager::readFiles(Entry& e, std::string& vertexSrc, std::string& fragmentSrc, std::string& error) {
+    std::vector<std::string> vertexFiles, fragmentFiles;
+    bool ok = preprocessShaderFile(e.vertexPath, vertexSrc, vertexFiles, error) &&
+              preprocessShaderFile(e.fragmentPath, fragmentSrc, fragmentFiles, error);
+    if (ok) e.sourceMap = describeSources("vertex", vertexFiles) + "; " + describeSources("fragment", fragmentFiles);
+    // A good read replaces the list (dropped includes stop counting); a failed one only
+    // adds to it, so fixing the file it stopped at triggers the retry.
+    if (ok) e.files.clear();
+    vertexFiles.insert(vertexFiles.end(), fragmentFiles.begin(), fragmentFiles.end());
+    for (const std::string& f : vertexFiles) {
+        if (std::find(e.files.begin(), e.files.end(), f) == e.files.end()) e.files.push_back(f);
+    }
+    if (hotReload) {
+        for (const std::string& f : e.files) watcher.watch(f);
+    }
+    return ok;
+}
+
+void ShaderManager::compile(ShaderHandle handle, const std::string& vertexSrc, const std::string& fragmentSrc) {
+    Entry& e = entries[handle];
+    switch (compileMode) {
+    case SHADER_COMPILE_PARALLEL: {
+        if (e.linking) { // a newer edit replaces a reload still in flight
+            glDeleteShader(e.vertexShader);
+            glDeleteShader(e.fragmentShader);
+            glDeleteProgram(e.linking);
+        }
+        // every call returns at once; the driver compiles and links on its own threads
+        const char* vs = vertexSrc.c_str();
+        const char* fs = fragmentSrc.c_str();
+        e.vertexShader = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(e.vertexShader, 1, &vs, NULL);
+        glCompileShader(e.vertexShader);
+        e.fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(e.fragmentShader, 1, &fs, NULL);
+        glCompileShader(e.fragmentShader);
+        e.linking = glCreateProgram();
+        glAttachShader(e.linking, e.vertexShader);
+        glAttachShader(e.linking, e.fragmentShader);
+        glLinkProgram(e.linking);
+        break;
+    }
+    case SHADER_COMPILE_WORKER: {
+        Job job;
+        job.handle = handle;
+        job.vertexSrc = vertexSrc;
+        job.fragmentSrc = fragmentSrc;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(job);
+        }
+        jobsAvailable.notify_one();
+        break;
+    }
+    default: {
+        bool ok = false;
+        std::string log;
+        GLuint prog = compileAndLink(vertexSrc.c_str(), fragmentSrc.c_str(), ok, log);
+        finalize(handle, prog, ok, log);
+        break;
+    }
+    }
+}
+
+void ShaderManager::enableHotReload() {
+    hotReload = true;
+    for (const Entry& e : entries) {
+        for (const std::string& f : e.files) watcher.watch(f);
+    }
+}
+
+void ShaderManager::reloadChanged(const std::vector<std::string>& changed) {
+    for (ShaderHandle h = 0; h < (ShaderHandle)entries.size(); ++h) {
+        Entry& e = entries[h];
+        bool affected = false;
+        for (const std::string& f : changed) {
+            affected = affected || std::find(e.files.begin(), e.files.end(), f) != e.files.end();
+        }
+        if (!affected || e.vertexPath.empty()) continue;
+        std::string vertexSrc, fragmentSrc, error;
+        if (!readFiles(e, vertexSrc, fragmentSrc, error)) {
+            std::cerr << "[SHADERS] " << e.name << ": " << error << ", keeping the current program" << std::endl;
+            ++reloadFailures;
+            continue;
+        }
+        e.submitted = std::chrono::steady_clock::now();
+        ++reloads;
+        if (e.state == FAILED) { // never linked: this is its first program
+            e.state = PENDING;
+            ++pending;
+        }
+        compile(h, vertexSrc, fragmentSrc);
+    }
+}
+
+void ShaderManager::workerLoop() {
+    glfwMakeContextCurrent(workerWindow);
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobsAvailable.wait(lock, [this] { return quit || !jobs.empty(); });
+            if (quit) break;
+            job = jobs.front();
+            jobs.pop_front();
+        }
+        Result r;
+        r.handle = job.handle;
+        r.program = compileAndLink(job.vertexSrc.c_str(), job.fragmentSrc.c_str(), r.ok, r.log);
+        // the GL thread may use the program as soon as it sees the result
+        glFinish();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            results.push_back(r);
+        }
+        resultsAvailable.notify_all();
+        glfwPostEmptyEvent(); // an idle --on-demand loop blocks in glfwWaitEvents until then
+    }
+    glfwMakeContextCurrent(NULL);
+}
+
+void ShaderManager::finalize(ShaderHandle handle, GLuint prog, bool ok, const std::string& log) {
+    Entry& e = entries[handle];
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - e.submitted).count();
+    bool first = e.state == PENDING;
+    if (first) {
+        e.readyMs = ms;
+        --pending;
+    }
+    ++finalized;
+    e.vertexShader = e.fragmentShader = e.linking = 0;
+    if (!ok) {
+        std::cerr << "[SHADERS] " << e.name << " failed, "
+                  << (e.program.get() ? "keeping the last good program" : "keeping its fallback") << ":\n" << log;
+        if (!e.sourceMap.empty()) std::cerr << "(source strings " << e.sourceMap << ")\n";
+        std::cerr << std::flush;
+        if (prog) glDeleteProgram(prog);
+        if (first) e.state = FAILED;
+        else ++reloadFailures;
+        return;
+    }
+    if (e.program) { // the draw list in flight may still use it
+        Retired r;
+        r.program = std::move(e.program);
+        r.frame = frames;
+        retired.push_back(std::move(r));
+    }
+    e.program.adopt(prog, e.name);
+    for (const ShaderBlockBinding& b : e.blocks) {
+        GLuint index = glGetUniformBlockIndex(prog, b.block);
+        if (index != GL_INVALID_INDEX) glUniformBlockBinding(prog, index, b.binding);
+    }
+    if (!first) {
+        std::ios::fmtflags f = std::cout.flags();
+        std::streamsize p = std::cout.precision();
+        std::cout << "[SHADERS] reloaded " << e.name << " (" << std::fixed << std::setprecision(1) << ms
+                  << " ms)" << std::endl;
+        std::cout.precision(p);
+        std::cout.flags(f);
+    }
+    e.state = READY;
+}
+
+void ShaderManager::pollParallel(bool wait) {
+    for (ShaderHandle h = 0; h < (ShaderHandle)entries.size(); ++h) {
+        Entry& e = entries[h];
+        if (!e.linking) continue;
+        if (!wait) {
+            GLint done = GL_FALSE;
+            glGetProgramiv(e.linking, GL_COMPLETION_STATUS_KHR, &done);
+            if (!done) continue;
+        }
+        std::string log;
+        bool ok = linkResult(e.linking, e.vertexShader, e.fragmentShader, log);
+        glDeleteShader(e.vertexShader);
+        glDeleteShader(e.fragmentShader);
+        finalize(h, e.linking, ok, log);
+    }
+}
+
+int ShaderManager::poll() {
+    int before = finalized;
+    if (hotReload) {
+        std::vector<std::string> changed = watcher.changed();
+        if (!changed.empty()) reloadChanged(changed);
+    }
+    if (compileMode == SHADER_COMPILE_PARALLEL) {
+        pollParallel(false);
+    } else if (compileMode == SHADER_COMPILE_WORKER) { // reloads finish with nothing pending
+        std::vector<Result> done;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.swap(results);
+        }
+        for (const Result& r : done) finalize(r.handle, r.program, r.ok, r.log);
+    }
+    return finalized - before;
+}
+
+void ShaderManager::finish() {
+    if (compileMode == SHADER_COMPILE_PARALLEL) {
+        pollParallel(true);
+        return;
+    }
+    while (compileMode == SHADER_COMPILE_WORKER && pending) {
+        std::vector<Result> done;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            resultsAvailable.wait(lock, [this] { return !results.empty(); });
+            done.swap(results);
+        }
+        for (const Result& r : done) finalize(r.handle, r.program, r.ok, r.log);
+    }
+}
+
+GLuint ShaderManager::program(ShaderHandle handle, GLuint fallback) const {
+    if (handle >= entries.size() || entries[handle].state != READY) return fallback;
+    return entries[handle].program.get();
+}
+
+void ShaderManager::noteFrame() {
+    ++frames;
+    if (pending) ++fallbackFrames;
+    // retired during frame N: N's draw list was built before the swap, N+1's after it
+    while (!retired.empty() && frames >= retired.front().frame + RETIRE_FRAMES) retired.pop_front();
+}
+
+bool ShaderManager::ready(ShaderHandle handle) const {
+    return handle < entries.size() && entries[handle].state == READY;
+}
+
+void ShaderManager::report(std::ostream& os) const {
+    if (entries.empty()) return;
+    float slowest = 0.0f;
+    size_t failed = 0;
+    for (const Entry& e : entries) {
+        if (e.state != PENDING) slowest = std::max(slowest, e.readyMs);
+        if (e.state == FAILED) ++failed;
+    }
+    std::ios::fmtflags f = os.flags();
+    std::streamsize p = os.precision();
+    os << "  shaders        : " << entries.size() << " programs, " << modeName(compileMode) << ", slowest "
+       << std::fixed << std::setprecision(1) << slowest << " ms submit-to-ready, " << fallbackFrames
+       << " frames with a fallback";
+    if (failed) os << ", " << failed << " failed";
+    if (pending) os << ", " << pending << " never finished";
+    if (hotReload) {
+        os << ", " << reloads << " hot reloads";
+        if (reloadFailures) os << " (" << reloadFailures << " failed)";
+        os << " via " << watcher.backendName();
+    }
+    os << "\n";
+    os.precision(p);
+    os.flags(f);
+}
@@ -0,0 +1,167 @@
+#ifndef SHADERMANAGER_HPP
+#define SHADERMANAGER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "filewatcher.hpp"
+#include "gpuresources.hpp"
+
+struct GLFWwindow;
+
+typedef uint32_t ShaderHandle;
+const ShaderHandle SHADER_NONE = ~(ShaderHandle)0;
+
+enum ShaderCompileMode {
+    SHADER_COMPILE_SYNC,        // compiled inside submit() (null backend, counted GL, no window)
+    SHADER_COMPILE_PARALLEL,    // KHR/ARB_parallel_shader_compile: the driver's threads, polled
+    SHADER_COMPILE_WORKER       // our thread with a hidden context sharing the window's objects
+};
+
+// Uniform block -> binding point, applied once the program has linked.
+struct ShaderBlockBinding {
+    const char* block;
+    unsigned int binding;
+};
+
+// Compiles and links at once, on the calling (GL) thread, for the small programs that are
+// needed before the first frame (the fallback, FXAA, text). Errors are printed under
+// `name`; returns 0 if the program did not link.
+GLuint compileProgramNow(const std::string& name, const char* vertexSrc, const char* fragmentSrc);
+
+// Reads a GLSL file, replacing each `#include "file"` line (path relative to the
+// including file) with that file's text. A file already pulled in is skipped, so shared
+// blocks can be included from several headers and cycles end. #line directives keep
+// compiler messages pointing at the right file: source string N is files[N], every path
+// read (even one that failed to open, so it can be watched for until it appears).
+bool preprocessShaderFile(const std::string& path, std::string& source, std::vector<std::string>& files,
+                          std::string& error);
+
+// Compiles and links programs without blocking the frame. submit() hands the sources
+// off and returns at once; poll(), once per frame on the GL thread, picks up whatever
+// has finished. Until then program() returns the caller's fallback, so a new variant
+// shows up a few frames late instead of stalling one. A program that fails keeps the
+// fallback and its log is printed once.
+//
+// Programs submitted from files can be hot-reloaded: with enableHotReload(), poll()
+// also looks for written files and recompiles, on the same background path, only the
+// programs that include one. The new program replaces the old inside poll(), between
+// frames; if it fails the last good one stays. The replaced program is deleted only by
+// the second noteFrame() after that, since a draw list built before the swap (one frame
+// ahead of submission) still names it.
+//
+//   ShaderHandle lit = shaders.submit("shader/phong", vs, fs, { { "PerDraw", 0 } });
+//   ... every frame:
+//   shaders.poll();
+//   glUseProgram(shaders.program(lit, fallbackProgram));
+class ShaderManager {
+public:
+    ShaderManager() {}
+    ~ShaderManager() { destroy(); }
+
+    // GL thread, context current. `allowAsync` false (or no window) compiles in submit().
+    // The worker mode creates a hidden 1x1 window, so this must run on GLFW's main thread.
+    void init(GLFWwindow* mainWindow, bool allowAsync = true);
+    // Stops the worker, deletes every program.
+    void destroy();
+
+    ShaderHandle submit(const std::string& name, const char* vertexSrc, const char* fragmentSrc,
+                        const std::vector<ShaderBlockBinding>& blocks = std::vector<ShaderBlockBinding>());
+    // preprocessShaderFile() on both stages; a file that can't be read fails the program.
+    ShaderHandle submitFiles(const std::string& name, const std::string& vertexPath, const std::string& fragmentPath,
+                             const std::vector<ShaderBlockBinding>& blocks = std::vector<ShaderBlockBinding>());
+    // Watches every file the file-based programs read (now and later).
+    void enableHotReload();
+    bool hotReloading() const { return hotReload; }
+    // Never blocks. Returns the number of programs that became ready, were replaced by a
+    // reload, or failed this call.
+    int poll();
+    // Blocks until nothing is pending (e.g. before a run whose first frame must be final).
+    void finish();
+
+    GLuint program(ShaderHandle handle, GLuint fallback = 0) const;
+    bool ready(ShaderHandle handle) const;
+    size_t pendingCount() const { return pending; }
+    ShaderCompileMode mode() const { return compileMode; }
+    static const char* modeName(ShaderCompileMode mode);
+
+    // "  shaders        : N programs, <mode>, slowest X ms submit-to-ready, F frames on fallback[, R hot reloads]"
+    void report(std::ostream& os) const;
+    // Once per drawn frame, after its draw list is picked: counts frames drawn while
+    // something was pending and deletes replaced programs no draw list can name anymore.
+    void noteFrame();
+
+private:
+    ShaderManager(const ShaderManager&);
+    ShaderManager& operator=(const ShaderManager&);
+
+    enum State { PENDING, READY, FAILED };
+    struct Entry {
+        std::string name;
+        State state = PENDING;
+        GpuProgram program;
+        std::vector<ShaderBlockBinding> blocks;
+        GLuint vertexShader = 0, fragmentShader = 0, linking = 0; // parallel mode, until done
+        std::chrono::steady_clock::time_point submitted;
+        float readyMs = 0.0f;                      // first compile
+        std::string vertexPath, fragmentPath;      // empty for submit()
+        std::vector<std::string> files;            // both stages' includes, canonical
+        std::string sourceMap;                     // "vertex: 0 = a, 1 = b; fragment: ..."
+    };
+    struct Retired {            // replaced by a reload, deleted RETIRE_FRAMES frames later
+        GpuProgram program;
+        unsigned long long frame;
+    };
+    static const unsigned long long RETIRE_FRAMES = 2;
+    struct Job {                // worker mode, copied in
+        ShaderHandle handle;
+        std::string vertexSrc, fragmentSrc;
+    };
+    struct Result {             // worker mode, copied out
+        ShaderHandle handle;
+        GLuint program;
+        bool ok;
+        std::string log;
+    };
+
+    ShaderHandle addEntry(const std::string& name, const std::vector<ShaderBlockBinding>& blocks);
+    bool readFiles(Entry& e, std::string& vertexSrc, std::string& fragmentSrc, std::string& error);
+    void compile(ShaderHandle handle, const std::string& vertexSrc, const std::string& fragmentSrc);
+    void reloadChanged(const std::vector<std::string>& changed);
+    void finalize(ShaderHandle handle, GLuint program, bool ok, const std::string& log);
+    void pollParallel(bool wait);
+    void workerLoop();
+
+    ShaderCompileMode compileMode = SHADER_COMPILE_SYNC;
+    std::vector<Entry> entries;
+    size_t pending = 0;
+    unsigned long long fallbackFrames = 0;
+    unsigned long long frames = 0;      // noteFrame() calls
+    std::deque<Retired> retired;
+    int finalized = 0;                  // finalize() calls, for poll()'s count
+
+    // hot reload
+    bool hotReload = false;
+    FileWatcher watcher;
+    unsigned int reloads = 0, reloadFailures = 0;
+
+    // worker mode
+    GLFWwindow* workerWindow = nullptr;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable jobsAvailable, resultsAvailable;
+    std::deque<Job> jobs;
+    std::vector<Result> results;
+    bool quit = false;
+};
+
+#endif
@@ -1,124 +1,478 @@
 #include <vector>
 #include <cstring>
-
-#include <GL/glew.h>
-
-#include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-using namespace glm;
-
-#include "shader.hpp"
+#include <fstream>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+#include <glad/glad.h>
+
+#include "gpuresources.hpp"
+#include "ringbuffer.hpp"
+#include "sdffont.hpp"
+#include "shadermanager.hpp"
 #include "texture.hpp"
 
 #include "text2D.hpp"
 
-unsigned int Text2DTextureID;
-unsigned int Text2DVertexBufferID;
-unsigned int Text2DUVBufferID;
-unsigned int Text2DShaderID;
-unsigned int Text2DUniformID;
-
-void initText2D(const char * texturePath){
+namespace {
+
+// One glyph corner, shared by both fonts so a frame's text stays one draw: screen
+// position in quarter pixels, atlas coordinates (normalized), fill and outline colours,
+// the outline width in distance-field units and which font the glyph is from. Padded to
+// 32 bytes: ring sections are sized in multiples of 256, so with a size that divides 256
+// every section (also after the ring grows) starts on a whole vertex and the draw's
+// first vertex is just offset / sizeof(TextVertex).
+struct TextVertex {
+	int16_t x, y;
+	uint16_t u, v;
+	uint8_t color[4];
+	uint8_t outlineColor[4];
+	uint8_t outlineWidth;   // 0..255 = 0..0.5 of the field's range below the edge
+	uint8_t sdf;            // 0 = 16x16 grid font, 1 = distance-field font
+	uint8_t pad[14];
+};
+static_assert(256 % sizeof(TextVertex) == 0, "ring sections must start on a vertex");
+const size_t VERTICES_PER_GLYPH = 6;
+const float SUBPIXELS = 4.0f;   // position units per pixel
+
+const char* const TEXT_VERTEX_SHADER = R"(
+	#version 330 core
+	layout(location = 0) in vec2 vertexPosition_screenspace;
+	layout(location = 1) in vec2 atlasUV;
+	layout(location = 2) in vec4 fillColor;
+	layout(location = 3) in vec4 outlineColor;
+	layout(location = 4) in vec2 outlineWidthAndFont;
+
+	uniform vec2 screenSize;
+
+	out vec2 UV;
+	flat out vec4 fill;
+	flat out vec4 outline;
+	flat out float outlineEdge;
+	flat out float sdfGlyph;
+
+	void main(){
+		// quarter pixels, [0..width][0..height] -> [-1..1][-1..1]
+		vec2 halfSize = 0.5 * screenSize;
+		gl_Position = vec4((vertexPosition_screenspace * 0.25 - halfSize) / halfSize, 0, 1);
+		UV = atlasUV;
+		fill = fillColor;
+		outline = outlineColor;
+		outlineEdge = 0.5 - 0.5 * outlineWidthAndFont.x;
+		sdfGlyph = outlineWidthAndFont.y;
+	}
+)";
+
+const char* const TEXT_FRAGMENT_SHADER = R"(
+	#version 330 core
+	in vec2 UV;
+	flat in vec4 fill;
+	flat in vec4 outline;
+	flat in float outlineEdge;
+	flat in float sdfGlyph;
+	out vec4 color;
+
+	uniform sampler2D myTextureSampler;
+	uniform sampler2D sdfFont;
+
+	void main(){
+		if (sdfGlyph < 0.5) {
+			color = texture(myTextureSampler, UV) * fill;
+			return;
+		}
+		// 0.5 is the glyph's edge; the smoothing band is one screen pixel wide at any size
+		float d = texture(sdfFont, UV).r;
+		float band = max(0.7 * fwidth(d), 1.0 / 255.0);
+		float inside = smoothstep(0.5 - band, 0.5 + band, d);
+		float covered = smoothstep(outlineEdge - band, outlineEdge + band, d);
+		vec4 c = mix(outline, fill, inside);
+		color = vec4(c.rgb, c.a * covered);
+	}
+)";
+
+GpuTexture Text2DOwnedTexture;
+unsigned int Text2DTextureID = 0;
+GpuTexture Text2DSdfTexture;
+SdfFont Text2DSdfFont;
+GpuProgram Text2DShader;
+GpuVertexArray Text2DVAO;
+RingBuffer Text2DRing;          // this frame's glyphs, written in place by printText2D
+GLuint Text2DRingBufferID = 0;  // buffer the VAO's attributes point at (changes when the ring grows)
+GLint Text2DUniformID = -1;
+GLint Text2DSdfUniformID = -1;
+GLint Text2DScreenSizeID = -1;
+
+bool Text2DFrameOpen = false;   // ring section mapped, glyphs being appended
+size_t Text2DFirstVertex = 0;   // first vertex of this frame's batch in the ring buffer
+size_t Text2DVertexCount = 0;
+size_t Text2DBytesWanted = 0;   // this frame's text, including what didn't fit
+Text2DStats Text2DCounters;
+int Text2DBitmapCell = 0;       // pixels per grid cell of initText2DBitmapFont's font
+
+void initText2DCommon(){
+	if (Text2DShader.get()) return; // second font of the same batch
+	Text2DShader.adopt(compileProgramNow("shader/text2D", TEXT_VERTEX_SHADER, TEXT_FRAGMENT_SHADER), "shader/text2D");
+	Text2DUniformID = glGetUniformLocation(Text2DShader.get(), "myTextureSampler");
+	Text2DSdfUniformID = glGetUniformLocation(Text2DShader.get(), "sdfFont");
+	Text2DScreenSizeID = glGetUniformLocation(Text2DShader.get(), "screenSize");
+	Text2DVAO.create("geometry/text2D");
+	// a few thousand glyphs per frame before the first growth
+	Text2DRing.init(GL_ARRAY_BUFFER, 4096 * VERTICES_PER_GLYPH * sizeof(TextVertex), 3, "ring/text2D");
+	Text2DRingBufferID = 0;
+	Text2DFrameOpen = false;
+	Text2DVertexCount = Text2DBytesWanted = 0;
+}
 
-	// Initialize texture
-	Text2DTextureID = loadDDS(texturePath);
+// Room for `glyphs` quads in this frame's section, or null (dropped this frame, the
+// ring grows at the next flush).
+TextVertex* allocateGlyphs(size_t glyphs){
+	size_t bytes = glyphs * VERTICES_PER_GLYPH * sizeof(TextVertex);
+	Text2DBytesWanted += bytes;
+	if (!Text2DFrameOpen) {
+		Text2DRing.beginFrame();
+		Text2DFrameOpen = true;
+		Text2DVertexCount = 0;
+	}
+	// every allocation is a whole number of vertices, so a frame's strings are contiguous
+	size_t offset = 0;
+	TextVertex* v = (TextVertex*)Text2DRing.allocate(bytes, sizeof(TextVertex), offset);
+	if (!v) return nullptr;
+	if (Text2DVertexCount == 0) Text2DFirstVertex = offset / sizeof(TextVertex);
+	Text2DVertexCount += glyphs * VERTICES_PER_GLYPH;
+	return v;
+}
 
-	// Initialize VBO
-	glGenBuffers(1, &Text2DVertexBufferID);
-	glGenBuffers(1, &Text2DUVBufferID);
+int16_t toPosition(float pixels){
+	return (int16_t)std::max(-32768.0f, std::min(32767.0f, std::floor(pixels * SUBPIXELS + 0.5f)));
+}
 
-	// Initialize Shader
-	Text2DShaderID = LoadShaders( "TextVertexShader.vertexshader", "TextVertexShader.fragmentshader" );
+uint16_t toAtlas(float texel, int size){
+	return (uint16_t)std::max(0.0f, std::min(65535.0f, texel / (float)size * 65535.0f + 0.5f));
+}
 
-	// Initialize uniforms' IDs
-	Text2DUniformID = glGetUniformLocation( Text2DShaderID, "myTextureSampler" );
+void unpackColor(uint32_t rgba, uint8_t out[4]){
+	out[0] = (uint8_t)(rgba >> 24);
+	out[1] = (uint8_t)(rgba >> 16);
+	out[2] = (uint8_t)(rgba >> 8);
+	out[3] = (uint8_t)rgba;
+}
 
+// Two triangles of the quad; `base` carries the colours and flags.
+TextVertex* emitQuad(TextVertex* v, const TextVertex& base, int16_t left, int16_t bottom, int16_t right, int16_t top,
+                     uint16_t uLeft, uint16_t vBottom, uint16_t uRight, uint16_t vTop){
+	TextVertex upLeft = base, upRight = base, downRight = base, downLeft = base;
+	upLeft.x = left;     upLeft.y = top;       upLeft.u = uLeft;     upLeft.v = vTop;
+	upRight.x = right;   upRight.y = top;      upRight.u = uRight;   upRight.v = vTop;
+	downRight.x = right; downRight.y = bottom; downRight.u = uRight; downRight.v = vBottom;
+	downLeft.x = left;   downLeft.y = bottom;  downLeft.u = uLeft;   downLeft.v = vBottom;
+
+	*v++ = upLeft;
+	*v++ = downLeft;
+	*v++ = upRight;
+
+	*v++ = downRight;
+	*v++ = upRight;
+	*v++ = downLeft;
+	return v;
 }
 
-void printText2D(const char * text, int x, int y, int size){
+// Netpbm greyscale, plain (P2) or raw (P5), 8 bits.
+bool readPGM(const char* path, int& width, int& height, std::vector<unsigned char>& pixels){
+	std::ifstream in(path, std::ios::binary);
+	std::string magic;
+	if (!(in >> magic) || (magic != "P2" && magic != "P5")) return false;
+	int header[3];
+	for (int& h : header) {
+		while (in >> std::ws && in.peek() == '#') in.ignore(1 << 20, '\n');
+		if (!(in >> h)) return false;
+	}
+	width = header[0]; height = header[1];
+	if (width <= 0 || height <= 0 || header[2] <= 0 || header[2] > 255) return false;
+	pixels.resize((size_t)width * height);
+	if (magic == "P5") {
+		in.get();
+		return (bool)in.read((char*)pixels.data(), (std::streamsize)pixels.size());
+	}
+	for (unsigned char& p : pixels) {
+		int value;
+		if (!(in >> value)) return false;
+		p = (unsigned char)value;
+	}
+	return true;
+}
 
-	unsigned int length = strlen(text);
+} // namespace
 
-	// Fill buffers
-	std::vector<glm::vec2> vertices;
-	std::vector<glm::vec2> UVs;
-	for ( unsigned int i=0 ; i<length ; i++ ){
-		
-		glm::vec2 vertex_up_left    = glm::vec2( x+i*size     , y+size );
-		glm::vec2 vertex_up_right   = glm::vec2( x+i*size+size, y+size );
-		glm::vec2 vertex_down_right = glm::vec2( x+i*size+size, y      );
-		glm::vec2 vertex_down_left  = glm::vec2( x+i*size     , y      );
+bool initText2DBitmapFont(const char * pgmPath){
+	int width = 0, height = 0;
+	std::vector<unsigned char> bitmap;
+	if (!readPGM(pgmPath, width, height, bitmap)) {
+		std::cerr << "Cannot read bitmap font " << pgmPath << std::endl;
+		return false;
+	}
+	// glyph rows: a run of non-zero pixels in column 0, ended by the separator line
+	std::vector<int> rowTops;
+	int glyphHeight = 0;
+	for (int y = 0, run = 0; y < height; ++y) {
+		if (bitmap[(size_t)y * width]) { ++run; continue; }
+		if (!run) break;
+		rowTops.push_back(y - run);
+		glyphHeight = std::max(glyphHeight, run);
+		run = 0;
+	}
+	// glyphs: split at the 0 pixels of each row's separator line, codes from 32 up
+	struct Glyph { int x0, x1, top, height; };
+	std::vector<Glyph> glyphs;
+	int glyphWidth = 0;
+	for (int top : rowTops) {
+		int separator = top + glyphHeight;
+		if (separator >= height) break;
+		for (int x = 1, start = 1; x < width; ++x) {
+			if (bitmap[(size_t)separator * width + x] && x != width - 1) continue;
+			if (x == start) break;
+			glyphs.push_back(Glyph{ start, x - 1, top, glyphHeight });
+			glyphWidth = std::max(glyphWidth, x - start);
+			start = x + 1;
+		}
+	}
+	if (glyphs.empty()) {
+		std::cerr << "No glyphs in bitmap font " << pgmPath << std::endl;
+		return false;
+	}
+	// repack into the 16x16 grid printText2D expects: square cells, glyph centred
+	// horizontally and top-aligned, white with the bitmap as coverage
+	const int cell = std::max(glyphWidth, glyphHeight) + 1;
+	const int size = cell * 16;
+	std::vector<unsigned char> rgba((size_t)size * size * 4, 0);
+	for (size_t i = 0; i < glyphs.size() && 32 + i < 256; ++i) {
+		const Glyph& g = glyphs[i];
+		int code = 32 + (int)i;
+		int left = (code % 16) * cell + (cell - (g.x1 - g.x0 + 1)) / 2;
+		int top = (code / 16) * cell;
+		for (int y = 0; y < g.height; ++y) {
+			for (int x = g.x0; x <= g.x1; ++x) {
+				unsigned char* t = &rgba[(((size_t)(top + y) * size) + left + (x - g.x0)) * 4];
+				t[0] = t[1] = t[2] = 255;
+				t[3] = bitmap[(size_t)(g.top + y) * width + x];
+			}
+		}
+	}
+	initText2DCommon();
+	Text2DOwnedTexture.create("text2D/font");
+	glBindTexture(GL_TEXTURE_2D, Text2DOwnedTexture.get());
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+	// pixel font: drawn at its own size, so no filtering
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	gpuResources().setSize(GPU_TEXTURE, Text2DOwnedTexture.get(), gpuImageBytes(GL_RGBA8, size, size), "RGBA8");
+	Text2DTextureID = Text2DOwnedTexture.get();
+	Text2DBitmapCell = cell;
+	return true;
+}
 
-		vertices.push_back(vertex_up_left   );
-		vertices.push_back(vertex_down_left );
-		vertices.push_back(vertex_up_right  );
+int text2DBitmapFontCell(){
+	return Text2DBitmapCell;
+}
 
-		vertices.push_back(vertex_down_right);
-		vertices.push_back(vertex_up_right);
-		vertices.push_back(vertex_down_left);
+Text2DStats text2DStats(){
+	return Text2DCounters;
+}
 
-		char character = text[i];
-		float uv_x = (character%16)/16.0f;
-		float uv_y = (character/16)/16.0f;
+void initText2D(const char * texturePath){
+	initText2DCommon();
+	Text2DOwnedTexture.adopt(loadDDS(texturePath), "text2D/font");
+	Text2DTextureID = Text2DOwnedTexture.get();
+}
 
-		glm::vec2 uv_up_left    = glm::vec2( uv_x           , uv_y );
-		glm::vec2 uv_up_right   = glm::vec2( uv_x+1.0f/16.0f, uv_y );
-		glm::vec2 uv_down_right = glm::vec2( uv_x+1.0f/16.0f, (uv_y + 1.0f/16.0f) );
-		glm::vec2 uv_down_left  = glm::vec2( uv_x           , (uv_y + 1.0f/16.0f) );
-		UVs.push_back(uv_up_left   );
-		UVs.push_back(uv_down_left );
-		UVs.push_back(uv_up_right  );
+void initText2D(unsigned int fontTexture){
+	initText2DCommon();
+	Text2DTextureID = fontTexture;
+}
 
-		UVs.push_back(uv_down_right);
-		UVs.push_back(uv_up_right);
-		UVs.push_back(uv_down_left);
+bool initText2DSdf(const char * fontPath){
+	SdfFont font;
+	if (!font.load(fontPath)) {
+		std::cerr << "Cannot load SDF font " << fontPath << " (build it with `make sdf-font`)" << std::endl;
+		return false;
 	}
-	glBindBuffer(GL_ARRAY_BUFFER, Text2DVertexBufferID);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec2), &vertices[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ARRAY_BUFFER, Text2DUVBufferID);
-	glBufferData(GL_ARRAY_BUFFER, UVs.size() * sizeof(glm::vec2), &UVs[0], GL_STATIC_DRAW);
-
-	// Bind shader
-	glUseProgram(Text2DShaderID);
-
-	// Bind texture
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, Text2DTextureID);
-	// Set our "myTextureSampler" sampler to use Texture Unit 0
-	glUniform1i(Text2DUniformID, 0);
-
-	// 1rst attribute buffer : vertices
-	glEnableVertexAttribArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, Text2DVertexBufferID);
-	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (void*)0 );
+	initText2DCommon();
+	Text2DSdfFont = font;
+	Text2DSdfFont.atlas.clear(); // lives on the GPU from here on
+	Text2DSdfTexture.create("text2D/sdf font");
+	glBindTexture(GL_TEXTURE_2D, Text2DSdfTexture.get());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, font.atlasWidth, font.atlasHeight, 0, GL_RED, GL_UNSIGNED_BYTE, font.atlas.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	// a distance survives bilinear filtering; mipmaps keep small text from shimmering
+	glGenerateMipmap(GL_TEXTURE_2D);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	gpuResources().setSize(GPU_TEXTURE, Text2DSdfTexture.get(), gpuImageBytes(GL_R8, font.atlasWidth, font.atlasHeight) * 4 / 3,
+	                       "R8 + mips");
+	return true;
+}
 
-	// 2nd attribute buffer : UVs
-	glEnableVertexAttribArray(1);
-	glBindBuffer(GL_ARRAY_BUFFER, Text2DUVBufferID);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, (void*)0 );
+void printText2D(const char * text, int x, int y, int size){
 
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	size_t length = strlen(text);
+	if (length == 0) return;
+	TextVertex* v = allocateGlyphs(length);
+	if (!v) return;
+	++Text2DCounters.strings;
+	Text2DCounters.glyphs += length;
+
+	TextVertex base;
+	memset(&base, 0, sizeof(base));
+	unpackColor(0xFFFFFFFFu, base.color);
+	for (size_t i = 0; i < length; i++) {
+		int16_t left   = toPosition((float)(x + (int)i * size));
+		int16_t right  = toPosition((float)(x + (int)i * size + size));
+		int16_t bottom = toPosition((float)y);
+		int16_t top    = toPosition((float)(y + size));
+
+		// cell in the 16x16 grid, first row at the top of the texture (DDS, not flipped)
+		unsigned char character = (unsigned char)text[i];
+		int cellLeft = character % 16, cellTop = character / 16;
+		v = emitQuad(v, base, left, bottom, right, top,
+		             toAtlas((float)cellLeft, 16), toAtlas((float)(cellTop + 1), 16),
+		             toAtlas((float)(cellLeft + 1), 16), toAtlas((float)cellTop, 16));
+	}
+}
 
-	// Draw call
-	glDrawArrays(GL_TRIANGLES, 0, vertices.size() );
+void printText2DSdf(const char * text, float x, float y, float size, uint32_t color, float outlineWidth, uint32_t outlineColor){
 
-	glDisable(GL_BLEND);
+	const SdfFont& font = Text2DSdfFont;
+	if (!Text2DSdfTexture.get() || size <= 0.0f) return;
+	size_t glyphs = 0;
+	for (const char* c = text; *c; ++c) {
+		const SdfGlyph* g = font.glyph((unsigned char)*c);
+		if (g && g->atlasWidth) ++glyphs;
+	}
+	TextVertex* v = glyphs ? allocateGlyphs(glyphs) : nullptr;
+	if (!v) return;
+	++Text2DCounters.strings;
+	Text2DCounters.glyphs += glyphs;
+
+	TextVertex base;
+	memset(&base, 0, sizeof(base));
+	base.sdf = 1;
+	unpackColor(color, base.color);
+	// outline width in pixels -> field units: one atlas texel is 1 / (2 spread) of the
+	// range, one pixel is emPixels / size texels
+	float outline = outlineWidth * font.emPixels / (2.0f * font.spread * size);
+	base.outlineWidth = (uint8_t)std::min(255.0f, std::max(0.0f, outline * 510.0f + 0.5f));
+	unpackColor(base.outlineWidth ? outlineColor : color, base.outlineColor);
+
+	float penX = x, penY = y;
+	uint32_t previous = 0;
+	for (const char* c = text; *c; ++c) {
+		uint32_t codepoint = (unsigned char)*c;
+		if (codepoint == '\n') {
+			penX = x;
+			penY -= (font.ascender - font.descender + font.lineGap) * size;
+			previous = 0;
+			continue;
+		}
+		const SdfGlyph* g = font.glyph(codepoint);
+		if (!g) { previous = 0; continue; }
+		if (previous) penX += font.kern(previous, codepoint) * size;
+		if (g->atlasWidth) {
+			v = emitQuad(v, base,
+			             toPosition(penX + g->planeLeft * size), toPosition(penY + g->planeBottom * size),
+			             toPosition(penX + g->planeRight * size), toPosition(penY + g->planeTop * size),
+			             toAtlas(g->atlasX, font.atlasWidth), toAtlas(g->atlasY, font.atlasHeight),
+			             toAtlas((float)(g->atlasX + g->atlasWidth), font.atlasWidth),
+			             toAtlas((float)(g->atlasY + g->atlasHeight), font.atlasHeight));
+		}
+		penX += g->advance * size;
+		previous = codepoint;
+	}
+}
 
-	glDisableVertexAttribArray(0);
-	glDisableVertexAttribArray(1);
+void flushText2D(int screenWidth, int screenHeight){
+
+	if (!Text2DFrameOpen) return;
+	Text2DRing.flush();
+	++Text2DCounters.flushes;
+
+	if (Text2DVertexCount) {
+		// Bind shader
+		GLuint prog = Text2DShader.get();
+		glUseProgram(prog);
+		glUniform2f(Text2DScreenSizeID, (float)screenWidth, (float)screenHeight);
+
+		// Bind textures: the grid font on unit 0, the distance-field font on unit 1
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, Text2DTextureID);
+		glUniform1i(Text2DUniformID, 0);
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, Text2DSdfTexture.get());
+		glUniform1i(Text2DSdfUniformID, 1);
+		glActiveTexture(GL_TEXTURE0);
+
+		glBindVertexArray(Text2DVAO.get());
+		if (Text2DRingBufferID != Text2DRing.buffer()) {
+			Text2DRingBufferID = Text2DRing.buffer();
+			glBindBuffer(GL_ARRAY_BUFFER, Text2DRingBufferID);
+			const GLsizei stride = sizeof(TextVertex);
+			glVertexAttribPointer(0, 2, GL_SHORT, GL_FALSE, stride, (void*)offsetof(TextVertex, x));
+			glVertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(TextVertex, u));
+			glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(TextVertex, color));
+			glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(TextVertex, outlineColor));
+			glVertexAttribPointer(4, 2, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(TextVertex, outlineWidth));
+			for (GLuint a = 0; a < 5; ++a) glEnableVertexAttribArray(a);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+		}
+
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+		// One draw call for the whole frame's text, both fonts
+		glDrawArrays(GL_TRIANGLES, (GLint)Text2DFirstVertex, (GLsizei)Text2DVertexCount);
+		++Text2DCounters.draws;
+
+		glDisable(GL_BLEND);
+		glBindVertexArray(0);
+	}
 
+	Text2DRing.endFrame();
+	Text2DFrameOpen = false;
+	// grow between frames, never while a section is mapped; the new buffer may reuse the
+	// old name, so the VAO is re-pointed whatever its id
+	size_t sectionBefore = Text2DRing.sectionSize();
+	Text2DRing.ensureCapacity(Text2DBytesWanted);
+	if (Text2DRing.sectionSize() != sectionBefore) Text2DRingBufferID = 0;
+	Text2DBytesWanted = 0;
 }
 
 void cleanupText2D(){
 
+	if (Text2DFrameOpen) {
+		Text2DRing.endFrame();
+		Text2DFrameOpen = false;
+	}
 	// Delete buffers
-	glDeleteBuffers(1, &Text2DVertexBufferID);
-	glDeleteBuffers(1, &Text2DUVBufferID);
+	Text2DRing.destroy();
+	Text2DVAO.reset();
+	Text2DRingBufferID = 0;
 
-	// Delete texture
-	glDeleteTextures(1, &Text2DTextureID);
+	// Delete textures (the grid font only if we loaded it)
+	Text2DOwnedTexture.reset();
+	Text2DTextureID = 0;
+	Text2DBitmapCell = 0;
+	Text2DSdfTexture.reset();
+	Text2DSdfFont = SdfFont();
 
 	// Delete shader
-	glDeleteProgram(Text2DShaderID);
+	Text2DShader.reset();
 }
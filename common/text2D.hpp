@@ -1,8 +1,49 @@
 #ifndef TEXT2D_HPP
 #define TEXT2D_HPP
 
+#include <cstdint>
+
+// Screen-space text from a 16x16 glyph font texture (ASCII order) and/or a
+// signed-distance-field font (sdffont.hpp), batched: the print calls only append
+// the string's quads to a ring-buffered vertex stream (persistently mapped where
+// the driver allows it), and flushText2D draws every string queued since the last
+// flush, from both fonts, with one draw call. Call flushText2D once per frame,
+// after the scene and before swapping.
+
+// Font from a .DDS file (texture.hpp's loadDDS); the texture is owned by text2D.
 void initText2D(const char * texturePath);
+// Font already loaded by the caller; not deleted by cleanupText2D.
+void initText2D(unsigned int fontTexture);
+// Font from a glyph-strip bitmap in the AntTweakBar layout (.pgm, greyscale coverage:
+// rows of glyphs for codes 32 up, each row ended by a line whose 0 pixels mark the glyph
+// boundaries), repacked into the 16x16 grid. external/AntTweakBar-1.16/src/res/
+// FontFixed1.pgm is fixed-width and ships with the repo, so text needs no extra asset.
+bool initText2DBitmapFont(const char * pgmPath);
+// Pixels per cell of that font (draw at this size for crisp glyphs), 0 if none.
+int text2DBitmapFontCell();
+// Distance-field font from a .sdff file (`make sdf-font`); may be combined with
+// either of the above. False (and printText2DSdf draws nothing) if it can't load.
+bool initText2DSdf(const char * fontPath);
+
+// Queues `text` with its bottom-left corner at (x, y), `size` pixels per glyph.
 void printText2D(const char * text, int x, int y, int size);
+// Queues `text` in the distance-field font, pen starting on the baseline at (x, y),
+// `size` pixels per em, with the font's kerning; '\n' starts a new line. Colours are
+// 0xRRGGBBAA; an outline `outlineWidth` pixels wide is drawn around the glyphs (up to
+// the font's spread, so wide outlines want large text or a larger spread).
+void printText2DSdf(const char * text, float x, float y, float size, uint32_t color = 0xFFFFFFFFu,
+                    float outlineWidth = 0.0f, uint32_t outlineColor = 0x000000FFu);
+// Draws the queued text. Coordinates map to a screenWidth x screenHeight screen
+// (the defaults match the original 800x600 tutorial window).
+void flushText2D(int screenWidth = 800, int screenHeight = 600);
+
+// Totals since startup: flushes with text queued, draw calls they issued, strings and
+// glyphs queued. A frame's text should cost exactly one draw.
+struct Text2DStats {
+	unsigned long long flushes = 0, draws = 0, strings = 0, glyphs = 0;
+};
+Text2DStats text2DStats();
+
 void cleanupText2D();
 
-#endif
\ No newline at end of file
+#endif
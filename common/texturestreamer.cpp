@@ -0,0 +1,290 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include <glad/glad.h>
+
+#include "stb_image.h"
+#include "texturestreamer.hpp"
+
+namespace {
+
+enum EntryState { DECODING = 0, DECODED, FAILED, STREAMING, RESIDENT };
+
+double msSince(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// 2x2 box filter; odd edges clamp
+void downsample(const std::vector<unsigned char>& src, int w, int h, std::vector<unsigned char>& dst, int dw, int dh) {
+    dst.resize((size_t)dw * dh * 4);
+    for (int y = 0; y < dh; ++y) {
+        int y0 = std::min(2 * y, h - 1), y1 = std::min(2 * y + 1, h - 1);
+        for (int x = 0; x < dw; ++x) {
+            int x0 = std::min(2 * x, w - 1), x1 = std::min(2 * x + 1, w - 1);
+            for (int c = 0; c < 4; ++c) {
+                int sum = src[((size_t)y0 * w + x0) * 4 + c] + src[((size_t)y0 * w + x1) * 4 + c] +
+                          src[((size_t)y1 * w + x0) * 4 + c] + src[((size_t)y1 * w + x1) * 4 + c];
+                dst[((size_t)y * dw + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+int levelSize(int size, int level) { return std::max(1, size >> level); }
+
+} // namespace
+
+void TextureStreamer::init(const TextureStreamerConfig& config) {
+    destroy();
+    cfg = config;
+    // the loader thread decodes for GL's bottom-up row order, as loadTexture did
+    stbi_set_flip_vertically_on_load(true);
+    staging.init(GL_PIXEL_UNPACK_BUFFER, std::max<size_t>(cfg.bytesPerFrame, 64 * 1024), 3, "ring/texture upload");
+    startTime = std::chrono::steady_clock::now();
+    firstDisplayMs = residentMs = -1.0;
+    uploadedBytes = 0;
+    budgetLimitedFrames = 0;
+    quit = false;
+    loader = std::thread(&TextureStreamer::loaderLoop, this);
+    started = true;
+}
+
+void TextureStreamer::destroy() {
+    if (started) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+            decodeQueue.clear();
+        }
+        work.notify_all();
+        loader.join();
+        started = false;
+    }
+    entries.clear(); // GpuTexture handles delete the textures
+    byPath.clear();
+    byId.clear();
+    staging.destroy();
+}
+
+unsigned int TextureStreamer::request(const std::string& path) {
+    std::map<std::string, size_t>::iterator it = byPath.find(path);
+    if (it != byPath.end()) return entries[it->second]->texture.get();
+
+    FILE* probe = std::fopen(path.c_str(), "rb");
+    if (!probe) {
+        std::cerr << "Texture failed to load at path: " << path << std::endl;
+        return 0;
+    }
+    std::fclose(probe);
+
+    std::unique_ptr<Entry> e(new Entry());
+    e->path = path;
+    e->texture.create("texture/" + path);
+    glBindTexture(GL_TEXTURE_2D, e->texture.get());
+    const unsigned char grey[4] = {128, 128, 128, 255};
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+    gpuResources().setSize(GPU_TEXTURE, e->texture.get(), 4, "RGBA8 1x1 placeholder");
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    unsigned int id = e->texture.get();
+    Entry* raw = e.get();
+    byPath[path] = entries.size();
+    byId[id] = entries.size();
+    entries.push_back(std::move(e));
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        decodeQueue.push_back(raw);
+    }
+    work.notify_one();
+    return id;
+}
+
+void TextureStreamer::setScreenCoverage(unsigned int texture, float pixels) {
+    std::map<unsigned int, size_t>::iterator it = byId.find(texture);
+    if (it == byId.end()) return;
+    Entry& e = *entries[it->second];
+    e.coverage = std::max(e.coverage, pixels);
+}
+
+void TextureStreamer::loaderLoop() {
+    for (;;) {
+        Entry* e = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            work.wait(lock, [this] { return quit || !decodeQueue.empty(); });
+            if (quit) return;
+            e = decodeQueue.front();
+            decodeQueue.pop_front();
+        }
+        decode(*e);
+    }
+}
+
+void TextureStreamer::decode(Entry& e) {
+    int w = 0, h = 0, n = 0;
+    unsigned char* data = stbi_load(e.path.c_str(), &w, &h, &n, 4);
+    if (!data) {
+        e.state.store(FAILED, std::memory_order_release);
+        return;
+    }
+    int levels = 1;
+    while ((w >> levels) > 0 || (h >> levels) > 0) ++levels;
+    e.mips.resize((size_t)levels);
+    e.mips[0].assign(data, data + (size_t)w * h * 4);
+    stbi_image_free(data);
+    for (int l = 1; l < levels; ++l) {
+        downsample(e.mips[l - 1], levelSize(w, l - 1), levelSize(h, l - 1),
+                   e.mips[l], levelSize(w, l), levelSize(h, l));
+    }
+    e.width = w;
+    e.height = h;
+    e.levels = levels;
+    e.state.store(DECODED, std::memory_order_release);
+}
+
+void TextureStreamer::allocate(Entry& e) {
+    glBindTexture(GL_TEXTURE_2D, e.texture.get());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    e.resident = e.levels;
+    size_t bytes = 0;
+    for (int l = 0; l < e.levels; ++l) {
+        int lw = levelSize(e.width, l), lh = levelSize(e.height, l);
+        bool immediate = lw <= cfg.immediateMaxSize && lh <= cfg.immediateMaxSize;
+        // storage for every level now, texels for the small tail right away
+        glTexImage2D(GL_TEXTURE_2D, l, GL_RGBA8, lw, lh, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                     immediate ? e.mips[(size_t)l].data() : nullptr);
+        bytes += gpuImageBytes(GL_RGBA8, lw, lh);
+        if (immediate) {
+            e.resident = std::min(e.resident, l);
+            uploadedBytes += e.mips[(size_t)l].size();
+        }
+    }
+    gpuResources().setSize(GPU_TEXTURE, e.texture.get(), bytes,
+                           "RGBA8 " + std::to_string(e.width) + "x" + std::to_string(e.height) + " +mips");
+    for (int l = e.resident; l < e.levels; ++l) std::vector<unsigned char>().swap(e.mips[(size_t)l]);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, e.resident);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, e.levels - 1);
+    e.rowsDone = 0;
+    e.state.store(e.resident == 0 ? RESIDENT : STREAMING, std::memory_order_relaxed);
+}
+
+void TextureStreamer::update() {
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+    std::vector<Entry*> streaming;
+    bool anyLoading = false, allDone = true;
+    for (auto& ep : entries) {
+        Entry& e = *ep;
+        int state = e.state.load(std::memory_order_acquire);
+        if (state == DECODED) {
+            allocate(e);
+            state = e.state.load(std::memory_order_relaxed);
+        } else if (state == FAILED) {
+            std::cerr << "Texture failed to load at path: " << e.path << std::endl;
+            e.state.store(RESIDENT, std::memory_order_relaxed); // keeps the placeholder
+            state = RESIDENT;
+        }
+        if (state == DECODING) anyLoading = true;
+        if (state != RESIDENT) allDone = false;
+        if (state == STREAMING) streaming.push_back(&e);
+    }
+    if (!entries.empty() && !anyLoading && firstDisplayMs < 0.0) firstDisplayMs = msSince(startTime);
+    if (!entries.empty() && allDone && residentMs < 0.0) residentMs = msSince(startTime);
+    if (streaming.empty()) return;
+
+    // biggest on screen first; among equals, the blurriest
+    std::sort(streaming.begin(), streaming.end(), [](const Entry* a, const Entry* b) {
+        if (a->coverage != b->coverage) return a->coverage > b->coverage;
+        return a->resident > b->resident;
+    });
+    for (Entry* e : streaming) e->coverage = 0.0f;
+
+    struct Upload { Entry* e; int level, y0, rows; size_t offset; bool completes; };
+    std::vector<Upload> uploads;
+    size_t budgetLeft = cfg.bytesPerFrame;
+    bool limited = false;
+
+    // Pass 1: copy row bands into the staging ring (the ring may need unmapping before use)
+    staging.beginFrame();
+    for (Entry* e : streaming) {
+        while (e->resident > 0) {
+            int level = e->resident - 1;
+            int lw = levelSize(e->width, level), lh = levelSize(e->height, level);
+            size_t rowBytes = (size_t)lw * 4;
+            int rows = std::min(lh - e->rowsDone, (int)(budgetLeft / rowBytes));
+            // the frame's first band always goes, at least one row: a row wider than the
+            // budget (or a slow frame) must still make progress or finish() never returns
+            bool first = uploads.empty();
+            if (first) rows = std::max(rows, 1);
+            if (rows <= 0 || (!first && msSince(t0) > cfg.msPerFrame)) { limited = true; break; }
+            size_t offset = 0;
+            void* dst = staging.allocate((size_t)rows * rowBytes, 4, offset);
+            if (!dst) { limited = true; break; }
+            std::memcpy(dst, &e->mips[(size_t)level][(size_t)e->rowsDone * rowBytes], (size_t)rows * rowBytes);
+
+            Upload u;
+            u.e = e; u.level = level; u.y0 = e->rowsDone; u.rows = rows; u.offset = offset;
+            e->rowsDone += rows;
+            u.completes = (e->rowsDone == lh);
+            uploads.push_back(u);
+            budgetLeft -= std::min(budgetLeft, (size_t)rows * rowBytes);
+            uploadedBytes += (size_t)rows * rowBytes;
+            if (u.completes) {
+                std::vector<unsigned char>().swap(e->mips[(size_t)level]); // copied, CPU copy no longer needed
+                e->resident = level;
+                e->rowsDone = 0;
+            }
+        }
+        if (limited) break;
+    }
+    staging.flush();
+
+    // Pass 2: PBO -> texture, then widen the sampled range once a level is complete
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.buffer());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    for (const Upload& u : uploads) {
+        glBindTexture(GL_TEXTURE_2D, u.e->texture.get());
+        glTexSubImage2D(GL_TEXTURE_2D, u.level, 0, u.y0, levelSize(u.e->width, u.level), u.rows,
+                        GL_RGBA, GL_UNSIGNED_BYTE, (void*)u.offset);
+        if (u.completes) {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, u.level);
+            if (u.level == 0) {
+                u.e->mips.clear();
+                u.e->state.store(RESIDENT, std::memory_order_relaxed);
+            }
+        }
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    staging.endFrame();
+    if (limited) ++budgetLimitedFrames;
+}
+
+void TextureStreamer::finish() {
+    while (!allResident()) {
+        update();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+bool TextureStreamer::allResident() const {
+    for (auto& e : entries) {
+        if (e->state.load(std::memory_order_acquire) != RESIDENT) return false;
+    }
+    return true;
+}
+
+void TextureStreamer::report(std::ostream& os) const {
+    os << "  texture stream : " << entries.size() << " textures, " << uploadedBytes / 1024 << " KiB uploaded, ";
+    if (firstDisplayMs >= 0.0) os << "all visible (coarse mips) after " << firstDisplayMs << " ms, ";
+    if (residentMs >= 0.0) os << "fully resident after " << residentMs << " ms";
+    else os << "not fully resident at exit";
+    os << " (budget " << cfg.bytesPerFrame / 1024 << " KiB / " << cfg.msPerFrame << " ms per frame, "
+       << budgetLimitedFrames << " frames at the limit)\n";
+}
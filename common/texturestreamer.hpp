@@ -0,0 +1,92 @@
+#ifndef TEXTURESTREAMER_HPP
+#define TEXTURESTREAMER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gpuresources.hpp"
+#include "ringbuffer.hpp"
+
+struct TextureStreamerConfig {
+    size_t bytesPerFrame = 4 * 1024 * 1024;   // texel upload budget per frame
+    double msPerFrame = 2.0;                  // CPU time budget per frame (copies + GL calls)
+    int immediateMaxSize = 64;                // mips this small are uploaded as soon as decoded
+};
+
+// Streams textures in coarse-to-fine.
+//
+// request() returns a texture name at once (a 1x1 grey placeholder). A loader thread
+// decodes the image and builds its mip chain on the CPU; the GL thread then uploads
+// the small tail mips immediately and the larger levels a band of rows at a time
+// through a fenced PBO ring, within a per-frame byte and time budget. Sampling is
+// clamped to the resident levels with GL_TEXTURE_BASE_LEVEL, so a texture sharpens as
+// its levels arrive. Textures covering more of the screen (setScreenCoverage) go first.
+class TextureStreamer {
+public:
+    TextureStreamer() {}
+    ~TextureStreamer() { destroy(); }
+
+    void init(const TextureStreamerConfig& config);
+    void destroy();   // deletes every texture it created
+
+    // Same path -> same texture. Returns 0 if the file can't be opened.
+    unsigned int request(const std::string& path);
+    // Largest on-screen area (pixels) the texture covered this frame; decays each update().
+    void setScreenCoverage(unsigned int texture, float pixels);
+    // GL thread, once per frame.
+    void update();
+
+    // Blocks until every requested texture is fully resident (reproducible captures).
+    void finish();
+    bool allResident() const;
+    void report(std::ostream& os) const;
+
+private:
+    TextureStreamer(const TextureStreamer&);
+    TextureStreamer& operator=(const TextureStreamer&);
+
+    struct Entry {
+        GpuTexture texture;
+        std::string path;
+        std::atomic<int> state;        // DECODING / DECODED / FAILED / STREAMING / RESIDENT
+        int width = 0, height = 0, levels = 0;
+        std::vector<std::vector<unsigned char>> mips;  // RGBA8, [0] = full size
+        int resident = 0;              // finest fully uploaded level (== levels: none yet)
+        int rowsDone = 0;              // rows of level resident-1 already uploaded
+        float coverage = 0.0f;
+        Entry() : state(0) {}
+    };
+
+    void loaderLoop();
+    void decode(Entry& e);
+    void allocate(Entry& e);
+
+    TextureStreamerConfig cfg;
+    std::vector<std::unique_ptr<Entry>> entries;
+    std::map<std::string, size_t> byPath;
+    std::map<unsigned int, size_t> byId;
+    RingBuffer staging;
+
+    std::thread loader;
+    std::mutex mutex;
+    std::condition_variable work;
+    std::deque<Entry*> decodeQueue;
+    bool quit = false;
+    bool started = false;
+
+    std::chrono::steady_clock::time_point startTime;
+    double firstDisplayMs = -1.0, residentMs = -1.0;
+    unsigned long long uploadedBytes = 0;
+    unsigned long long budgetLimitedFrames = 0;
+};
+
+#endif
@@ -7,6 +7,35 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <map>
+#include <thread>
+#include <chrono>
+
+#include "common/framepacer.hpp"
+#include "common/jobsystem.hpp"
+#include "common/framepacket.hpp"
+#include "common/ringbuffer.hpp"
+#include "common/scenestore.hpp"
+#include "common/lightculling.hpp"
+#include "common/flythrough.hpp"
+#include "common/framecapture.hpp"
+#include "common/goldenimage.hpp"
+#include "common/framerecorder.hpp"
+#include "common/texturestreamer.hpp"
+#include "common/gpuresources.hpp"
+#include "common/gldispatch.hpp"
+#include "common/campus.hpp"
+#include "common/bvh.hpp"
+#include "common/cameracollision.hpp"
+#include "common/lightmap.hpp"
+#include "common/probegrid.hpp"
+#include "common/gputimer.hpp"
+#include "common/dynamicresolution.hpp"
+#include "common/antialiasing.hpp"
+#include "common/shadermanager.hpp"
+#include "common/text2D.hpp"
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include "tiny_obj_loader.h"
@@ -30,90 +59,296 @@ float lastY = SCR_HEIGHT / 2.0f;
 bool firstMouse = true;
 float fov = 45.0f;
 
+// Fixed simulation step (set from the frame pacer); the camera is rendered
+// between the previous and current tick positions.
 float deltaTime = 0.0f;
-float lastFrame = 0.0f;
+glm::vec3 prevCameraPos = cameraPos;
+// Camera driven by a recording/spline path: mouse, scroll and movement keys are ignored.
+bool cameraScripted = false;
+
+// All textures; mips stream in under a per-frame upload budget
+TextureStreamer textureStreamer;
+
+// Command line options (see README, "Runtime options")
+struct AppOptions {
+    FramePacerConfig pacing;
+    unsigned long long maxFrames = 0; // 0 = run until the window is closed
+    bool renderOnDemand = false;      // only redraw when something visible changed
+    int jobThreads = -1;              // draw-list workers, -1 = one per spare core
+    bool pipelineDrawList = true;     // build frame N+1's draw list while frame N is submitted
+    float lightThreshold = 0.05f;     // luminance below which a light is culled from a draw
+    std::string recordPath;           // write the camera of every frame to a .fly file
+    std::string replayPath;           // drive the camera from a .fly recording...
+    std::string splinePath;           // ...or from an authored spline path
+    double replayFps = 60.0;          // replay time advances 1/replayFps per frame
+    bool headless = false;            // hidden window, render into an offscreen framebuffer
+    std::vector<unsigned long long> captureFrames; // frames checked against golden images
+    GoldenImageSet golden;
+    FrameRecorderConfig recording;    // continuous capture when output is set
+    TextureStreamerConfig streaming;
+    bool glCounters = false;          // count GL calls/binds/bytes per frame
+    bool nullGL = false;              // no window, no driver: GL calls go to stubs
+    GlCallLimits glLimits;            // per-frame ceilings checked at exit (CI)
+    CampusConfig campus;              // rooms/benches/bulbs of the generated scene
+    size_t rayBench = 0;              // rays traced by the startup ray-query benchmark
+    bool cameraCollision = true;      // the free camera collides with walls and furniture
+    std::string lightmapPath;         // bake (or reuse) baked lighting for shading mode 3
+    LightmapConfig lightmap;
+    std::string probesPath;           // bake (or reuse) irradiance probes for shading mode 3
+    ProbeGridConfig probes;
+    bool depthPrepass = false;        // depth-only pass first, then shade with GL_EQUAL
+    DrawOrder drawOrder = DRAW_ORDER_STATE;
+    bool dynamicResolution = false;   // scene rendered at a scale that tracks its GPU time
+    DynamicResolutionConfig dynamicRes;
+    AntiAliasingMode antiAliasing = AA_OFF; // starting mode, F cycles through them
+    bool syncShaders = false;         // compile every program before the first frame
+    std::string shaderDir = "shaders"; // <name>.vert/.frag and their #includes
+    bool hotReload = true;            // recompile a program when one of its files is saved
+    bool overlay = false;             // frame stats drawn over the image (text2D, one draw)
+    std::string overlayFont = "external/AntTweakBar-1.16/src/res/FontFixed1.pgm"; // .pgm, .dds or .sdff
+};
+
+// Render-on-demand: everything that can change the image is either compared against
+// the last drawn snapshot (camera, shading mode, published scene) or flags sceneDirty
+// (window size, expose events).
+bool sceneDirty = true;
+void markSceneDirty() { sceneDirty = true; }
+
+// With --null-gl there is no window; these stand in for glfw{Set,}WindowShouldClose.
+bool closeRequested = false;
+void requestClose() {
+    if (window) glfwSetWindowShouldClose(window, true);
+    closeRequested = true;
+}
+bool shouldClose() { return window ? glfwWindowShouldClose(window) != 0 : closeRequested; }
 
+// Left click: pick whatever is at the centre of the view (the cursor is captured).
+bool pickRequested = false;
 
+// CPU copy of a mesh's vertices and triangles, kept for ray queries (SceneBVH) and the
+// lightmap baker.
+struct MeshGeometry {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<uint32_t> indices;
+};
+
+
+// Owns its GL objects, so meshes are moved (never copied) into sceneMeshes.
 struct Mesh {
-    unsigned int VAO = 0, VBO = 0, EBO = 0;
+    GpuVertexArray VAO;
+    GpuBuffer VBO, EBO;
     size_t indexCount = 0;
     glm::vec3 position = glm::vec3(0.0f);
     glm::vec3 color = glm::vec3(1.0f);
     bool hasTexture = false;
     unsigned int textureID = 0;
+    glm::vec3 boundsMin = glm::vec3(0.0f), boundsMax = glm::vec3(0.0f); // local AABB
+    MeshGeometry geometry;
     std::string logicalName; // "bench", "podium", "greenboard", etc
     std::string shapeName;   // shape name inside OBJ
 };
 
 std::vector<Mesh> sceneMeshes;
-unsigned int roomVAO = 0, roomVBO = 0, roomEBO = 0;
-unsigned int projectorVAO = 0, projectorVBO = 0, projectorEBO = 0;
-unsigned int lightBoxVAO = 0, lightBoxVBO = 0, lightBoxEBO = 0;
-
-// Old-style single light used by old shader
-glm::vec3 lightPos(0.0f, 2.5f, 0.0f);
-
-const int NUM_BULBS = 6;
-std::vector<glm::vec3> bulbPositions; // will hold the 6 ceiling bulb world positions
-std::vector<glm::vec3> bulbColors;    // optional per-bulb color
+GpuVertexArray roomVAO, projectorVAO, lightBoxVAO;
+GpuBuffer roomVBO, roomEBO, projectorVBO, projectorEBO, lightBoxVBO, lightBoxEBO;
+MeshGeometry roomGeometry, projectorGeometry, lightBoxGeometry;
 
 
 // prototypes
+bool parseOptions(int argc, char** argv, AppOptions& opts);
 void framebuffer_size_callback(GLFWwindow*, int width, int height);
 void mouse_callback(GLFWwindow*, double xpos, double ypos);
+void mouse_button_callback(GLFWwindow*, int button, int action, int mods);
 void scroll_callback(GLFWwindow*, double, double yoffset);
+void window_refresh_callback(GLFWwindow*);
+bool needsRedraw(const SceneSnapshot& current, const SceneSnapshot& lastDrawn, bool shadersPending);
+void waitForEvents(double timeoutSeconds, bool mustReturn);
+void noteTextureCoverage(const FramePacket& packet);
+void reportPick(const SceneBVH& rays, const SceneStore& scene, const Ray& ray);
 void processInput(GLFWwindow *window);
 unsigned int createShaderProgram();
 void setupGeometry();
-void drawScene(unsigned int shaderProgram, unsigned int ceilingTexture, unsigned int floorTexture);
+void buildScene(SceneStore& scene, std::vector<MeshGeometry>& meshGeometry, unsigned int ceilingTexture,
+                unsigned int floorTexture, float lightThreshold, const CampusConfig& campus);
 std::vector<Mesh> loadOBJModels(const std::string& path, const std::string& logicalName, const std::string& texPath = "");
 Mesh loadOBJShape(const tinyobj::attrib_t& attrib, const tinyobj::shape_t& shape,
                   const std::string& logicalName, const std::string& texPath = "");
 unsigned int loadTexture(const char* path);
+MeshGeometry keepGeometry(const float* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount);
 // add these prototypes near the top alongside your other prototypes
-unsigned int createPhongProgram();
-unsigned int createGouraudProgram();
-
+unsigned int createFallbackProgram();
+void uploadLightmap(const SceneStore& scene, const Lightmap& lightmap, GpuTexture& texture,
+                    std::vector<GpuBuffer>& uvBuffers);
+void uploadProbeGrid(const ProbeGrid& probes, GpuTexture textures[3]);
+void uploadDepthStreams(SceneStore& scene, const std::vector<MeshGeometry>& meshGeometry,
+                        std::vector<GpuVertexArray>& vaos, std::vector<GpuBuffer>& buffers);
+
+
+int main(int argc, char** argv) {
+    AppOptions opts;
+    if (!parseOptions(argc, argv, opts)) return -1;
+
+    if (opts.headless) opts.pacing.vsync = VSYNC_OFF;
+    if (opts.nullGL) {
+        // no GLFW, no context: every GL entry point the renderer uses is a counted stub
+        glDispatchInstall(GL_BACKEND_NULL);
+    } else {
+        if (!glfwInit()) {
+            std::cerr << "Failed to init GLFW\n";
+            return -1;
+        }
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        // headless: nothing is presented; a hidden window still gives us a context (Xvfb + llvmpipe in CI)
+        if (opts.headless) glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+
+        window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Room Combined", NULL, NULL);
+        if (!window) {
+            std::cerr << "Failed to create GLFW window\n";
+            glfwTerminate();
+            return -1;
+        }
+        glfwMakeContextCurrent(window);
 
-int main() {
-    if (!glfwInit()) {
-        std::cerr << "Failed to init GLFW\n";
-        return -1;
-    }
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Room Combined", NULL, NULL);
-    if (!window) {
-        std::cerr << "Failed to create GLFW window\n";
-        glfwTerminate();
-        return -1;
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+            std::cerr << "Failed to init GLAD\n";
+            return -1;
+        }
+        if (opts.glCounters) glDispatchInstall(GL_BACKEND_DRIVER);
+
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+        glfwSetCursorPosCallback(window, mouse_callback);
+        glfwSetMouseButtonCallback(window, mouse_button_callback);
+        glfwSetScrollCallback(window, scroll_callback);
+        glfwSetWindowRefreshCallback(window, window_refresh_callback);
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
     }
-    glfwMakeContextCurrent(window);
 
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cerr << "Failed to init GLAD\n";
-        return -1;
+    FramePacer pacer;
+    pacer.init(opts.pacing);
+    if (window) {
+        const GLFWvidmode* vidmode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+        pacer.applyVsync(vidmode ? (double)vidmode->refreshRate : 0.0);
     }
 
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    glfwSetCursorPosCallback(window, mouse_callback);
-    glfwSetScrollCallback(window, scroll_callback);
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-
     glEnable(GL_DEPTH_TEST);
 
-    // Create both shader programs (Phong = per-fragment, Gouraud = per-vertex)
-    unsigned int phongProgram = createPhongProgram();
-    unsigned int gouraudProgram = createGouraudProgram();
+    // Headless: a hidden window's default framebuffer has no pixel ownership guarantees,
+    // so draw into our own and read captures back from it.
+    GpuFramebuffer headlessFBO;
+    GpuRenderbuffer headlessColor, headlessDepth;
+    if (opts.headless) {
+        headlessFBO.create("framebuffer/headless");
+        headlessColor.create("framebuffer/headless color");
+        headlessDepth.create("framebuffer/headless depth");
+        glBindRenderbuffer(GL_RENDERBUFFER, headlessColor.get());
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, SCR_WIDTH, SCR_HEIGHT);
+        gpuResources().setSize(GPU_RENDERBUFFER, headlessColor.get(),
+                               gpuImageBytes(GL_RGBA8, SCR_WIDTH, SCR_HEIGHT), "RGBA8");
+        glBindRenderbuffer(GL_RENDERBUFFER, headlessDepth.get());
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, SCR_WIDTH, SCR_HEIGHT);
+        gpuResources().setSize(GPU_RENDERBUFFER, headlessDepth.get(),
+                               gpuImageBytes(GL_DEPTH24_STENCIL8, SCR_WIDTH, SCR_HEIGHT), "DEPTH24_STENCIL8");
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, headlessFBO.get());
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, headlessColor.get());
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, headlessDepth.get());
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "Headless framebuffer incomplete\n";
+            return -1;
+        }
+        glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+    }
+
+    // Dynamic resolution: the scene goes to its own target, stretched over the output
+    DynamicResolution dynamicRes;
+    if (opts.dynamicResolution) {
+        int fbw = SCR_WIDTH, fbh = SCR_HEIGHT;
+        if (!opts.headless && window) glfwGetFramebufferSize(window, &fbw, &fbh);
+        if (!dynamicRes.init(opts.dynamicRes, fbw, fbh, pacer.deadlineMs())) {
+            std::cerr << "Warning: scene target incomplete, dynamic resolution off\n";
+        }
+    }
+    unsigned long long timedScenePasses = 0;
+    // Anti-aliasing target, (re)created when the mode changes
+    AntiAliasing antiAliasing;
+    AntiAliasingMode aaMode = opts.antiAliasing;
+    bool aaKeyDown = false;
+
+    // Golden-image captures: read back asynchronously, compared a few frames later
+    FrameCapture frameCapture;
+    if (!opts.captureFrames.empty()) frameCapture.init(3);
+
+    // Shader programs (Phong = per-fragment, Gouraud = per-vertex, baked = lightmap) are
+    // read from opts.shaderDir and compile in the background; until one is ready its
+    // draws use the tiny fallback program, the depth pre-pass is skipped and the bulbs
+    // are drawn by the lit pass.
+    GpuProgram fallbackShader;
+    fallbackShader.adopt(createFallbackProgram(), "shader/fallback");
+    const unsigned int fallbackProgram = fallbackShader.get();
+    ShaderManager shaders;
+    shaders.init(window, !opts.syncShaders);
+    const std::string& shaderDir = opts.shaderDir;
+    const std::vector<ShaderBlockBinding> litBlocks = { { "PerDraw", PER_DRAW_BINDING }, { "Lights", LIGHTS_BINDING } };
+    const ShaderHandle phongProgram =
+        shaders.submitFiles("shader/phong", shaderDir + "/phong.vert", shaderDir + "/phong.frag", litBlocks);
+    const ShaderHandle gouraudProgram =
+        shaders.submitFiles("shader/gouraud", shaderDir + "/gouraud.vert", shaderDir + "/gouraud.frag", litBlocks);
+    const ShaderHandle bakedProgram =
+        shaders.submitFiles("shader/baked", shaderDir + "/baked.vert", shaderDir + "/baked.frag", litBlocks);
+    const ShaderHandle depthProgram = opts.depthPrepass
+        ? shaders.submitFiles("shader/depth", shaderDir + "/depth.vert", shaderDir + "/depth.frag",
+                              { { "PerDraw", PER_DRAW_BINDING } })
+        : SHADER_NONE;
+    const ShaderHandle emissiveProgram = shaders.submitFiles(
+        "shader/emissive", shaderDir + "/emissive.vert", shaderDir + "/emissive.frag", { { "Lights", LIGHTS_BINDING } });
+    // headless runs are captures and benchmarks: their first frame uses the real programs
+    if (opts.headless || opts.syncShaders) shaders.finish();
+    // Saving a shader file recompiles just the programs that include it, in the
+    // background; poll() swaps each in between frames or keeps the last good one.
+    if (opts.hotReload && !opts.headless) shaders.enableHotReload();
+
+    // Stats overlay: every line is queued into text2D's batch and flushed with one draw
+    bool overlaySdf = false;
+    if (opts.overlay) {
+        const std::string& font = opts.overlayFont;
+        std::string ext = font.substr(font.find_last_of('.') + 1);
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        if (ext == "sdff") opts.overlay = overlaySdf = initText2DSdf(font.c_str());
+        else if (ext == "pgm") opts.overlay = initText2DBitmapFont(font.c_str());
+        else initText2D(font.c_str());
+        if (!opts.overlay) std::cerr << "Warning: no overlay font, overlay off\n";
+    }
+    const int overlaySize = text2DBitmapFontCell() ? text2DBitmapFontCell() : 16;
 
     // Start with Phong by default
-    unsigned int activeProgram = gouraudProgram;
-    // unsigned int activeProgram = gouraudProgram;
-    unsigned int lastActiveProgram = activeProgram;
+    ShaderHandle activeProgram = gouraudProgram;
+    // ShaderHandle activeProgram = gouraudProgram;
+    ShaderHandle lastActiveProgram = activeProgram;
+
+    // Flythrough record/replay (shading mode 0 = Phong, 1 = Gouraud, 2 = baked)
+    FlythroughRecorder recorder;
+    FlythroughPlayer player;
+    if (!opts.replayPath.empty() && !player.loadRecording(opts.replayPath)) return -1;
+    if (!opts.splinePath.empty() && !player.loadPath(opts.splinePath)) return -1;
+    cameraScripted = !player.empty();
+    unsigned long long replayFrame = 0;
+
+    // Continuous capture (lecture export): readback + encoding off the render thread
+    FrameRecorder frameRecorder;
+    if (!opts.recording.output.empty()) {
+        if (cameraScripted) opts.recording.fps = opts.replayFps; // one output frame per replay step
+        else if (opts.pacing.fpsCap > 0.0) opts.recording.fps = opts.pacing.fpsCap;
+        int fbw = SCR_WIDTH, fbh = SCR_HEIGHT;
+        if (!opts.headless) glfwGetFramebufferSize(window, &fbw, &fbh);
+        if (!frameRecorder.start(opts.recording, fbw, fbh)) return -1;
+    }
+    double recordStart = glfwGetTime();
 
-    // Load textures
+    // Load textures (returns immediately, detail streams in while rendering)
+    textureStreamer.init(opts.streaming);
     unsigned int ceilingTexture = loadTexture("assets/ceiling_tile.png");
     if (ceilingTexture == 0) std::cerr << "Warning: ceiling texture load failed\n";
     unsigned int floorTexture = loadTexture("assets/floor_tile_updated.png");
@@ -123,49 +358,12 @@ int main() {
 
     setupGeometry();
 
-    // Setup bulbs (same as your previous code)
-    bulbPositions.clear();
-    bulbColors.clear();
-
-    float roomHalfWidth = 10.0f;
-    float roomHalfDepth = 8.0f;
-    float roomHeight = 5.0f;
-    float ceilingInset = 0.15f;
-    float bulbY = roomHeight - ceilingInset;
-
-    const int rows = 2;
-    const int cols = 3;
-    const float insetFromWallX = 2.0f;
-    const float insetFromWallZ = 2.0f;
-
-    float leftX  = -roomHalfWidth + insetFromWallX;
-    float rightX =  roomHalfWidth - insetFromWallX;
-    float frontZ = -roomHalfDepth + insetFromWallZ;
-    float backZ  =  roomHalfDepth - insetFromWallZ;
-
-    float stepX = (cols > 1) ? (rightX - leftX) / float(cols - 1) : 0.0f;
-    float stepZ = (rows > 1) ? (backZ - frontZ) / float(rows - 1) : 0.0f;
-
-    for (int r = 0; r < rows; ++r) {
-        for (int c = 0; c < cols; ++c) {
-            float x = leftX + c * stepX;
-            float z = frontZ + r * stepZ;
-            bulbPositions.push_back(glm::vec3(x, bulbY, z));
-            bulbColors.push_back(glm::vec3(1.0f, 1.0f, 0.95f));
-        }
-    }
-    if ((int)bulbPositions.size() > NUM_BULBS) {
-        bulbPositions.resize(NUM_BULBS);
-        bulbColors.resize(NUM_BULBS);
-    }
-    if (!bulbPositions.empty()) lightPos = bulbPositions[0];
-
     std::cout << "Loading models..." << std::endl;
 
     auto podiums = loadOBJModels("assets/podium_sh.obj", "podium", "");
     for (auto& m : podiums) {
         if (!m.hasTexture) m.color = glm::vec3(0.82f, 0.71f, 0.55f);
-        sceneMeshes.push_back(m);
+        sceneMeshes.push_back(std::move(m));
     }
 
     auto gbs = loadOBJModels("assets/greenboard_new.obj", "greenboard", "");
@@ -173,104 +371,660 @@ int main() {
         std::string low = m.shapeName;
         std::transform(low.begin(), low.end(), low.begin(), ::tolower);
         m.color = (low.find("green") != std::string::npos) ? glm::vec3(0.0f, 0.4f, 0.0f) : glm::vec3(0.78f,0.78f,0.78f);
-        sceneMeshes.push_back(m);
+        sceneMeshes.push_back(std::move(m));
     }
 
     auto benches = loadOBJModels("assets/bench.obj", "bench", "assets/bench.png");
     for (auto& m : benches) {
         if (!m.hasTexture) m.color = glm::vec3(0.48f, 0.50f, 0.53f);
-        sceneMeshes.push_back(m);
+        sceneMeshes.push_back(std::move(m));
     }
 
     std::cout << "Loaded meshes: " << sceneMeshes.size() << std::endl;
 
-    // Main loop
-    while (!glfwWindowShouldClose(window)) {
-        float currentFrame = (float)glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-
-        processInput(window);
+    // The GL thread owns the scene store; workers only ever see published, immutable copies.
+    SceneStore scene;
+    std::vector<MeshGeometry> meshGeometry; // by mesh id, for the CPU-side trees below
+    buildScene(scene, meshGeometry, ceilingTexture, floorTexture, opts.lightThreshold, opts.campus);
+    scene.update();
+    std::shared_ptr<const SceneStore> publishedScene;
+    std::cout << "Scene: " << scene.nodeCount() << " nodes, " << scene.meshes.size() << " meshes, "
+              << scene.lightCount() << " lights" << std::endl;
+
+    // ray queries (picking, line of sight): mesh trees now, the instance tree on demand
+    SceneBVH rays;
+    std::shared_ptr<const SceneStore> raysBuiltFor;
+    for (uint32_t m = 0; m < meshGeometry.size(); ++m) {
+        if (!meshGeometry[m].indices.empty()) rays.setMesh(m, meshGeometry[m].positions, meshGeometry[m].indices);
+    }
+    // the free camera is a capsule in a static collision world (scripted cameras go anywhere)
+    CameraCollider cameraCollider;
+    if (opts.cameraCollision && window && !cameraScripted) {
+        cameraCollider.init(CameraCollisionConfig());
+        for (uint32_t m = 0; m < meshGeometry.size(); ++m) {
+            if (!meshGeometry[m].indices.empty()) cameraCollider.setMesh(m, meshGeometry[m].positions, meshGeometry[m].indices);
+        }
+        cameraCollider.addScene(scene);
+        // the default view starts right against the back wall
+        cameraPos = prevCameraPos = cameraCollider.move(cameraPos, cameraPos);
+    }
+    // baked lighting of the static scene: charts and atlas now, traced once the job system runs
+    LightmapBaker lightmapBaker;
+    Lightmap lightmap;
+    bool haveLightmap = false;
+    if (!opts.lightmapPath.empty()) {
+        for (uint32_t m = 0; m < meshGeometry.size(); ++m) {
+            const MeshGeometry& g = meshGeometry[m];
+            if (!g.indices.empty()) lightmapBaker.setMesh(m, g.positions, g.normals, g.indices);
+        }
+        haveLightmap = lightmapBaker.layout(scene, opts.lightmap, lightmap);
+        if (!haveLightmap) std::cerr << "Warning: nothing fits a lightmap atlas, baked shading unavailable\n";
+    }
+    std::vector<GpuVertexArray> depthVAOs;
+    std::vector<GpuBuffer> depthVBOs;
+    if (opts.depthPrepass) uploadDepthStreams(scene, meshGeometry, depthVAOs, depthVBOs);
+    meshGeometry.clear();
+
+    // Draw lists are built on the job system. Pipelined, the workers cull/sort the next
+    // frame from an immutable snapshot while this thread submits the current one.
+    JobSystem jobs;
+    jobs.start(opts.jobThreads);
+    if (opts.rayBench || haveLightmap || !opts.probesPath.empty()) rays.build(scene);
+    if (opts.rayBench) benchmarkRays(rays, jobs, opts.rayBench, std::cout);
+    GpuTexture lightmapTexture;
+    std::vector<GpuBuffer> lightmapUVBuffers;
+    if (haveLightmap) {
+        if (lightmap.load(opts.lightmapPath)) {
+            std::cout << "Lightmap: " << lightmap.width << "x" << lightmap.height << " read from " << opts.lightmapPath << std::endl;
+        } else {
+            std::cout << "Baking " << lightmap.width << "x" << lightmap.height << " lightmap..." << std::endl;
+            lightmapBaker.bake(scene, rays, jobs, lightmap);
+            if (!lightmap.save(opts.lightmapPath)) std::cerr << "Warning: couldn't write " << opts.lightmapPath << "\n";
+        }
+        scene.lightmapScaleOffset = lightmap.nodeScaleOffset;
+        uploadLightmap(scene, lightmap, lightmapTexture, lightmapUVBuffers);
+        std::vector<glm::vec4>().swap(lightmap.texels);
+    }
+    // irradiance probes for whatever the lightmap doesn't cover (bulbs, moving nodes)
+    ProbeBaker probeBaker;
+    ProbeGrid probes;
+    GpuTexture probeTextures[3];
+    bool haveProbes = !opts.probesPath.empty() && probeBaker.layout(scene, rays, opts.probes, probes);
+    if (haveProbes) {
+        if (probes.load(opts.probesPath)) {
+            std::cout << "Probe grid: " << probes.probeCount() << " probes read from " << opts.probesPath << std::endl;
+        } else {
+            std::cout << "Baking " << probes.probeCount() << " irradiance probes..." << std::endl;
+            probeBaker.bake(scene, rays, jobs, probes);
+            if (!probes.save(opts.probesPath)) std::cerr << "Warning: couldn't write " << opts.probesPath << "\n";
+        }
+        uploadProbeGrid(probes, probeTextures);
+    }
+    const bool haveBaked = haveLightmap || haveProbes;
+    FramePacket packets[2];
+    FramePacket* ready = &packets[0];
+    FramePacket* building = &packets[1];
+    JobHandle buildJob;
+    // per-draw transforms/material constants, streamed into a fenced ring each frame
+    RingBuffer perDrawRing;
+    perDrawRing.init(GL_UNIFORM_BUFFER, 256 * 256, 3, "ring/per-draw");
+    // the lights this frame's draws use; each draw indexes the few that reach it (PerDraw.lightIndex)
+    GpuBuffer lightsUBO;
+    lightsUBO.create("frame data/lights");
+    gpuBufferData(GL_UNIFORM_BUFFER, lightsUBO, sizeof(LightsBlock), NULL, GL_DYNAMIC_DRAW, "uniform");
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, LIGHTS_BINDING, lightsUBO.get());
+    std::shared_ptr<const SceneStore> lightsUploadedFor;
+    std::vector<uint32_t> uploadedFrameLights;
+    unsigned long long drawnFrames = 0, drawnItems = 0, culledItems = 0, drawLights = 0;
+    unsigned long long frameLightSlots = 0, droppedLights = 0, drawnFixtures = 0, fixtureDraws = 0, litFixtures = 0;
+
+    SceneSnapshot lastDrawn;
+    // GPU time of the scene pass (clear, depth pre-pass, lit draws); nothing to time on the null backend
+    GpuTimer scenePassTimer;
+    if (!opts.nullGL) scenePassTimer.init();
+    // golden images must not depend on how far texture streaming got
+    if (!opts.captureFrames.empty()) textureStreamer.finish();
+
+    // loading is done; from here on GL counters are per frame
+    glDispatchEndSetup();
+
+    // Main loop: input/camera advance in fixed ticks, rendering interpolates between them
+    while (!shouldClose()) {
+        int ticks = pacer.beginFrame();
+        const double fenceWaitAtStart = RingBuffer::totalStallMs();
+        if (shaders.poll()) sceneDirty = true; // a program came in: redraw with it
+        deltaTime = (float)pacer.tickDelta();
+        for (int t = 0; t < ticks; ++t) {
+            prevCameraPos = cameraPos;
+            if (window) processInput(window);
+            if (cameraCollider.active() && cameraPos != prevCameraPos) {
+                cameraPos = cameraCollider.move(prevCameraPos, cameraPos);
+            }
+        }
 
-        // shading toggle (1 = Phong, 2 = Gouraud)
-        if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS) activeProgram = phongProgram;
-        if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS) activeProgram = gouraudProgram;
+        if (cameraScripted) {
+            // fixed time step per frame, independent of how long frames take
+            CameraSample cam;
+            if (!player.sample((double)replayFrame / opts.replayFps, cam)) break;
+            ++replayFrame;
+            cameraPos = prevCameraPos = cam.position;
+            yaw = cam.yaw;
+            pitch = cam.pitch;
+            fov = cam.fov;
+            cameraFront = cameraFrontFromYawPitch(yaw, pitch);
+            activeProgram = (cam.shadingMode == 1) ? gouraudProgram
+                          : (cam.shadingMode == 2 && haveBaked) ? bakedProgram : phongProgram;
+        } else if (window) {
+            // shading toggle (1 = Phong, 2 = Gouraud, 3 = baked, with --lightmap/--probes)
+            if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS) activeProgram = phongProgram;
+            if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS) activeProgram = gouraudProgram;
+            if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS && haveBaked) activeProgram = bakedProgram;
+            // F: next anti-aliasing mode (off, FXAA, MSAA 2x, MSAA 4x)
+            bool aaKey = glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS;
+            if (aaKey && !aaKeyDown) {
+                aaMode = (AntiAliasingMode)((aaMode + 1) % (AA_MSAA4 + 1));
+                markSceneDirty();
+            }
+            aaKeyDown = aaKey;
+        }
+        glm::vec3 renderCameraPos = glm::mix(prevCameraPos, cameraPos, pacer.alpha());
 
         // print mode only on change (avoids spamming)
         if (activeProgram != lastActiveProgram) {
             if (activeProgram == phongProgram) std::cout << "Shading mode: Phong (per-fragment)\n";
+            else if (activeProgram == bakedProgram) std::cout << "Shading mode: baked (lightmap + specular)\n";
             else std::cout << "Shading mode: Gouraud (per-vertex)\n";
             lastActiveProgram = activeProgram;
         }
 
+        SceneSnapshot current;
+        current.projection = glm::perspective(glm::radians(fov), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+        current.view = glm::lookAt(renderCameraPos, renderCameraPos + cameraFront, cameraUp);
+        current.cameraPos = renderCameraPos;
+        current.cameraFront = cameraFront;
+        current.fov = fov;
+        current.program = shaders.program(activeProgram, fallbackProgram);
+        current.baked = activeProgram == bakedProgram && shaders.ready(bakedProgram);
+        current.order = opts.drawOrder;
+        current.depthProgram = shaders.program(depthProgram);
+        current.emissiveProgram = shaders.program(emissiveProgram);
+        // propagate dirty transforms; republish only if something actually moved
+        if (scene.update() || !publishedScene) publishedScene = std::make_shared<const SceneStore>(scene);
+        current.scene = publishedScene;
+
+        if (pickRequested) {
+            pickRequested = false;
+            if (raysBuiltFor != publishedScene) {
+                rays.build(*publishedScene);
+                raysBuiltFor = publishedScene;
+            }
+            Ray ray;
+            ray.origin = renderCameraPos;
+            ray.direction = cameraFront;
+            reportPick(rays, *publishedScene, ray);
+        }
+
+        if (!opts.recordPath.empty()) {
+            CameraSample cam;
+            cam.time = glfwGetTime() - recordStart;
+            cam.position = renderCameraPos;
+            cam.yaw = yaw;
+            cam.pitch = pitch;
+            cam.fov = fov;
+            cam.shadingMode = (activeProgram == gouraudProgram) ? 1 : (activeProgram == bakedProgram) ? 2 : 0;
+            recorder.record(cam);
+        }
+
+        if (opts.renderOnDemand && !needsRedraw(current, lastDrawn, shaders.pendingCount() > 0)) {
+            // Nothing changed: keep presenting the last frame and sleep until input arrives.
+            // Hot reload needs the loop back regularly to notice saved shader files.
+            if (window) waitForEvents(0.25, shaders.hotReloading());
+            pacer.resetClock();
+            continue;
+        }
+
+        if (opts.pipelineDrawList) {
+            jobs.wait(buildJob);
+            std::swap(ready, building);
+            if (!ready->valid) buildFramePacket(jobs, current, *ready); // first frame: nothing queued yet
+            FramePacket* target = building;
+            buildJob = jobs.submit([&jobs, target, current] { buildFramePacket(jobs, current, *target); });
+        } else {
+            buildFramePacket(jobs, current, *ready);
+        }
+        const FramePacket& packet = *ready;
+        lastDrawn = packet.snapshot;
+        sceneDirty = false;
+        ++drawnFrames;
+        shaders.noteFrame();
+        drawnItems += packet.items.size();
+        culledItems += packet.culled;
+        drawLights += packet.lightRefs;
+        frameLightSlots += packet.frameLights.size();
+        droppedLights += packet.lightsDropped;
+        drawnFixtures += packet.fixtureCount;
+        fixtureDraws += packet.fixtures.size();
+        litFixtures += packet.fixturesLit;
+
+        // Output = window or headless framebuffer. The scene may go through the dynamic
+        // resolution target (scaled) and/or the anti-aliasing target on its way there.
+        const GLuint outputFBO = opts.headless ? headlessFBO.get() : 0;
+        int outputWidth = SCR_WIDTH, outputHeight = SCR_HEIGHT;
+        if (!opts.headless && window) glfwGetFramebufferSize(window, &outputWidth, &outputHeight);
+        if (aaMode != antiAliasing.mode()) {
+            if (antiAliasing.init(aaMode, outputWidth, outputHeight) || aaMode == AA_OFF) {
+                std::cout << "Anti-aliasing: " << AntiAliasing::name(aaMode) << "\n";
+            } else {
+                std::cerr << "Warning: " << AntiAliasing::name(aaMode) << " unavailable, anti-aliasing off\n";
+            }
+        }
+        antiAliasing.resize(outputWidth, outputHeight);
+        dynamicRes.resize(outputWidth, outputHeight);
+        const int sceneWidth = dynamicRes.active() ? dynamicRes.sceneWidth() : outputWidth;
+        const int sceneHeight = dynamicRes.active() ? dynamicRes.sceneHeight() : outputHeight;
+        if (dynamicRes.active()) dynamicRes.beginScene();
+        if (antiAliasing.active()) antiAliasing.beginScene(sceneWidth, sceneHeight);
+        else if (!dynamicRes.active() && opts.headless) glBindFramebuffer(GL_FRAMEBUFFER, outputFBO);
+        scenePassTimer.begin();
         glClearColor(0.1f,0.1f,0.1f,1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // Use active program and upload common uniforms
-        glUseProgram(activeProgram);
+        // The packet may be one frame old, so draw with the program it was built for
+        unsigned int drawProgram = packet.snapshot.program;
+        glUseProgram(drawProgram);
+
+        // texture unit
+        glUniform1i(glGetUniformLocation(drawProgram, "textureSampler"), 0);
+        if (packet.snapshot.baked) {
+            glUniform1i(glGetUniformLocation(drawProgram, "lightmapSampler"), 1);
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, lightmapTexture.get());
+            glUniform1i(glGetUniformLocation(drawProgram, "probeGridActive"), haveProbes ? 1 : 0);
+            // units 2-4 even without probes: a sampler3D left on unit 0 with the sampler2D
+            // makes every draw with this program fail (GL_INVALID_OPERATION)
+            static const char* const probeSamplers[3] = { "probeRed", "probeGreen", "probeBlue" };
+            for (int c = 0; c < 3; ++c) {
+                glUniform1i(glGetUniformLocation(drawProgram, probeSamplers[c]), 2 + c);
+            }
+            if (haveProbes) {
+                for (int c = 0; c < 3; ++c) {
+                    glActiveTexture(GL_TEXTURE2 + c);
+                    glBindTexture(GL_TEXTURE_3D, probeTextures[c].get());
+                }
+                glUniform3fv(glGetUniformLocation(drawProgram, "probeGridMin"), 1, &probes.boundsMin[0]);
+                glUniform3fv(glGetUniformLocation(drawProgram, "probeGridMax"), 1, &probes.boundsMax[0]);
+            }
+            glActiveTexture(GL_TEXTURE0);
+        }
 
-        // view position + texture unit
-        glUniform3fv(glGetUniformLocation(activeProgram, "viewPos"), 1, &cameraPos[0]);
-        glUniform1i(glGetUniformLocation(activeProgram, "textureSampler"), 0);
+        // bulb positions/colors: re-uploaded only when the frame's light table or the scene changed
+        if (packet.snapshot.scene != lightsUploadedFor || packet.frameLights != uploadedFrameLights) {
+            uploadFrameLights(*packet.snapshot.scene, packet.frameLights, lightsUBO.get());
+            lightsUploadedFor = packet.snapshot.scene;
+            uploadedFrameLights = packet.frameLights;
+        }
 
-        // send bulb positions/colors
-        int numToSend = std::min((int)bulbPositions.size(), NUM_BULBS);
-        for (int i = 0; i < numToSend; ++i) {
-            std::string posName = std::string("lightPos[") + std::to_string(i) + "]";
-            glUniform3fv(glGetUniformLocation(activeProgram, posName.c_str()), 1, &bulbPositions[i][0]);
+        // camera uniforms + the culled, sorted draws
+        // stream texture detail, biggest on screen first, within the per-frame budget
+        noteTextureCoverage(packet);
+        textureStreamer.update();
 
-            std::string colName = std::string("lightColor[") + std::to_string(i) + "]";
-            glUniform3fv(glGetUniformLocation(activeProgram, colName.c_str()), 1, &bulbColors[i][0]);
+        submitFramePacket(*ready, perDrawRing);
+        if (antiAliasing.active()) {
+            antiAliasing.resolve(dynamicRes.active() ? dynamicRes.target() : outputFBO, sceneWidth, sceneHeight);
+        }
+        scenePassTimer.end();
+        if (dynamicRes.active()) {
+            dynamicRes.resolve(outputFBO);
+            if (scenePassTimer.resolved() != timedScenePasses) {
+                timedScenePasses = scenePassTimer.resolved();
+                dynamicRes.update(scenePassTimer.latestMs(), pacer.lastCpuMs());
+            }
         }
-        glUniform1i(glGetUniformLocation(activeProgram, "numLights"), numToSend);
 
-        // legacy single-light (harmless if shader doesn't use it)
-        GLint locLegacyLight = glGetUniformLocation(activeProgram, "lightColor");
-        if (locLegacyLight != -1) glUniform3f(locLegacyLight, 1.0f, 1.0f, 1.0f);
+        if (std::binary_search(opts.captureFrames.begin(), opts.captureFrames.end(), drawnFrames - 1)) {
+            int fbw = SCR_WIDTH, fbh = SCR_HEIGHT;
+            if (!opts.headless) glfwGetFramebufferSize(window, &fbw, &fbh);
+            frameCapture.capture(drawnFrames - 1, fbw, fbh);
+        }
+        CapturedImage captured;
+        while (frameCapture.poll(captured)) opts.golden.check(captured);
+        if (frameRecorder.active()) {
+            int fbw = SCR_WIDTH, fbh = SCR_HEIGHT;
+            if (!opts.headless) glfwGetFramebufferSize(window, &fbw, &fbh);
+            frameRecorder.captureFrame(drawnFrames - 1, fbw, fbh);
+        }
+        if (!opts.captureFrames.empty() && drawnFrames > opts.captureFrames.back() && frameCapture.pending() == 0) {
+            requestClose(); // every requested frame is checked
+        }
 
-        // projection + view
-        glm::mat4 projection = glm::perspective(glm::radians(fov), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-        glUniformMatrix4fv(glGetUniformLocation(activeProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        glUniformMatrix4fv(glGetUniformLocation(activeProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
+        if (opts.overlay) {
+            // after the captures were queued, so golden images and recordings stay text-free
+            const char* mode = activeProgram == phongProgram ? "Phong" : activeProgram == bakedProgram ? "baked" : "Gouraud";
+            char lines[3][96];
+            std::snprintf(lines[0], sizeof(lines[0]), "frame %llu  cpu %.2f ms  gpu %.2f ms",
+                          drawnFrames - 1, pacer.lastCpuMs(), scenePassTimer.latestMs());
+            std::snprintf(lines[1], sizeof(lines[1]), "%s  %u draws  %u lights  aa %s", mode,
+                          (unsigned)packet.items.size(), (unsigned)packet.frameLights.size(),
+                          AntiAliasing::name(antiAliasing.active() ? antiAliasing.mode() : AA_OFF));
+            std::snprintf(lines[2], sizeof(lines[2]), "shaders pending %u", (unsigned)shaders.pendingCount());
+            for (int l = 0; l < 3; ++l) {
+                int y = outputHeight - (l + 1) * (overlaySize + 2) - 4;
+                if (overlaySdf) printText2DSdf(lines[l], 8.0f, (float)y, (float)overlaySize, 0xFFFFFFFFu, 1.0f);
+                else printText2D(lines[l], 8, y, overlaySize);
+            }
+            glBindFramebuffer(GL_FRAMEBUFFER, outputFBO);
+            glViewport(0, 0, outputWidth, outputHeight);
+            glDisable(GL_DEPTH_TEST);
+            flushText2D(outputWidth, outputHeight);
+            glEnable(GL_DEPTH_TEST);
+        }
 
-        // Draw the scene using the active program
-        drawScene(activeProgram, ceilingTexture, floorTexture);
+        // CPU time ends here: the swap (vsync) and the fence waits are the GPU's time
+        pacer.markSubmitted(RingBuffer::totalStallMs() - fenceWaitAtStart);
+        if (window) {
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+        glDispatchEndFrame();
+        pacer.endFrame();
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        if (opts.maxFrames && pacer.frameCount() + 1 >= opts.maxFrames) requestClose();
     }
-
-    // cleanup
-    glDeleteVertexArrays(1, &roomVAO);
-    glDeleteBuffers(1, &roomVBO);
-    glDeleteBuffers(1, &roomEBO);
-    glDeleteVertexArrays(1, &projectorVAO);
-    glDeleteBuffers(1, &projectorVBO);
-    glDeleteBuffers(1, &projectorEBO);
-    glDeleteVertexArrays(1, &lightBoxVAO);
-    glDeleteBuffers(1, &lightBoxVBO);
-    glDeleteBuffers(1, &lightBoxEBO);
-
-    for (auto &m : sceneMeshes) {
-        if (m.VAO) glDeleteVertexArrays(1, &m.VAO);
-        if (m.VBO) glDeleteBuffers(1, &m.VBO);
-        if (m.EBO) glDeleteBuffers(1, &m.EBO);
-        if (m.textureID) glDeleteTextures(1, &m.textureID);
+    jobs.wait(buildJob);
+    jobs.stop();
+    if (!opts.recordPath.empty() && recorder.save(opts.recordPath)) {
+        std::cout << "Recorded " << recorder.sampleCount() << " camera samples to " << opts.recordPath << "\n";
     }
-
-    // delete both shader programs
-    if (phongProgram) glDeleteProgram(phongProgram);
-    if (gouraudProgram) glDeleteProgram(gouraudProgram);
-
+    if (cameraScripted) {
+        std::cout << "Replayed " << replayFrame << " frames (" << player.duration() << " s at "
+                  << opts.replayFps << " fps)\n";
+    }
+    pacer.report(std::cout);
+    if (drawnFrames) {
+        std::cout << "  draw list      : " << (double)drawnItems / drawnFrames << " draws, "
+                  << (double)culledItems / drawnFrames << " culled per frame ("
+                  << jobs.workerCount() << " worker threads"
+                  << (opts.pipelineDrawList ? ", pipelined" : "") << ")\n";
+        std::cout << "  light fixtures : " << (double)drawnFixtures / drawnFrames << " per frame in "
+                  << (double)fixtureDraws / drawnFrames << " instanced draws (unlit)";
+        if (litFixtures) std::cout << ", " << (double)litFixtures / drawnFrames << " drawn lit (light table full)";
+        std::cout << "\n";
+        std::cout << "  lights per draw: " << (drawnItems ? (double)drawLights / drawnItems : 0.0)
+                  << " of " << scene.lightCount() << " (threshold " << opts.lightThreshold << "), "
+                  << (double)frameLightSlots / drawnFrames << " in the frame's light table";
+        if (droppedLights) std::cout << ", " << droppedLights << " references dropped (table full)";
+        std::cout << "\n";
+        std::cout << "  opaque pass    : " << (opts.drawOrder == DRAW_ORDER_FRONT_TO_BACK ? "front-to-back" : "state-sorted")
+                  << (opts.depthPrepass ? ", depth pre-pass" : "") << ", anti-aliasing "
+                  << AntiAliasing::name(antiAliasing.active() ? antiAliasing.mode() : AA_OFF) << "\n";
+    }
+    if (opts.overlay) {
+        Text2DStats text = text2DStats();
+        std::cout << "  text overlay   : " << text.strings << " strings, " << text.glyphs << " glyphs in "
+                  << text.draws << " draws over " << text.flushes << " frames\n";
+        if (text.draws > text.flushes) std::cerr << "Warning: text took more than one draw per frame\n";
+    }
+    scenePassTimer.finish();
+    scenePassTimer.report(std::cout, "gpu scene pass ");
+    dynamicRes.report(std::cout);
+    perDrawRing.report(std::cout);
+    shaders.report(std::cout);
+    if (rays.instanceCount()) rays.report(std::cout);
+    cameraCollider.report(std::cout);
+    lightmapBaker.report(std::cout);
+    if (haveProbes) probeBaker.report(std::cout);
+    textureStreamer.report(std::cout);
+    gpuResources().report(std::cout);
+    glDispatchReport(std::cout);
+    bool glWithinLimits = !glDispatchInstalled() || glDispatchCheckLimits(opts.glLimits, std::cerr);
+    if (!opts.captureFrames.empty()) {
+        CapturedImage captured;
+        while (frameCapture.poll(captured, true)) opts.golden.check(captured);
+        if (frameCapture.dropped()) std::cerr << "[GOLDEN] " << frameCapture.dropped() << " captures dropped (all slots busy)\n";
+        opts.golden.report(std::cout);
+    }
+    frameCapture.destroy();
+    if (frameRecorder.active()) {
+        frameRecorder.stop();
+        frameRecorder.report(std::cout);
+    }
+    perDrawRing.destroy();
+    lightsUBO.reset();
+    scenePassTimer.destroy();
+
+    // cleanup: globals outlive main's scope, so release them while the context is current
+    roomVAO.reset(); roomVBO.reset(); roomEBO.reset();
+    projectorVAO.reset(); projectorVBO.reset(); projectorEBO.reset();
+    lightBoxVAO.reset(); lightBoxVBO.reset(); lightBoxEBO.reset();
+    sceneMeshes.clear();
+
+    // textures (shared between meshes) belong to the streamer
+    textureStreamer.destroy();
+
+    shaders.destroy();
+    fallbackShader.reset();
+    depthVAOs.clear();
+    depthVBOs.clear();
+    lightmapTexture.reset();
+    lightmapUVBuffers.clear();
+    for (GpuTexture& t : probeTextures) t.reset();
+    headlessFBO.reset();
+    headlessColor.reset();
+    headlessDepth.reset();
+    dynamicRes.destroy();
+    antiAliasing.destroy();
+    if (opts.overlay) cleanupText2D();
+
+    // anything still registered here was never released
+    gpuResources().reportLeaks(std::cerr);
     glfwTerminate();
+    pacer.shutdown();
+    // golden run: non-zero exit on any mismatch so scripts/CI notice
+    if (!opts.captureFrames.empty()) {
+        bool allChecked = opts.golden.update || opts.golden.passed() == (int)opts.captureFrames.size();
+        if (opts.golden.failed() > 0 || !allChecked) return 1;
+    }
+    if (!glWithinLimits) return 1;
     return 0;
 }
 
 
 
+/* -------------------- command line -------------------- */
+bool parseOptions(int argc, char** argv, AppOptions& opts) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const char* next = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (arg == "--fps-cap" && next) {
+            opts.pacing.fpsCap = std::atof(argv[++i]);
+        } else if (arg == "--tick-rate" && next) {
+            opts.pacing.tickRate = std::atof(argv[++i]);
+        } else if (arg == "--vsync" && next) {
+            std::string mode = argv[++i];
+            if (mode == "off") opts.pacing.vsync = VSYNC_OFF;
+            else if (mode == "on") opts.pacing.vsync = VSYNC_ON;
+            else if (mode == "adaptive") opts.pacing.vsync = VSYNC_ADAPTIVE;
+            else { std::cerr << "Unknown vsync mode: " << mode << " (off|on|adaptive)\n"; return false; }
+        } else if (arg == "--jobs" && next) {
+            opts.jobThreads = std::atoi(argv[++i]);
+        } else if (arg == "--light-threshold" && next) {
+            opts.lightThreshold = (float)std::atof(argv[++i]);
+        } else if (arg == "--record" && next) {
+            opts.recordPath = argv[++i];
+        } else if (arg == "--replay" && next) {
+            opts.replayPath = argv[++i];
+        } else if (arg == "--path" && next) {
+            opts.splinePath = argv[++i];
+        } else if (arg == "--replay-fps" && next) {
+            opts.replayFps = std::atof(argv[++i]);
+            if (opts.replayFps <= 0.0) { std::cerr << "--replay-fps must be positive\n"; return false; }
+        } else if (arg == "--headless") {
+            opts.headless = true;
+        } else if (arg == "--capture-frames" && next) {
+            // comma separated frame numbers, 0 = first rendered frame
+            std::string list = argv[++i];
+            size_t pos = 0;
+            while (pos < list.size()) {
+                size_t comma = list.find(',', pos);
+                if (comma == std::string::npos) comma = list.size();
+                opts.captureFrames.push_back(std::strtoull(list.substr(pos, comma - pos).c_str(), nullptr, 10));
+                pos = comma + 1;
+            }
+            std::sort(opts.captureFrames.begin(), opts.captureFrames.end());
+            opts.captureFrames.erase(std::unique(opts.captureFrames.begin(), opts.captureFrames.end()), opts.captureFrames.end());
+        } else if (arg == "--golden-dir" && next) {
+            opts.golden.directory = argv[++i];
+        } else if (arg == "--update-golden") {
+            opts.golden.update = true;
+        } else if (arg == "--golden-threshold" && next) {
+            opts.golden.pixelThreshold = (float)std::atof(argv[++i]);
+        } else if (arg == "--golden-max-diff" && next) {
+            opts.golden.maxDifferingFraction = std::atof(argv[++i]);
+        } else if (arg == "--capture-out" && next) {
+            opts.recording.output = argv[++i];
+            const std::string& out = opts.recording.output;
+            bool y4m = out.size() > 4 && out.compare(out.size() - 4, 4, ".y4m") == 0;
+            opts.recording.format = y4m ? CAPTURE_Y4M : CAPTURE_BMP_SEQUENCE;
+        } else if (arg == "--capture-queue" && next) {
+            opts.recording.queueDepth = std::atoi(argv[++i]);
+        } else if (arg == "--stream-budget-kb" && next) {
+            opts.streaming.bytesPerFrame = (size_t)std::max(1, std::atoi(argv[++i])) * 1024;
+        } else if (arg == "--stream-budget-ms" && next) {
+            opts.streaming.msPerFrame = std::atof(argv[++i]);
+        } else if (arg == "--no-pipeline") {
+            opts.pipelineDrawList = false;
+        } else if (arg == "--on-demand") {
+            opts.renderOnDemand = true;
+        } else if (arg == "--frames" && next) {
+            opts.maxFrames = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--rooms" && next) {
+            opts.campus.rooms = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--rooms-per-row" && next) {
+            opts.campus.roomsPerRow = std::atoi(argv[++i]);
+        } else if ((arg == "--bench-grid" || arg == "--bulb-grid") && next) {
+            // columns x rows, e.g. 4x6
+            int cols = 0, rows = 0;
+            if (std::sscanf(argv[++i], "%dx%d", &cols, &rows) != 2 || cols < 0 || rows < 0) {
+                std::cerr << arg << " expects COLSxROWS, e.g. 4x6\n";
+                return false;
+            }
+            if (arg == "--bench-grid") { opts.campus.benchColumns = cols; opts.campus.benchRows = rows; }
+            else { opts.campus.bulbColumns = cols; opts.campus.bulbRows = rows; }
+        } else if (arg == "--variety" && next) {
+            opts.campus.variety = (float)std::atof(argv[++i]);
+        } else if (arg == "--campus-seed" && next) {
+            opts.campus.seed = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--noclip") {
+            opts.cameraCollision = false;
+        } else if (arg == "--ray-bench" && next) {
+            opts.rayBench = (size_t)std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--lightmap" && next) {
+            opts.lightmapPath = argv[++i];
+        } else if (arg == "--lightmap-density" && next) {
+            opts.lightmap.texelsPerMeter = std::max(0.1f, (float)std::atof(argv[++i]));
+        } else if (arg == "--lightmap-samples" && next) {
+            opts.lightmap.indirectSamples = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--lightmap-bounces" && next) {
+            opts.lightmap.bounces = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--probes" && next) {
+            opts.probesPath = argv[++i];
+        } else if (arg == "--probe-spacing" && next) {
+            opts.probes.spacing = std::max(0.05f, (float)std::atof(argv[++i]));
+        } else if (arg == "--probe-rays" && next) {
+            opts.probes.raysPerProbe = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--sync-shaders") {
+            opts.syncShaders = true;
+        } else if (arg == "--shader-dir" && next) {
+            opts.shaderDir = argv[++i];
+        } else if (arg == "--no-hot-reload") {
+            opts.hotReload = false;
+        } else if (arg == "--overlay") {
+            opts.overlay = true;
+        } else if (arg == "--overlay-font" && next) {
+            opts.overlayFont = argv[++i];
+            opts.overlay = true;
+        } else if (arg == "--depth-prepass") {
+            opts.depthPrepass = true;
+        } else if (arg == "--draw-order" && next) {
+            std::string order = argv[++i];
+            if (order == "state") opts.drawOrder = DRAW_ORDER_STATE;
+            else if (order == "front-to-back") opts.drawOrder = DRAW_ORDER_FRONT_TO_BACK;
+            else { std::cerr << "Unknown draw order: " << order << " (state|front-to-back)\n"; return false; }
+        } else if (arg == "--dynamic-res" && next) {
+            // frame budget in ms, 0 = the frame cap / refresh interval
+            opts.dynamicResolution = true;
+            opts.dynamicRes.targetMs = std::max(0.0, std::atof(argv[++i]));
+        } else if (arg == "--dynamic-res-min" && next) {
+            opts.dynamicRes.minScale = (float)std::atof(argv[++i]);
+        } else if (arg == "--aa" && next) {
+            std::string mode = argv[++i];
+            if (mode == "off") opts.antiAliasing = AA_OFF;
+            else if (mode == "fxaa") opts.antiAliasing = AA_FXAA;
+            else if (mode == "msaa2") opts.antiAliasing = AA_MSAA2;
+            else if (mode == "msaa4") opts.antiAliasing = AA_MSAA4;
+            else { std::cerr << "Unknown anti-aliasing mode: " << mode << " (off|fxaa|msaa2|msaa4)\n"; return false; }
+        } else if (arg == "--gl-counters") {
+            opts.glCounters = true;
+        } else if (arg == "--null-gl") {
+            opts.nullGL = true;
+        } else if (arg == "--gl-limits" && next) {
+            // comma separated key=value per-frame ceilings, e.g. draws=200,binds=400,upload-kb=256
+            std::string list = argv[++i];
+            size_t pos = 0;
+            while (pos < list.size()) {
+                size_t comma = list.find(',', pos);
+                if (comma == std::string::npos) comma = list.size();
+                std::string item = list.substr(pos, comma - pos);
+                pos = comma + 1;
+                size_t eq = item.find('=');
+                std::string key = item.substr(0, eq);
+                unsigned long long value = eq == std::string::npos ? 0 : std::strtoull(item.c_str() + eq + 1, nullptr, 10);
+                if (key == "calls") opts.glLimits.calls = value;
+                else if (key == "draws") opts.glLimits.draws = value;
+                else if (key == "binds") opts.glLimits.binds = value;
+                else if (key == "state") opts.glLimits.stateChanges = value;
+                else if (key == "uniforms") opts.glLimits.uniformWrites = value;
+                else if (key == "upload-kb") opts.glLimits.uploadBytes = value * 1024;
+                else { std::cerr << "Unknown --gl-limits key: " << key << " (calls|draws|binds|state|uniforms|upload-kb)\n"; return false; }
+            }
+            opts.glCounters = true;
+        } else {
+            std::cerr << "Unknown option: " << arg << "\n"
+                      << "Usage: " << argv[0] << " [--fps-cap N] [--tick-rate N] [--vsync off|on|adaptive] [--on-demand] [--jobs N] [--no-pipeline] [--light-threshold L]\n"
+                      << "       [--record file.fly] [--replay file.fly | --path file.txt] [--replay-fps N] [--frames N]\n"
+                      << "       [--headless] [--capture-frames a,b,...] [--golden-dir DIR] [--update-golden] [--golden-threshold T] [--golden-max-diff F]\n"
+                      << "       [--capture-out file.y4m|DIR] [--capture-queue N] [--stream-budget-kb N] [--stream-budget-ms T]\n"
+                      << "       [--gl-counters] [--null-gl] [--gl-limits draws=N,binds=N,state=N,uniforms=N,calls=N,upload-kb=N]\n"
+                      << "       [--rooms N] [--rooms-per-row N] [--bench-grid CxR] [--bulb-grid CxR] [--variety F] [--campus-seed S]\n"
+                      << "       [--ray-bench N] [--noclip] [--lightmap FILE] [--lightmap-density T] [--lightmap-samples N] [--lightmap-bounces N]\n"
+                      << "       [--probes FILE] [--probe-spacing M] [--probe-rays N] [--depth-prepass] [--draw-order state|front-to-back]\n"
+                      << "       [--dynamic-res MS] [--dynamic-res-min S] [--aa off|fxaa|msaa2|msaa4] [--sync-shaders]\n"
+                      << "       [--shader-dir DIR] [--no-hot-reload] [--overlay] [--overlay-font file.pgm|file.dds|file.sdff]\n";
+            return false;
+        }
+    }
+    if (opts.nullGL) {
+        // nothing is rendered, so there is nothing to read back, and no window to close
+        if (!opts.captureFrames.empty() || !opts.recording.output.empty()) {
+            std::cerr << "--null-gl draws nothing; it can't be combined with --capture-frames/--capture-out\n";
+            return false;
+        }
+        if (!opts.maxFrames && opts.replayPath.empty() && opts.splinePath.empty()) {
+            std::cerr << "--null-gl needs --frames N or a --replay/--path sequence to end\n";
+            return false;
+        }
+        opts.headless = true;
+        opts.glCounters = true;
+    }
+    return true;
+}
+
 /* -------------------- input / callbacks -------------------- */
 void processInput(GLFWwindow *window) {
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) glfwSetWindowShouldClose(window, true);
+    if (cameraScripted) return;
     float cameraSpeed = 2.5f * deltaTime;
     if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) cameraPos += cameraSpeed * cameraFront;
     if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) cameraPos -= cameraSpeed * cameraFront;
@@ -278,13 +1032,90 @@ void processInput(GLFWwindow *window) {
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) cameraPos += glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;
     if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) cameraPos.y += cameraSpeed;
     if (glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS) cameraPos.y -= cameraSpeed;
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) glfwSetWindowShouldClose(window, true);
 }
 
 void framebuffer_size_callback(GLFWwindow*, int width, int height) {
     glViewport(0, 0, width, height);
+    markSceneDirty();
+}
+void window_refresh_callback(GLFWwindow*) {
+    // contents damaged (expose, restore from minimise): the old frame can't be reused
+    markSceneDirty();
+}
+
+bool needsRedraw(const SceneSnapshot& current, const SceneSnapshot& lastDrawn, bool shadersPending) {
+    if (sceneDirty) return true;
+    // textures still sharpening
+    if (!textureStreamer.allResident()) return true;
+    // draws still on the fallback program: keep polling until their own one is ready
+    if (shadersPending) return true;
+    // camera still settling between the last two ticks
+    if (prevCameraPos != cameraPos) return true;
+    return current.cameraPos != lastDrawn.cameraPos ||
+           current.cameraFront != lastDrawn.cameraFront ||
+           current.fov != lastDrawn.fov ||
+           current.program != lastDrawn.program ||
+           current.scene != lastDrawn.scene;
+}
+
+// Rough on-screen area of each textured draw (bounding sphere projected at its depth),
+// used to stream the most visible textures first.
+void noteTextureCoverage(const FramePacket& packet) {
+    const SceneSnapshot& snap = packet.snapshot;
+    if (!snap.scene) return;
+    const SceneStore& sc = *snap.scene;
+    const float focal = (SCR_HEIGHT * 0.5f) / tan(glm::radians(snap.fov) * 0.5f);
+    const float screenArea = (float)SCR_WIDTH * (float)SCR_HEIGHT;
+    for (const DrawItem& item : packet.items) {
+        uint32_t mat = sc.material[item.node];
+        if (mat == SCENE_NONE || !sc.materials[mat].hasTexture) continue;
+        glm::vec3 center = 0.5f * (sc.boundsMin[item.node] + sc.boundsMax[item.node]);
+        float radius = 0.5f * glm::length(sc.boundsMax[item.node] - sc.boundsMin[item.node]);
+        float depth = std::max(glm::dot(center - snap.cameraPos, snap.cameraFront), 0.1f);
+        float px = radius * focal / depth;
+        textureStreamer.setScreenCoverage(sc.materials[mat].texture, std::min(3.14159f * px * px, screenArea));
+    }
+}
+
+// Prints what the ray hit and how many of the lights reaching that point can see it.
+void reportPick(const SceneBVH& rays, const SceneStore& scene, const Ray& ray) {
+    RayHit hit;
+    if (!rays.intersect(ray, hit)) {
+        std::cout << "Picked nothing\n";
+        return;
+    }
+    int inRange = 0, visible = 0;
+    glm::vec3 from = hit.position + 1e-3f * hit.normal; // off the surface
+    for (size_t l = 0; l < scene.lightCount(); ++l) {
+        if (glm::length(scene.lightPosition[l] - hit.position) > scene.lightRadius[l]) continue;
+        ++inRange;
+        if (!rays.occluded(from, scene.lightPosition[l], scene.lightNode[l])) ++visible;
+    }
+    const std::string& name = scene.meshNames[scene.mesh[hit.node]];
+    std::cout << "Picked " << name << " (node " << hit.node << ") at " << hit.t << " m, position ("
+              << hit.position.x << ", " << hit.position.y << ", " << hit.position.z << "), "
+              << visible << " of " << inRange << " lights in range visible\n";
+}
+
+void waitForEvents(double timeoutSeconds, bool mustReturn) {
+#if GLFW_VERSION_MAJOR > 3 || (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 2)
+    (void)mustReturn;
+    glfwWaitEventsTimeout(timeoutSeconds);
+#else
+    // GLFW 3.1 has no timed wait; any input or window event wakes us up
+    (void)timeoutSeconds;
+    if (mustReturn) {
+        // the caller has to come back without input: sleep a short slice and poll,
+        // short enough that input waiting in the queue still feels immediate
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        glfwPollEvents();
+        return;
+    }
+    glfwWaitEvents();
+#endif
 }
 void mouse_callback(GLFWwindow*, double xpos, double ypos) {
+    if (cameraScripted) return;
     if (firstMouse) {
         lastX = (float)xpos; lastY = (float)ypos; firstMouse = false;
     }
@@ -295,246 +1126,199 @@ void mouse_callback(GLFWwindow*, double xpos, double ypos) {
     xoffset *= sensitivity; yoffset *= sensitivity;
     yaw += xoffset; pitch += yoffset;
     pitch = glm::clamp(pitch, -89.0f, 89.0f);
-    glm::vec3 front;
-    front.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
-    front.y = sin(glm::radians(pitch));
-    front.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
-    cameraFront = glm::normalize(front);
+    cameraFront = cameraFrontFromYawPitch(yaw, pitch);
+}
+void mouse_button_callback(GLFWwindow*, int button, int action, int) {
+    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) pickRequested = true;
 }
 void scroll_callback(GLFWwindow*, double, double yoffset) {
+    if (cameraScripted) return;
     fov -= (float)yoffset;
     if (fov < 1.0f) fov = 1.0f;
     if (fov > 45.0f) fov = 45.0f;
 }
 
-unsigned int createPhongProgram() {
-    // (this is essentially your existing shader: per-fragment lighting)
+// Stand-in while the real programs compile: material colour (and texture), a fixed
+// half-Lambert term against straight down, no lights. Small enough to compile in a few
+// milliseconds, so it is built synchronously before the first frame. Same vertex
+// inputs and PerDraw block as the lit shaders, and the same invariant gl_Position, so
+// the depth pre-pass matches it too.
+unsigned int createFallbackProgram() {
     const char* vShaderSrc = R"(
         #version 330 core
         layout (location = 0) in vec3 aPos;
         layout (location = 1) in vec3 aNormal;
         layout (location = 2) in vec2 aTexCoord;
 
-        uniform mat4 model;
         uniform mat4 view;
         uniform mat4 projection;
-        uniform vec2 uvScale;
 
-        out vec3 FragPos;
-        out vec3 Normal;
+        layout (std140) uniform PerDraw {
+            mat4 model;
+            mat4 normalMatrix;
+            vec4 colorAndTexture; // rgb = objectColor, a = hasTexture
+            vec4 uvScale;         // xy
+            ivec4 lightCount;     // x = lights reaching this draw
+            ivec4 lightIndex[2];  // MAX_DRAW_LIGHTS indices into Lights, strongest first
+            vec4 lightmapScaleOffset; // atlas rectangle of the second UV set, zero if not lightmapped
+        };
+
+        out vec3 shade;
         out vec2 TexCoord;
+        invariant gl_Position; // same depth as the depth pre-pass
 
         void main() {
             gl_Position = projection * view * model * vec4(aPos, 1.0);
-            FragPos = vec3(model * vec4(aPos, 1.0));
-            Normal = mat3(transpose(inverse(model))) * aNormal;
-            TexCoord = aTexCoord * uvScale;
+            float up = normalize(mat3(normalMatrix) * aNormal).y;
+            shade = colorAndTexture.rgb * (0.6 - 0.3 * up); // ceiling bulbs light from above
+            TexCoord = aTexCoord * uvScale.xy;
         }
     )";
 
     const char* fShaderSrc = R"(
         #version 330 core
-        #define NUM_LIGHTS 6
-
-        out vec4 FragColor;
-
-        in vec3 FragPos;
-        in vec3 Normal;
+        in vec3 shade;
         in vec2 TexCoord;
-
-        uniform vec3 objectColor;
-        uniform vec3 viewPos;
-
-        uniform vec3 lightPos[NUM_LIGHTS];
-        uniform vec3 lightColor[NUM_LIGHTS];    
-        uniform int numLights;
+        out vec4 FragColor;
 
         uniform sampler2D textureSampler;
-        uniform bool hasTexture;
 
-        void main() {
-            vec3 surfaceColor;
-            if (hasTexture) surfaceColor = texture(textureSampler, TexCoord).rgb;
-            else surfaceColor = objectColor;
+        layout (std140) uniform PerDraw {
+            mat4 model;
+            mat4 normalMatrix;
+            vec4 colorAndTexture;
+            vec4 uvScale;
+            ivec4 lightCount;
+            ivec4 lightIndex[2];
+            vec4 lightmapScaleOffset;
+        };
 
-            vec3 ambient = vec3(0.05);
-
-            vec3 norm = normalize(Normal);
-            vec3 viewDir = normalize(viewPos - FragPos);
-
-            vec3 result = ambient * surfaceColor;
-
-            for (int i = 0; i < numLights; ++i) {
-                vec3 L = lightPos[i] - FragPos;
-                float dist = length(L);
-                vec3 lightDir = normalize(L);
-
-                float constant = 1.0;
-                float linear = 0.09;
-                float quadratic = 0.032;
-                float attenuation = 1.0 / (constant + linear * dist + quadratic * (dist * dist));
-
-                float diff = max(dot(norm, lightDir), 0.0);
-                vec3 diffuse = diff * lightColor[i];
-
-                float specularStrength = 0.6;
-                vec3 halfwayDir = normalize(lightDir + viewDir);
-                float spec = pow(max(dot(norm, halfwayDir), 0.0), 32.0);
-                vec3 specular = specularStrength * spec * lightColor[i];
-
-                vec3 lightContrib = (diffuse + specular) * attenuation;
-                result += lightContrib * surfaceColor;
-            }
-
-            FragColor = vec4(result, 1.0);
+        void main() {
+            vec3 c = shade;
+            if (colorAndTexture.a > 0.5) c *= texture(textureSampler, TexCoord).rgb;
+            FragColor = vec4(c, 1.0);
         }
     )";
 
-    auto compile = [](const char* src, GLenum type) -> GLuint {
-        GLuint s = glCreateShader(type);
-        glShaderSource(s, 1, &src, NULL);
-        glCompileShader(s);
-        GLint ok; glGetShaderiv(s, GL_COMPILE_STATUS, &ok);
-        if (!ok) {
-            char log[1024]; glGetShaderInfoLog(s, 1024, NULL, log);
-            std::cerr << "Shader compile error: " << log << std::endl;
-        }
-        return s;
-    };
-
-    GLuint vs = compile(vShaderSrc, GL_VERTEX_SHADER);
-    GLuint fs = compile(fShaderSrc, GL_FRAGMENT_SHADER);
-    GLuint prog = glCreateProgram();
-    glAttachShader(prog, vs); glAttachShader(prog, fs);
-    glLinkProgram(prog);
-    GLint ok; glGetProgramiv(prog, GL_LINK_STATUS, &ok);
-    if (!ok) {
-        char log[1024]; glGetProgramInfoLog(prog, 1024, NULL, log);
-        std::cerr << "Program link error: " << log << std::endl;
-    }
-    glDeleteShader(vs); glDeleteShader(fs);
+    GLuint prog = compileProgramNow("shader/fallback", vShaderSrc, fShaderSrc);
+    if (!prog) return 0;
+    GLuint perDrawBlock = glGetUniformBlockIndex(prog, "PerDraw");
+    if (perDrawBlock != GL_INVALID_INDEX) glUniformBlockBinding(prog, perDrawBlock, PER_DRAW_BINDING);
     return prog;
 }
 
-unsigned int createGouraudProgram() {
-    // Per-vertex (Gouraud) lighting: compute lighting in vertex shader and pass final color to fragment.
-    const char* vShaderSrc = R"(
-        #version 330 core
-        #define NUM_LIGHTS 6
-
-        layout (location = 0) in vec3 aPos;
-        layout (location = 1) in vec3 aNormal;
-        layout (location = 2) in vec2 aTexCoord;
-
-        uniform mat4 model;
-        uniform mat4 view;
-        uniform mat4 projection;
-        uniform vec2 uvScale;
-
-        uniform vec3 objectColor;
-        uniform vec3 viewPos;
-
-        uniform vec3 lightPos[NUM_LIGHTS];
-        uniform vec3 lightColor[NUM_LIGHTS];
-        uniform int numLights;
-
-        out vec3 litColor;    // final lighting color (interpolated)
-        out vec2 TexCoord;
-
-        void main() {
-            vec3 FragPos = vec3(model * vec4(aPos, 1.0));
-            vec3 norm = normalize(mat3(transpose(inverse(model))) * aNormal);
-            vec3 viewDir = normalize(viewPos - FragPos);
-
-            // For textured objects we'll compute a lighting multiplier in vertex shader
-            // and apply it to the texture in the fragment shader. Here we multiply
-            // by objectColor so non-textured objects still work.
-            vec3 surfaceColor = objectColor;
-
-            vec3 ambient = vec3(0.05);
-            vec3 result = ambient * surfaceColor;
-
-            for (int i = 0; i < numLights; ++i) {
-                vec3 L = lightPos[i] - FragPos;
-                float dist = length(L);
-                vec3 lightDir = normalize(L);
-
-                float constant = 1.0;
-                float linear = 0.09;
-                float quadratic = 0.032;
-                float attenuation = 1.0 / (constant + linear * dist + quadratic * (dist * dist));
-
-                float diff = max(dot(norm, lightDir), 0.0);
-                vec3 diffuse = diff * lightColor[i];
-
-                float specularStrength = 0.6;
-                vec3 halfwayDir = normalize(lightDir + viewDir);
-                float spec = pow(max(dot(norm, halfwayDir), 0.0), 32.0);
-                vec3 specular = specularStrength * spec * lightColor[i];
-
-                vec3 lightContrib = (diffuse + specular) * attenuation;
-                result += lightContrib * surfaceColor;
-            }
-
-            litColor = result; // pass lit color to fragment
-            TexCoord = aTexCoord * uvScale;
-
-            gl_Position = projection * view * model * vec4(aPos, 1.0);
-        }
-    )";
-
-    const char* fShaderSrc = R"(
-        #version 330 core
-        out vec4 FragColor;
-
-        in vec3 litColor;
-        in vec2 TexCoord;
-
-        uniform sampler2D textureSampler;
-        uniform bool hasTexture;
-        uniform vec3 objectColor;
-
-        void main() {
-            if (hasTexture) {
-                vec3 tex = texture(textureSampler, TexCoord).rgb;
-                FragColor = vec4(tex * litColor, 1.0);
-            } else {
-                FragColor = vec4(objectColor * litColor, 1.0); // litColor already includes objectColor's effect above, but this is safe
-            }
-        }
-    )";
+// Position-only copy of every VAO's vertices for the depth pre-pass (12 bytes a vertex
+// instead of the interleaved 32), bound to the VAO's element buffer so the draws' index
+// ranges stay valid. Meshes sharing a VAO share the copy.
+void uploadDepthStreams(SceneStore& scene, const std::vector<MeshGeometry>& meshGeometry,
+                        std::vector<GpuVertexArray>& vaos, std::vector<GpuBuffer>& buffers) {
+    std::map<unsigned int, std::vector<glm::vec3>> byVAO;
+    for (size_t m = 0; m < meshGeometry.size() && m < scene.meshes.size(); ++m) {
+        const std::vector<glm::vec3>& src = meshGeometry[m].positions;
+        std::vector<glm::vec3>& positions = byVAO[scene.meshes[m].vao];
+        if (positions.size() < src.size()) positions = src;
+    }
+    std::map<unsigned int, unsigned int> depthVAO;
+    for (auto& entry : byVAO) {
+        if (!entry.first || entry.second.empty()) continue;
+        GLint ebo = 0;
+        glBindVertexArray(entry.first);
+        glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &ebo);
+        vaos.push_back(GpuVertexArray());
+        buffers.push_back(GpuBuffer());
+        vaos.back().create("geometry/depth positions");
+        buffers.back().create("geometry/depth positions");
+        glBindVertexArray(vaos.back().get());
+        gpuBufferData(GL_ARRAY_BUFFER, buffers.back(), entry.second.size() * sizeof(glm::vec3), entry.second.data(),
+                      GL_STATIC_DRAW, "vertex");
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, (GLuint)ebo);
+        depthVAO[entry.first] = vaos.back().get();
+    }
+    glBindVertexArray(0);
+    for (MeshGPU& mesh : scene.meshes) {
+        std::map<unsigned int, unsigned int>::const_iterator it = depthVAO.find(mesh.vao);
+        if (it != depthVAO.end()) mesh.depthVao = it->second;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
 
-    auto compile = [](const char* src, GLenum type) -> GLuint {
-        GLuint s = glCreateShader(type);
-        glShaderSource(s, 1, &src, NULL);
-        glCompileShader(s);
-        GLint ok; glGetShaderiv(s, GL_COMPILE_STATUS, &ok);
-        if (!ok) {
-            char log[1024]; glGetShaderInfoLog(s, 1024, NULL, log);
-            std::cerr << "Shader compile error: " << log << std::endl;
+// Atlas texture plus the second UV set, as attribute 3 of every lightmapped mesh's VAO.
+// Meshes sharing a VAO (the room's faces) use disjoint vertices, so their UVs share a buffer.
+void uploadLightmap(const SceneStore& scene, const Lightmap& lightmap, GpuTexture& texture,
+                    std::vector<GpuBuffer>& uvBuffers) {
+    texture.create("lightmap/atlas");
+    glBindTexture(GL_TEXTURE_2D, texture.get());
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, lightmap.width, lightmap.height, 0, GL_RGBA, GL_FLOAT, lightmap.texels.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    gpuResources().setSize(GPU_TEXTURE, texture.get(), gpuImageBytes(GL_RGBA16F, lightmap.width, lightmap.height),
+                           "RGBA16F " + std::to_string(lightmap.width) + "x" + std::to_string(lightmap.height));
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    std::map<unsigned int, std::vector<glm::vec2>> byVAO;
+    for (size_t m = 0; m < lightmap.meshUV.size() && m < scene.meshes.size(); ++m) {
+        const std::vector<glm::vec2>& src = lightmap.meshUV[m];
+        if (src.empty()) continue;
+        std::vector<glm::vec2>& uv = byVAO[scene.meshes[m].vao];
+        if (uv.size() < src.size()) uv.resize(src.size(), glm::vec2(0.0f));
+        // vertices the mesh doesn't use are zero there
+        for (size_t v = 0; v < src.size(); ++v) {
+            if (src[v] != glm::vec2(0.0f)) uv[v] = src[v];
         }
-        return s;
-    };
-
-    GLuint vs = compile(vShaderSrc, GL_VERTEX_SHADER);
-    GLuint fs = compile(fShaderSrc, GL_FRAGMENT_SHADER);
-    GLuint prog = glCreateProgram();
-    glAttachShader(prog, vs); glAttachShader(prog, fs);
-    glLinkProgram(prog);
-    GLint ok; glGetProgramiv(prog, GL_LINK_STATUS, &ok);
-    if (!ok) {
-        char log[1024]; glGetProgramInfoLog(prog, 1024, NULL, log);
-        std::cerr << "Program link error: " << log << std::endl;
     }
-    glDeleteShader(vs); glDeleteShader(fs);
-    return prog;
+    for (auto& entry : byVAO) {
+        uvBuffers.push_back(GpuBuffer());
+        GpuBuffer& buffer = uvBuffers.back();
+        buffer.create("geometry/lightmap uv");
+        glBindVertexArray(entry.first);
+        gpuBufferData(GL_ARRAY_BUFFER, buffer, entry.second.size() * sizeof(glm::vec2), entry.second.data(),
+                      GL_STATIC_DRAW, "vertex");
+        glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+        glEnableVertexAttribArray(3);
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
-
+// One RGBA16F 3D texture per colour channel, one texel per probe; the hardware's
+// trilinear filter does the interpolation between probes.
+void uploadProbeGrid(const ProbeGrid& probes, GpuTexture textures[3]) {
+    static const char* const owners[3] = { "probes/red", "probes/green", "probes/blue" };
+    const glm::ivec3 s = probes.size;
+    for (int c = 0; c < 3; ++c) {
+        textures[c].create(owners[c]);
+        glBindTexture(GL_TEXTURE_3D, textures[c].get());
+        glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA16F, s.x, s.y, s.z, 0, GL_RGBA, GL_FLOAT, probes.channels[c].data());
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        gpuResources().setSize(GPU_TEXTURE, textures[c].get(), gpuImageBytes(GL_RGBA16F, s.x, s.y * s.z),
+                               "RGBA16F " + std::to_string(s.x) + "x" + std::to_string(s.y) + "x" + std::to_string(s.z));
+    }
+    glBindTexture(GL_TEXTURE_3D, 0);
+}
 
 
 
 /* -------------------- geometry (room = new dimensionality) -------------------- */
+// Positions, normals (the first 6 of every 8 floats) and indices of an interleaved pos/normal/uv mesh.
+MeshGeometry keepGeometry(const float* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount) {
+    MeshGeometry g;
+    for (size_t v = 0; v < vertexCount; ++v) {
+        const float* f = vertices + v * 8;
+        g.positions.push_back(glm::vec3(f[0], f[1], f[2]));
+        g.normals.push_back(glm::vec3(f[3], f[4], f[5]));
+    }
+    g.indices.assign(indices, indices + indexCount);
+    return g;
+}
+
 void setupGeometry() {
     // New room dims: w=10, h=5, d=10 (matches new script)
     float w = 10.0f, h = 5.0f, d = 8.0f;
@@ -585,14 +1369,13 @@ void setupGeometry() {
         20,21,22, 22,23,20  // right
     };
 
-    glGenVertexArrays(1, &roomVAO);
-    glGenBuffers(1, &roomVBO);
-    glGenBuffers(1, &roomEBO);
-    glBindVertexArray(roomVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, roomVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(roomVerts), roomVerts, GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, roomEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(roomInds), roomInds, GL_STATIC_DRAW);
+    roomVAO.create("geometry/room");
+    roomVBO.create("geometry/room");
+    roomEBO.create("geometry/room");
+    glBindVertexArray(roomVAO.get());
+    gpuBufferData(GL_ARRAY_BUFFER, roomVBO, sizeof(roomVerts), roomVerts, GL_STATIC_DRAW, "vertex");
+    gpuBufferData(GL_ELEMENT_ARRAY_BUFFER, roomEBO, sizeof(roomInds), roomInds, GL_STATIC_DRAW, "index");
+    roomGeometry = keepGeometry(roomVerts, sizeof(roomVerts) / (8 * sizeof(float)), roomInds, sizeof(roomInds) / sizeof(unsigned int));
 
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
@@ -611,14 +1394,13 @@ void setupGeometry() {
         -pw/2,  ph/2, 0,  0,0,1, 0,1
     };
     unsigned int projInds[] = { 0,1,2, 2,3,0 };
-    glGenVertexArrays(1, &projectorVAO);
-    glGenBuffers(1, &projectorVBO);
-    glGenBuffers(1, &projectorEBO);
-    glBindVertexArray(projectorVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, projectorVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(projVerts), projVerts, GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, projectorEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(projInds), projInds, GL_STATIC_DRAW);
+    projectorVAO.create("geometry/projector");
+    projectorVBO.create("geometry/projector");
+    projectorEBO.create("geometry/projector");
+    glBindVertexArray(projectorVAO.get());
+    gpuBufferData(GL_ARRAY_BUFFER, projectorVBO, sizeof(projVerts), projVerts, GL_STATIC_DRAW, "vertex");
+    gpuBufferData(GL_ELEMENT_ARRAY_BUFFER, projectorEBO, sizeof(projInds), projInds, GL_STATIC_DRAW, "index");
+    projectorGeometry = keepGeometry(projVerts, 4, projInds, 6);
     glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,8*sizeof(float),(void*)0);
     glVertexAttribPointer(1,3,GL_FLOAT,GL_FALSE,8*sizeof(float),(void*)(3*sizeof(float)));
     glVertexAttribPointer(2,2,GL_FLOAT,GL_FALSE,8*sizeof(float),(void*)(6*sizeof(float)));
@@ -642,217 +1424,111 @@ void setupGeometry() {
         0,1,5, 5,4,0, 2,3,7, 7,6,2,
         0,3,7, 7,4,0, 1,2,6, 6,5,1
     };
-    glGenVertexArrays(1, &lightBoxVAO);
-    glGenBuffers(1, &lightBoxVBO);
-    glGenBuffers(1, &lightBoxEBO);
-    glBindVertexArray(lightBoxVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, lightBoxVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(boxVerts), boxVerts, GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lightBoxEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(boxInds), boxInds, GL_STATIC_DRAW);
+    lightBoxVAO.create("geometry/lightbox");
+    lightBoxVBO.create("geometry/lightbox");
+    lightBoxEBO.create("geometry/lightbox");
+    glBindVertexArray(lightBoxVAO.get());
+    gpuBufferData(GL_ARRAY_BUFFER, lightBoxVBO, sizeof(boxVerts), boxVerts, GL_STATIC_DRAW, "vertex");
+    gpuBufferData(GL_ELEMENT_ARRAY_BUFFER, lightBoxEBO, sizeof(boxInds), boxInds, GL_STATIC_DRAW, "index");
+    lightBoxGeometry = keepGeometry(boxVerts, 8, boxInds, 36);
     glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,8*sizeof(float),(void*)0);
     glVertexAttribPointer(1,3,GL_FLOAT,GL_FALSE,8*sizeof(float),(void*)(3*sizeof(float)));
     glEnableVertexAttribArray(0); glEnableVertexAttribArray(1);
     glBindVertexArray(0);
 }
 
-/* -------------------- draw scene -------------------- */
-void drawScene(unsigned int shaderProgram, unsigned int ceilingTex, unsigned int floorTex) {
-    auto setTexture = [&](bool enabled, unsigned int tex, glm::vec3 col = glm::vec3(1.0f)) {
-        glUniform1i(glGetUniformLocation(shaderProgram, "hasTexture"), enabled ? GL_TRUE : GL_FALSE);
-        if (enabled && tex) {
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, tex);
-        } else {
-            glUniform3fv(glGetUniformLocation(shaderProgram, "objectColor"), 1, &col[0]);
+/* -------------------- scene -------------------- */
+// Registers the shared meshes/materials (room surfaces from setupGeometry, the light box,
+// each shape of the loaded OBJ models, the projector sheet) and lets the campus generator
+// place them: one classroom by default, a grid of rooms for scale testing. Per-frame
+// culling/sorting/submission works on a published copy of the store.
+void buildScene(SceneStore& scene, std::vector<MeshGeometry>& meshGeometry, unsigned int ceilingTex,
+                unsigned int floorTex, float lightThreshold, const CampusConfig& campus) {
+    // immediate-mode drawScene set uvScale only for floor/ceiling, so everything drawn
+    // after the ceiling inherited its 6x6 tiling; keep that look
+    const glm::vec2 inheritedUvScale(6.0f, 6.0f);
+
+    auto addMaterial = [&](const glm::vec3& color, bool textured, unsigned int tex, const glm::vec2& uvScale) {
+        Material m;
+        m.color = color;
+        m.hasTexture = textured;
+        m.texture = tex;
+        m.uvScale = uvScale;
+        return scene.addMaterial(m);
+    };
+    // VAOs/buffers stay owned by the setupGeometry globals and sceneMeshes; the same
+    // index range of the CPU copy is handed back for ray queries and collision
+    auto addMesh = [&](unsigned int vao, const MeshGeometry& geometry, unsigned int count, unsigned int first,
+                       const glm::vec3& localMin, const glm::vec3& localMax, const std::string& name) {
+        MeshGPU g;
+        g.vao = vao;
+        g.indexCount = count;
+        g.firstIndex = first;
+        g.boundsMin = localMin;
+        g.boundsMax = localMax;
+        uint32_t id = scene.addMesh(g, name);
+        meshGeometry.resize(id + 1);
+        if (first + count <= geometry.indices.size()) {
+            meshGeometry[id].positions = geometry.positions;
+            meshGeometry[id].indices.assign(geometry.indices.begin() + first, geometry.indices.begin() + first + count);
         }
+        return id;
     };
 
-    // Draw room (floor, ceiling, walls). Use new dims layout
-    glBindVertexArray(roomVAO);
-    glm::mat4 model = glm::mat4(1.0f);
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    // set tiling for floor
-    glUniform2f(glGetUniformLocation(shaderProgram, "uvScale"), 8.0f, 8.0f); // 8×8 tiles across face (tweak)
-    setTexture(true, floorTex);
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, (void*)(0));
-
-    // ceiling
-    glUniform2f(glGetUniformLocation(shaderProgram, "uvScale"), 6.0f, 6.0f); // e.g. 6×6, tweak to match pattern
-    setTexture(true, ceilingTex);
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, (void*)(6 * sizeof(unsigned int)));
-
-
-    // // floor
-    // setTexture(true, floorTex);
-    // glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, (void*)(0));
-    // // ceiling
-    // setTexture(true, ceilingTex);
-    // glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, (void*)(6 * sizeof(unsigned int)));
-    // back+front (walls) - no texture, subtle colors
-    setTexture(false, 0, glm::vec3(0.95f));
-    glDrawElements(GL_TRIANGLES, 12, GL_UNSIGNED_INT, (void*)(12 * sizeof(unsigned int)));
-    setTexture(false, 0, glm::vec3(0.90f));
-    glDrawElements(GL_TRIANGLES, 12, GL_UNSIGNED_INT, (void*)(24 * sizeof(unsigned int)));
-    glBindVertexArray(0);
+    CampusAssets assets;
+    // Room (floor, ceiling, walls), same dims as setupGeometry
+    const float w = ROOM_HALF_WIDTH, h = ROOM_HEIGHT, d = ROOM_HALF_DEPTH;
+    assets.floorTiles = glm::vec2(8.0f); // 8x8 tiles
+    assets.ceilingTiles = glm::vec2(6.0f);
+    assets.floorMesh = addMesh(roomVAO.get(), roomGeometry, 6, 0, glm::vec3(-w, 0.0f, -d), glm::vec3(w, 0.0f, d), "room/floor");
+    assets.floorMaterial = addMaterial(glm::vec3(1.0f), true, floorTex, assets.floorTiles);
+    assets.ceilingMesh = addMesh(roomVAO.get(), roomGeometry, 6, 6, glm::vec3(-w, h, -d), glm::vec3(w, h, d), "room/ceiling");
+    assets.ceilingMaterial = addMaterial(glm::vec3(1.0f), true, ceilingTex, assets.ceilingTiles);
+    // back+front and left+right walls - no texture, subtle colors
+    assets.frontBackMesh = addMesh(roomVAO.get(), roomGeometry, 12, 12, glm::vec3(-w, 0.0f, -d), glm::vec3(w, h, d), "room/front+back");
+    assets.frontBackMaterial = addMaterial(glm::vec3(0.95f), false, 0, inheritedUvScale);
+    assets.leftRightMesh = addMesh(roomVAO.get(), roomGeometry, 12, 24, glm::vec3(-w, 0.0f, -d), glm::vec3(w, h, d), "room/left+right");
+    assets.leftRightMaterial = addMaterial(glm::vec3(0.90f), false, 0, inheritedUvScale);
+
+    // ceiling bulbs: small flat light boxes
+    const float lw = 1.5f, lh = 0.1f;
+    assets.bulbMesh = addMesh(lightBoxVAO.get(), lightBoxGeometry, 36, 0, glm::vec3(-lw / 2, -lh / 2, -lw / 2),
+                              glm::vec3(lw / 2, lh / 2, lw / 2), "lightbox");
+    assets.bulbColor = glm::vec3(1.0f, 1.0f, 0.95f);
+    assets.lightThreshold = lightThreshold;
 
-    // Draw light boxes (use one light element at the ceiling in the center)
-    // glBindVertexArray(lightBoxVAO);
-    // setTexture(false, 0, glm::vec3(0.95f, 0.95f, 0.85f));
-    // model = glm::translate(glm::mat4(1.0f), lightPos);
-    // glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    // glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-    // glBindVertexArray(0);
-
-
-    // Draw light boxes (one per bulb)
-    glBindVertexArray(lightBoxVAO);
-    for (int i = 0; i < (int)bulbPositions.size(); ++i) {
-        glm::vec3 bp = bulbPositions[i];
-        // make the box small and slightly lower than the exact bulb position if desired
-        float scale = 0.18f; // small box size; tweak for visibility
-        glm::mat4 modelLight = glm::translate(glm::mat4(1.0f), bp);
-        modelLight = glm::scale(modelLight, glm::vec3(scale, scale * 0.4f, scale));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(modelLight));
-        // bright emissive color for bulbs; since shader multiplies by surface color, set it bright
-        setTexture(false, 0, bulbColors[i]);
-        glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-    }
-    glBindVertexArray(0);
+    // projector sheet (small pale quad)
+    const float pw = 1.0f, ph = 0.6f;
+    assets.projectorMesh = addMesh(projectorVAO.get(), projectorGeometry, 6, 0, glm::vec3(-pw / 2, -ph / 2, 0.0f),
+                                   glm::vec3(pw / 2, ph / 2, 0.0f), "projector");
+    assets.projectorMaterial = addMaterial(glm::vec3(0.92f, 0.92f, 0.88f), false, 0, inheritedUvScale);
 
-    // Draw podium, greenboard, benches (sceneMeshes)
+    // Podium, greenboard, benches (sceneMeshes): register each shape once, grouped by model
+    std::vector<std::pair<std::string, std::vector<CampusShape>>> models;
     for (auto &mesh : sceneMeshes) {
         if (!mesh.VAO || mesh.indexCount == 0) continue;
-        glBindVertexArray(mesh.VAO);
-
-        if (mesh.logicalName == "bench") {
-
-            // setTexture(mesh.hasTexture, mesh.textureID, mesh.color);
-
-            // // Big room: Z goes from -10 (front) to +10 (back)
-            // // Put last row near z = +9, move forward by row spacing
-            // float backZ = 9.0f;
-            // float rowSpacing = 3.0f;       // space between bench rows
-            // float colSpacing = 3.5f;       // space between columns
-            // float startX = -7.0f;          // left-most bench
-            // float startY = 0.5f;           // height
-
-            // for (int r = 0; r < 5; ++r) {
-            //     for (int c = 0; c < 5; ++c) {
-
-            //         float x = startX + c * colSpacing;
-            //         float y = startY;
-            //         float z = backZ - r * rowSpacing;
-
-            //         glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(x, y, z));
-            //         model = glm::rotate(glm::scale(model, glm::vec3(0.35f)), glm::radians(180.0f), glm::vec3(0, 1, 0));
-
-            //         glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-            //         glDrawElements(GL_TRIANGLES, (GLsizei)mesh.indexCount, GL_UNSIGNED_INT, 0);
-            //     }
-            // }
-            setTexture(mesh.hasTexture, mesh.textureID, mesh.color);
-
-            // Layout configuration
-            const int cols = 4;
-            const float d_room = 8.0f;                   // 4 columns total
-            const float backZ = d_room-1.0f;             // back-most z
-            const float rowSpacing = 2.0f;        // distance between centers of consecutive rows
-            const float benchScale = 0.35f;
-            const float y = 0.68f;
-
-            // Per-column row counts (index 0 = leftmost column)
-            // You requested: first 2 columns -> 5 rows, others -> 6 rows
-            int rowCount[cols] = { 5, 5, 6, 6 };
-
-            // Column layout (middle 2 joined, symmetric outer gaps)
-            const float benchCenterSep = 3.5f;    // center-to-center for adjacent benches in middle pair
-            const float outerGap = 1.0f;          // surface-to-surface gap between outer and middle pair
-
-            float mid_left  = -benchCenterSep * 0.5f;
-            float mid_right =  benchCenterSep * 0.5f;
-            float centerDistOuterToMiddle = benchCenterSep + outerGap;
-
-            float colX[4];
-            colX[0] = mid_left - centerDistOuterToMiddle; // left outer
-            colX[1] = mid_left;                            // middle-left (joined)
-            colX[2] = mid_right;                           // middle-right (joined)
-            colX[3] = mid_right + centerDistOuterToMiddle; // right outer
-
-            // Draw benches per column using per-column rowCount
-            for (int c = 0; c < cols; ++c) {
-                int rows_here = rowCount[c];
-                for (int r = 0; r < rows_here; ++r) {
-                    // z = backZ - r * rowSpacing keeps back-most aligned at backZ for every column
-                    // float z = backZ - r * rowSpacing;
-                    // glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(colX[c], y, z));
-                    // model = glm::rotate(glm::scale(model, glm::vec3(benchScale)), glm::radians(180.0f), glm::vec3(0,1,0));
-                    // glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-                    // glDrawElements(GL_TRIANGLES, (GLsizei)mesh.indexCount, GL_UNSIGNED_INT, 0);
-                    float z = backZ - r * rowSpacing; // back-aligned per column
-                    glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(colX[c], y, z));
-                    model = glm::rotate(glm::scale(model, glm::vec3(benchScale)), glm::radians(180.0f), glm::vec3(0,1,0));
-                    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-                    glDrawElements(GL_TRIANGLES, (GLsizei)mesh.indexCount, GL_UNSIGNED_INT, 0);
-                }
-            }
-        } else if (mesh.logicalName == "greenboard") {
-            // use old transform from original code
-            // glm::mat4 m = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 1.5f, -2.6f));
-            // m = glm::scale(m, glm::vec3(0.25f, 0.1f, 0.2f)); // approximate small board scale
-            // // But since new room distances are bigger, place board at front wall:
-            // m = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(2.0f, 2.5f, -9.8f)), glm::vec3(0.8f,0.8f,1.0f));
-            // glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(m));
-            // setTexture(mesh.hasTexture, mesh.textureID, mesh.color);
-            // glDrawElements(GL_TRIANGLES, (GLsizei)mesh.indexCount, GL_UNSIGNED_INT, 0);
-
-            float boardInset = 0.1f;
-            // glm::vec3 boardPos = glm::vec3(0.0f, 2.2f, -9.2f);
-            glm::vec3 boardPos = glm::vec3(0.0f, 2.5f, -8.0f + boardInset);
-            glm::vec3 boardScale = glm::vec3(0.6f, 0.19f, 0.6f); // X=width, Y=height, Z=depth scale
-            glm::mat4 m = glm::translate(glm::mat4(1.0f), boardPos);
-            m = glm::scale(m, boardScale);
-
-            glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(m));
-            setTexture(mesh.hasTexture, mesh.textureID, mesh.color);
-            glDrawElements(GL_TRIANGLES, (GLsizei)mesh.indexCount, GL_UNSIGNED_INT, 0);
-        } else if (mesh.logicalName == "podium") {
-            // old podium placement logic (scaled & positioned)
-            // float podiumInset = 2.0f;
-            // glm::mat4 m = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(-2.75f, 0.6f, -1.25f)), glm::vec3(0.2f));
-            // // but adapt to room far front similar to new script
-            // m = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(-5.0f, 0.5f, -8.0f)), glm::vec3(0.35f));
-            // glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(m));
-            // setTexture(mesh.hasTexture, mesh.textureID, mesh.color);
-            // glDrawElements(GL_TRIANGLES, (GLsizei)mesh.indexCount, GL_UNSIGNED_INT, 0);
-
-
-            float podiumInset = 2.5f;
-            glm::vec3 podiumPos = glm::vec3(-5.0f, 1.15f, -(8.0f - podiumInset)); // z = -6.0
-            float podiumScale = 0.35f;
-
-            glm::mat4 m = glm::scale(glm::translate(glm::mat4(1.0f), podiumPos), glm::vec3(podiumScale));
-            glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(m));
-            setTexture(mesh.hasTexture, mesh.textureID, mesh.color);
-            glDrawElements(GL_TRIANGLES, (GLsizei)mesh.indexCount, GL_UNSIGNED_INT, 0);
-        } else {
-            // fallback: draw at origin
-            glm::mat4 m = glm::mat4(1.0f);
-            glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(m));
-            setTexture(mesh.hasTexture, mesh.textureID, mesh.color);
-            glDrawElements(GL_TRIANGLES, (GLsizei)mesh.indexCount, GL_UNSIGNED_INT, 0);
+        CampusShape shape;
+        shape.mesh = addMesh(mesh.VAO.get(), mesh.geometry, (unsigned int)mesh.indexCount, 0, mesh.boundsMin, mesh.boundsMax,
+                             mesh.logicalName + "/" + mesh.shapeName);
+        shape.material = addMaterial(mesh.color, mesh.hasTexture, mesh.textureID, inheritedUvScale);
+        if (models.empty() || models.back().first != mesh.logicalName) {
+            models.push_back(std::make_pair(mesh.logicalName, std::vector<CampusShape>()));
         }
-
-        glBindVertexArray(0);
+        models.back().second.push_back(shape);
+    }
+    for (auto &model : models) {
+        if (model.first == "bench") assets.bench = model.second;
+        else if (model.first == "greenboard") assets.greenboard = model.second;
+        else if (model.first == "podium") assets.podium = model.second;
+        else assets.others.push_back(model.second); // fallback: drawn at the room origin
     }
 
-    // projector sheet (small pale quad)
-    glBindVertexArray(projectorVAO);
-    glm::mat4 pm = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(2.0f, 2.8f, -9.7f)), glm::vec3(1.8f, 1.2f, 1.0f));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(pm));
-    setTexture(false, 0, glm::vec3(0.92f, 0.92f, 0.88f));
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+    CampusStats stats = generateCampus(scene, assets, campus);
+    if (stats.rooms > 1 || stats.variedRooms) {
+        std::cout << "Campus: " << stats.rooms << " rooms (" << stats.roomSize.x << " x " << stats.roomSize.y
+                  << " m, " << stats.variedRooms << " varied), " << stats.benches << " benches, "
+                  << stats.bulbs << " bulbs" << std::endl;
+    }
 }
 
 /* -------------------- OBJ loader (per-shape) -------------------- */
@@ -1058,18 +1734,26 @@ if (logicalName == "greenboard") {
     mesh.indexCount = indices.size();
     if (vertices.empty()) return mesh;
 
+    mesh.boundsMin = glm::vec3(FLT_MAX);
+    mesh.boundsMax = glm::vec3(-FLT_MAX);
+    for (size_t i = 0; i < vertices.size(); i += 8) {
+        glm::vec3 p(vertices[i], vertices[i + 1], vertices[i + 2]);
+        mesh.boundsMin = glm::min(mesh.boundsMin, p);
+        mesh.boundsMax = glm::max(mesh.boundsMax, p);
+    }
+    mesh.geometry = keepGeometry(vertices.data(), vertices.size() / 8, indices.data(), indices.size());
+
     // GL buffers / VAO setup (same layout: pos(3), normal(3), uv(2) => stride = 8 floats)
-    glGenVertexArrays(1, &mesh.VAO);
-    glGenBuffers(1, &mesh.VBO);
-    glGenBuffers(1, &mesh.EBO);
+    const std::string owner = "mesh/" + logicalName + "/" + shape.name;
+    mesh.VAO.create(owner);
+    mesh.VBO.create(owner);
+    mesh.EBO.create(owner);
 
-    glBindVertexArray(mesh.VAO);
+    glBindVertexArray(mesh.VAO.get());
 
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    gpuBufferData(GL_ARRAY_BUFFER, mesh.VBO, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW, "vertex");
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    gpuBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW, "index");
 
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
@@ -1134,30 +1818,8 @@ std::vector<Mesh> loadOBJModels(const std::string& path, const std::string& logi
 
 
 /* -------------------- texture loader (stb_image) -------------------- */
+// Returns at once; the image is decoded in the background and its mips stream in
+// coarse-to-fine from textureStreamer.update() (see common/texturestreamer.hpp).
 unsigned int loadTexture(const char* path) {
-    int width, height, nrComponents;
-    stbi_set_flip_vertically_on_load(true);
-    unsigned char *data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (!data) {
-        std::cerr << "Texture failed to load at path: " << path << std::endl;
-        return 0;
-    }
-    GLenum format = GL_RGB;
-    if (nrComponents == 1) format = GL_RED;
-    else if (nrComponents == 3) format = GL_RGB;
-    else if (nrComponents == 4) format = GL_RGBA;
-
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexImage2D(GL_TEXTURE_2D, 0, (GLint)format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    stbi_image_free(data);
-    return textureID;
+    return textureStreamer.request(path);
 }
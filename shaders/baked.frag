@@ -0,0 +1,65 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoord;
+in vec2 LightmapUV;
+
+uniform vec3 viewPos;
+uniform sampler2D textureSampler;
+uniform sampler2D lightmapSampler;
+
+// irradiance probes: per channel, L1 SH as (a, b), irradiance = a + dot(b, n)
+uniform int probeGridActive;
+uniform vec3 probeGridMin;
+uniform vec3 probeGridMax;
+uniform sampler3D probeRed;
+uniform sampler3D probeGreen;
+uniform sampler3D probeBlue;
+
+#include "include/lights.glsl"
+#include "include/perdraw.glsl"
+
+void main() {
+    vec3 objectColor = colorAndTexture.rgb;
+    bool hasTexture = colorAndTexture.a > 0.5;
+    vec3 surfaceColor;
+    if (hasTexture) surfaceColor = texture(textureSampler, TexCoord).rgb;
+    else surfaceColor = objectColor;
+
+    vec3 ambient = vec3(0.05);
+
+    vec3 norm = normalize(Normal);
+    vec3 viewDir = normalize(viewPos - FragPos);
+
+    // draws without an atlas rectangle (bulbs, moving nodes) take their diffuse
+    // from the probe grid, or per light as in Phong when there is none
+    bool baked = lightmapScaleOffset.x > 0.0;
+    vec3 diffuse = vec3(0.0);
+    if (baked) {
+        diffuse = texture(lightmapSampler, LightmapUV).rgb;
+    } else if (probeGridActive != 0) {
+        vec3 uvw = (FragPos - probeGridMin) / (probeGridMax - probeGridMin);
+        vec4 n1 = vec4(1.0, norm);
+        diffuse = max(vec3(dot(texture(probeRed, uvw), n1), dot(texture(probeGreen, uvw), n1),
+                           dot(texture(probeBlue, uvw), n1)), 0.0);
+        baked = true;
+    }
+    vec3 specular = vec3(0.0);
+
+    for (int k = 0; k < lightCount.x; ++k) {
+        int i = lightIndex[k / 4][k % 4];
+        vec3 lightDir;
+        float attenuation = lightAttenuation(i, FragPos, lightDir);
+
+        if (!baked) diffuse += max(dot(norm, lightDir), 0.0) * lightColor[i].rgb * attenuation;
+
+        float specularStrength = 0.6;
+        vec3 halfwayDir = normalize(lightDir + viewDir);
+        float spec = pow(max(dot(norm, halfwayDir), 0.0), 32.0);
+        specular += specularStrength * spec * lightColor[i].rgb * attenuation;
+    }
+
+    FragColor = vec4((ambient + diffuse + specular) * surfaceColor, 1.0);
+}
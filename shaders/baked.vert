@@ -0,0 +1,27 @@
+#version 330 core
+// Baked lighting: diffuse (direct + one bounce, shadowed) comes from the lightmap
+// atlas or the irradiance probes, only the view-dependent specular is still computed
+// per light.
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in vec2 aLightmapUV;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+#include "include/perdraw.glsl"
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoord;
+out vec2 LightmapUV;
+invariant gl_Position; // same depth as the depth pre-pass
+
+void main() {
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    FragPos = vec3(model * vec4(aPos, 1.0));
+    Normal = mat3(normalMatrix) * aNormal;
+    TexCoord = aTexCoord * uvScale.xy;
+    LightmapUV = aLightmapUV * lightmapScaleOffset.xy + lightmapScaleOffset.zw;
+}
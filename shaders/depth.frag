@@ -0,0 +1,3 @@
+#version 330 core
+// no colour output: only depth is written
+void main() {}
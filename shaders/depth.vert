@@ -0,0 +1,15 @@
+#version 330 core
+// Depth pre-pass: the lit shaders' gl_Position and nothing else. Draws with
+// MeshGPU::depthVao, which only feeds attribute 0.
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+#include "include/perdraw.glsl"
+
+invariant gl_Position; // bit-identical to the lit pass, which tests GL_EQUAL against it
+
+void main() {
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
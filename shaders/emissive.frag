@@ -0,0 +1,6 @@
+#version 330 core
+flat in vec3 emitted;
+out vec4 FragColor;
+void main() {
+    FragColor = vec4(emitted, 1.0);
+}
@@ -0,0 +1,21 @@
+#version 330 core
+// Light fixtures (bulbs): unlit and instanced. Instance i is the light in Lights slot
+// firstLight + i, which gives both its position and its colour; fixtureBasis is the
+// batch's shared world rotation/scale. Nothing per fixture is set from the CPU.
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform mat4 fixtureBasis;
+uniform int firstLight;
+
+#include "include/lights.glsl"
+
+flat out vec3 emitted;
+
+void main() {
+    int light = firstLight + gl_InstanceID;
+    vec4 world = fixtureBasis * vec4(aPos, 1.0) + vec4(lightPosRadius[light].xyz, 0.0);
+    gl_Position = projection * view * world;
+    emitted = lightColor[light].rgb;
+}
@@ -0,0 +1,20 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 litColor;
+in vec2 TexCoord;
+
+uniform sampler2D textureSampler;
+
+#include "include/perdraw.glsl"
+
+void main() {
+    vec3 objectColor = colorAndTexture.rgb;
+    bool hasTexture = colorAndTexture.a > 0.5;
+    if (hasTexture) {
+        vec3 tex = texture(textureSampler, TexCoord).rgb;
+        FragColor = vec4(tex * litColor, 1.0);
+    } else {
+        FragColor = vec4(objectColor * litColor, 1.0); // litColor already includes objectColor's effect above, but this is safe
+    }
+}
@@ -0,0 +1,53 @@
+#version 330 core
+// Per-vertex (Gouraud) lighting: compute lighting here and pass the final color on.
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 viewPos;
+
+#include "include/perdraw.glsl"
+#include "include/lights.glsl"
+
+out vec3 litColor;    // final lighting color (interpolated)
+out vec2 TexCoord;
+invariant gl_Position; // same depth as the depth pre-pass
+
+void main() {
+    vec3 FragPos = vec3(model * vec4(aPos, 1.0));
+    vec3 norm = normalize(mat3(normalMatrix) * aNormal);
+    vec3 viewDir = normalize(viewPos - FragPos);
+
+    // For textured objects we'll compute a lighting multiplier in vertex shader
+    // and apply it to the texture in the fragment shader. Here we multiply
+    // by objectColor so non-textured objects still work.
+    vec3 surfaceColor = colorAndTexture.rgb;
+
+    vec3 ambient = vec3(0.05);
+    vec3 result = ambient * surfaceColor;
+
+    // only the lights the CPU found reaching this draw's bounds
+    for (int k = 0; k < lightCount.x; ++k) {
+        int i = lightIndex[k / 4][k % 4];
+        vec3 lightDir;
+        float attenuation = lightAttenuation(i, FragPos, lightDir);
+
+        float diff = max(dot(norm, lightDir), 0.0);
+        vec3 diffuse = diff * lightColor[i].rgb;
+
+        float specularStrength = 0.6;
+        vec3 halfwayDir = normalize(lightDir + viewDir);
+        float spec = pow(max(dot(norm, halfwayDir), 0.0), 32.0);
+        vec3 specular = specularStrength * spec * lightColor[i].rgb;
+
+        vec3 lightContrib = (diffuse + specular) * attenuation;
+        result += lightContrib * surfaceColor;
+    }
+
+    litColor = result; // pass lit color to fragment
+    TexCoord = aTexCoord * uvScale.xy;
+
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
@@ -0,0 +1,23 @@
+// The frame's light table (LightsBlock in common/lightculling.hpp), indexed by PerDraw.lightIndex.
+#define MAX_FRAME_LIGHTS 512 // = MAX_FRAME_LIGHTS in lightculling.hpp
+
+layout (std140) uniform Lights {
+    vec4 lightPosRadius[MAX_FRAME_LIGHTS]; // xyz = position, w = effective radius
+    vec4 lightColor[MAX_FRAME_LIGHTS];
+};
+
+// Distance falloff of light i at worldPos (the LightAttenuation defaults), and the unit
+// direction towards it.
+float lightAttenuation(int i, vec3 worldPos, out vec3 lightDir) {
+    vec3 L = lightPosRadius[i].xyz - worldPos;
+    float dist = length(L);
+    lightDir = normalize(L);
+
+    float constant = 1.0;
+    float linear = 0.09;
+    float quadratic = 0.032;
+    float attenuation = 1.0 / (constant + linear * dist + quadratic * (dist * dist));
+    // fade out at the effective radius so culled lights don't pop
+    float fade = clamp(1.0 - pow(dist / lightPosRadius[i].w, 4.0), 0.0, 1.0);
+    return attenuation * fade * fade;
+}
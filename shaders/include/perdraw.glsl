@@ -0,0 +1,10 @@
+// Per-draw constants, one std140 slot of the PerDraw ring per draw (PerDrawConstants in common/framepacket.hpp).
+layout (std140) uniform PerDraw {
+    mat4 model;
+    mat4 normalMatrix;
+    vec4 colorAndTexture; // rgb = objectColor, a = hasTexture
+    vec4 uvScale;         // xy
+    ivec4 lightCount;     // x = lights reaching this draw
+    ivec4 lightIndex[2];  // MAX_DRAW_LIGHTS indices into Lights, strongest first
+    vec4 lightmapScaleOffset; // atlas rectangle of the second UV set, zero if not lightmapped
+};
@@ -0,0 +1,47 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoord;
+
+uniform vec3 viewPos;
+uniform sampler2D textureSampler;
+
+#include "include/lights.glsl"
+#include "include/perdraw.glsl"
+
+void main() {
+    vec3 objectColor = colorAndTexture.rgb;
+    bool hasTexture = colorAndTexture.a > 0.5;
+    vec3 surfaceColor;
+    if (hasTexture) surfaceColor = texture(textureSampler, TexCoord).rgb;
+    else surfaceColor = objectColor;
+
+    vec3 ambient = vec3(0.05);
+
+    vec3 norm = normalize(Normal);
+    vec3 viewDir = normalize(viewPos - FragPos);
+
+    vec3 result = ambient * surfaceColor;
+
+    // only the lights the CPU found reaching this draw's bounds
+    for (int k = 0; k < lightCount.x; ++k) {
+        int i = lightIndex[k / 4][k % 4];
+        vec3 lightDir;
+        float attenuation = lightAttenuation(i, FragPos, lightDir);
+
+        float diff = max(dot(norm, lightDir), 0.0);
+        vec3 diffuse = diff * lightColor[i].rgb;
+
+        float specularStrength = 0.6;
+        vec3 halfwayDir = normalize(lightDir + viewDir);
+        float spec = pow(max(dot(norm, halfwayDir), 0.0), 32.0);
+        vec3 specular = specularStrength * spec * lightColor[i].rgb;
+
+        vec3 lightContrib = (diffuse + specular) * attenuation;
+        result += lightContrib * surfaceColor;
+    }
+
+    FragColor = vec4(result, 1.0);
+}
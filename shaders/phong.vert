@@ -0,0 +1,22 @@
+#version 330 core
+// Per-fragment (Phong) lighting: the vertex stage only transforms.
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+#include "include/perdraw.glsl"
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoord;
+invariant gl_Position; // same depth as the depth pre-pass
+
+void main() {
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    FragPos = vec3(model * vec4(aPos, 1.0));
+    Normal = mat3(normalMatrix) * aNormal;
+    TexCoord = aTexCoord * uvScale.xy;
+}
@@ -0,0 +1,61 @@
+// Offline SDF font builder: TrueType file in, .sdff atlas (sdffont.hpp) out.
+//
+//   sdffont <font.ttf> <out.sdff> [--em PX] [--spread PX] [--range FIRST-LAST] [--atlas-width PX]
+//
+// Built by `make sdf-font`; the renderer only ever loads the result.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#include "sdffontbuild.hpp"
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "usage: sdffont <font.ttf> <out.sdff> [--em PX] [--spread PX] [--range FIRST-LAST]"
+                     " [--atlas-width PX]" << std::endl;
+        return 2;
+    }
+    SdfFontConfig config;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--em")) config.emPixels = (float)atof(argv[i + 1]);
+        else if (!strcmp(argv[i], "--spread")) config.spread = (float)atof(argv[i + 1]);
+        else if (!strcmp(argv[i], "--atlas-width")) config.atlasWidth = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--range")) {
+            unsigned first = 0, last = 0;
+            if (sscanf(argv[i + 1], "%u-%u", &first, &last) != 2 || last < first) {
+                std::cerr << "bad --range, expected FIRST-LAST" << std::endl;
+                return 2;
+            }
+            config.firstCodepoint = first;
+            config.lastCodepoint = last;
+        } else {
+            std::cerr << "unknown option " << argv[i] << std::endl;
+            return 2;
+        }
+    }
+
+    std::ifstream in(argv[1], std::ios::binary);
+    if (!in) {
+        std::cerr << "cannot open " << argv[1] << std::endl;
+        return 1;
+    }
+    std::vector<uint8_t> ttf((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    SdfFont font;
+    std::string error;
+    if (!buildSdfFont(ttf, config, font, error)) {
+        std::cerr << argv[1] << ": " << error << std::endl;
+        return 1;
+    }
+    if (!font.save(argv[2])) {
+        std::cerr << "cannot write " << argv[2] << std::endl;
+        return 1;
+    }
+    std::cout << argv[2] << ": " << font.glyphs.size() << " glyphs, " << font.kerningPairs.size()
+              << " kerning pairs, " << font.atlasWidth << "x" << font.atlasHeight << " atlas" << std::endl;
+    return 0;
+}
@@ -0,0 +1,495 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+
+#include <glm/glm.hpp>
+
+#include "sdffontbuild.hpp"
+
+namespace {
+
+// ---- TrueType reading (big-endian, every read bounds-checked) ----
+
+struct FontReader {
+    const std::vector<uint8_t>& data;
+    bool ok = true;
+    explicit FontReader(const std::vector<uint8_t>& d) : data(d) {}
+
+    uint8_t u8(size_t at) {
+        if (at + 1 > data.size()) { ok = false; return 0; }
+        return data[at];
+    }
+    uint16_t u16(size_t at) {
+        if (at + 2 > data.size()) { ok = false; return 0; }
+        return (uint16_t)(data[at] << 8 | data[at + 1]);
+    }
+    int16_t s16(size_t at) { return (int16_t)u16(at); }
+    uint32_t u32(size_t at) {
+        if (at + 4 > data.size()) { ok = false; return 0; }
+        return (uint32_t)data[at] << 24 | (uint32_t)data[at + 1] << 16 | (uint32_t)data[at + 2] << 8 | data[at + 3];
+    }
+};
+
+struct OutlinePoint {
+    glm::vec2 p;
+    bool onCurve;
+};
+typedef std::vector<OutlinePoint> Contour;
+
+// 2x2 matrix plus offset, for composite glyph components
+struct GlyphTransform {
+    float a = 1.0f, b = 0.0f, c = 0.0f, d = 1.0f, dx = 0.0f, dy = 0.0f;
+    glm::vec2 apply(glm::vec2 p) const { return glm::vec2(a * p.x + c * p.y + dx, b * p.x + d * p.y + dy); }
+    GlyphTransform then(const GlyphTransform& outer) const {
+        GlyphTransform t;
+        t.a = outer.a * a + outer.c * b;
+        t.b = outer.b * a + outer.d * b;
+        t.c = outer.a * c + outer.c * d;
+        t.d = outer.b * c + outer.d * d;
+        glm::vec2 o = outer.apply(glm::vec2(dx, dy));
+        t.dx = o.x;
+        t.dy = o.y;
+        return t;
+    }
+};
+
+class TrueTypeFont {
+public:
+    explicit TrueTypeFont(const std::vector<uint8_t>& data) : r(data) {}
+
+    bool open(std::string& error);
+    uint32_t glyphIndex(uint32_t codepoint);
+    float advance(uint32_t glyph);          // font units
+    bool outline(uint32_t glyph, const GlyphTransform& xf, std::vector<Contour>& out, int depth = 0);
+    void kerningPairs(std::vector<uint16_t>& left, std::vector<uint16_t>& right, std::vector<int16_t>& value);
+
+    int unitsPerEm = 0;
+    float ascender = 0.0f, descender = 0.0f, lineGap = 0.0f; // font units
+
+private:
+    size_t table(const char* tag, size_t* length = nullptr);
+
+    FontReader r;
+    size_t glyf = 0, loca = 0, hmtx = 0, cmap4 = 0, kern = 0, kernLength = 0;
+    int indexToLocFormat = 0;
+    uint32_t numGlyphs = 0, numHMetrics = 0;
+};
+
+size_t TrueTypeFont::table(const char* tag, size_t* length) {
+    uint16_t numTables = r.u16(4);
+    uint32_t want = (uint32_t)(uint8_t)tag[0] << 24 | (uint32_t)(uint8_t)tag[1] << 16 |
+                    (uint32_t)(uint8_t)tag[2] << 8 | (uint8_t)tag[3];
+    for (uint16_t i = 0; i < numTables; ++i) {
+        size_t rec = 12 + 16 * (size_t)i;
+        if (r.u32(rec) == want) {
+            if (length) *length = r.u32(rec + 12);
+            return r.u32(rec + 8);
+        }
+    }
+    return 0;
+}
+
+bool TrueTypeFont::open(std::string& error) {
+    uint32_t version = r.u32(0);
+    if (version != 0x00010000u && version != 0x74727565u) { // 1.0 or 'true'; 'OTTO' (CFF) isn't handled
+        error = "not a TrueType font (CFF/OpenType outlines are not supported)";
+        return false;
+    }
+    size_t head = table("head"), maxp = table("maxp"), hhea = table("hhea");
+    glyf = table("glyf");
+    loca = table("loca");
+    hmtx = table("hmtx");
+    kern = table("kern", &kernLength);
+    size_t cmap = table("cmap");
+    if (!head || !maxp || !hhea || !glyf || !loca || !hmtx || !cmap) {
+        error = "missing one of the head/maxp/hhea/glyf/loca/hmtx/cmap tables";
+        return false;
+    }
+    unitsPerEm = r.u16(head + 18);
+    indexToLocFormat = r.s16(head + 50);
+    numGlyphs = r.u16(maxp + 4);
+    ascender = r.s16(hhea + 4);
+    descender = r.s16(hhea + 6);
+    lineGap = r.s16(hhea + 8);
+    numHMetrics = r.u16(hhea + 34);
+
+    // Unicode BMP subtable, format 4: Windows (3, 1) preferred, else any Unicode platform one
+    uint16_t subtables = r.u16(cmap + 2);
+    for (uint16_t i = 0; i < subtables; ++i) {
+        size_t rec = cmap + 4 + 8 * (size_t)i;
+        uint16_t platform = r.u16(rec), encoding = r.u16(rec + 2);
+        size_t sub = cmap + r.u32(rec + 4);
+        if (r.u16(sub) != 4) continue;
+        if (platform == 3 && encoding == 1) { cmap4 = sub; break; }
+        if (platform == 0 && !cmap4) cmap4 = sub;
+    }
+    if (!cmap4) {
+        error = "no Unicode cmap subtable in format 4";
+        return false;
+    }
+    if (!r.ok || unitsPerEm <= 0 || numHMetrics == 0) {
+        error = "truncated or corrupt font header";
+        return false;
+    }
+    return true;
+}
+
+uint32_t TrueTypeFont::glyphIndex(uint32_t codepoint) {
+    if (codepoint > 0xFFFF) return 0;
+    uint16_t segCount = r.u16(cmap4 + 6) / 2;
+    size_t endCodes = cmap4 + 14;
+    size_t startCodes = endCodes + 2 * (size_t)segCount + 2;
+    size_t idDeltas = startCodes + 2 * (size_t)segCount;
+    size_t idRangeOffsets = idDeltas + 2 * (size_t)segCount;
+    for (uint16_t i = 0; i < segCount; ++i) {
+        if (codepoint > r.u16(endCodes + 2 * (size_t)i)) continue;
+        uint16_t start = r.u16(startCodes + 2 * (size_t)i);
+        if (codepoint < start) return 0;
+        uint16_t delta = r.u16(idDeltas + 2 * (size_t)i);
+        size_t rangeAt = idRangeOffsets + 2 * (size_t)i;
+        uint16_t rangeOffset = r.u16(rangeAt);
+        if (!rangeOffset) return (codepoint + delta) & 0xFFFF;
+        uint16_t g = r.u16(rangeAt + rangeOffset + 2 * (size_t)(codepoint - start));
+        return g ? (uint32_t)((g + delta) & 0xFFFF) : 0;
+    }
+    return 0;
+}
+
+float TrueTypeFont::advance(uint32_t glyph) {
+    uint32_t metric = std::min(glyph, numHMetrics - 1);
+    return (float)r.u16(hmtx + 4 * (size_t)metric);
+}
+
+bool TrueTypeFont::outline(uint32_t glyph, const GlyphTransform& xf, std::vector<Contour>& out, int depth) {
+    if (glyph >= numGlyphs || depth > 8) return false;
+    size_t begin, end;
+    if (indexToLocFormat == 0) {
+        begin = 2 * (size_t)r.u16(loca + 2 * (size_t)glyph);
+        end = 2 * (size_t)r.u16(loca + 2 * (size_t)glyph + 2);
+    } else {
+        begin = r.u32(loca + 4 * (size_t)glyph);
+        end = r.u32(loca + 4 * (size_t)glyph + 4);
+    }
+    if (end <= begin) return r.ok; // no outline (space)
+    size_t g = glyf + begin;
+    int16_t contours = r.s16(g);
+
+    if (contours >= 0) {
+        std::vector<uint16_t> endPts(contours);
+        for (int16_t c = 0; c < contours; ++c) endPts[c] = r.u16(g + 10 + 2 * (size_t)c);
+        size_t points = contours ? (size_t)endPts.back() + 1 : 0;
+        size_t at = g + 10 + 2 * (size_t)contours;
+        at += 2 + r.u16(at); // instructions
+        std::vector<uint8_t> flags;
+        flags.reserve(points);
+        while (flags.size() < points && r.ok) {
+            uint8_t f = r.u8(at++);
+            flags.push_back(f);
+            if (f & 8) { // repeat
+                uint8_t n = r.u8(at++);
+                for (uint8_t k = 0; k < n && flags.size() < points; ++k) flags.push_back(f);
+            }
+        }
+        std::vector<glm::vec2> pos(points);
+        int value = 0;
+        for (size_t i = 0; i < points; ++i) {
+            uint8_t f = flags[i];
+            if (f & 2) { int dx = r.u8(at++); value += (f & 16) ? dx : -dx; }
+            else if (!(f & 16)) { value += r.s16(at); at += 2; }
+            pos[i].x = (float)value;
+        }
+        value = 0;
+        for (size_t i = 0; i < points; ++i) {
+            uint8_t f = flags[i];
+            if (f & 4) { int dy = r.u8(at++); value += (f & 32) ? dy : -dy; }
+            else if (!(f & 32)) { value += r.s16(at); at += 2; }
+            pos[i].y = (float)value;
+        }
+        if (!r.ok) return false;
+        size_t first = 0;
+        for (int16_t c = 0; c < contours; ++c) {
+            Contour contour;
+            for (size_t i = first; i <= endPts[c] && i < points; ++i) {
+                OutlinePoint p;
+                p.p = xf.apply(pos[i]);
+                p.onCurve = (flags[i] & 1) != 0;
+                contour.push_back(p);
+            }
+            first = (size_t)endPts[c] + 1;
+            if (contour.size() > 1) out.push_back(contour);
+        }
+        return true;
+    }
+
+    // composite: transformed copies of other glyphs
+    size_t at = g + 10;
+    for (;;) {
+        uint16_t f = r.u16(at);
+        uint16_t component = r.u16(at + 2);
+        at += 4;
+        GlyphTransform local;
+        if (f & 1) { // ARG_1_AND_2_ARE_WORDS
+            local.dx = (float)r.s16(at);
+            local.dy = (float)r.s16(at + 2);
+            at += 4;
+        } else {
+            local.dx = (float)(int8_t)r.u8(at);
+            local.dy = (float)(int8_t)r.u8(at + 1);
+            at += 2;
+        }
+        if (!(f & 2)) local.dx = local.dy = 0.0f; // point matching instead of offsets: not supported
+        const float F2DOT14 = 1.0f / 16384.0f;
+        if (f & 8) { // WE_HAVE_A_SCALE
+            local.a = local.d = r.s16(at) * F2DOT14;
+            at += 2;
+        } else if (f & 0x40) { // X_AND_Y_SCALE
+            local.a = r.s16(at) * F2DOT14;
+            local.d = r.s16(at + 2) * F2DOT14;
+            at += 4;
+        } else if (f & 0x80) { // TWO_BY_TWO
+            local.a = r.s16(at) * F2DOT14;
+            local.b = r.s16(at + 2) * F2DOT14;
+            local.c = r.s16(at + 4) * F2DOT14;
+            local.d = r.s16(at + 6) * F2DOT14;
+            at += 8;
+        }
+        if (!r.ok || !outline(component, local.then(xf), out, depth + 1)) return false;
+        if (!(f & 0x20)) break; // MORE_COMPONENTS
+    }
+    return true;
+}
+
+void TrueTypeFont::kerningPairs(std::vector<uint16_t>& left, std::vector<uint16_t>& right, std::vector<int16_t>& value) {
+    if (!kern || r.u16(kern) != 0) return; // only the Microsoft-style version 0 table
+    uint16_t subtables = r.u16(kern + 2);
+    size_t at = kern + 4;
+    for (uint16_t s = 0; s < subtables && at < kern + kernLength; ++s) {
+        uint16_t length = r.u16(at + 2), coverage = r.u16(at + 4);
+        bool horizontal = (coverage & 1) != 0, minimum = (coverage & 2) != 0, crossStream = (coverage & 4) != 0;
+        if ((coverage >> 8) == 0 && horizontal && !minimum && !crossStream) {
+            uint16_t pairs = r.u16(at + 6);
+            for (uint16_t p = 0; p < pairs; ++p) {
+                size_t rec = at + 14 + 6 * (size_t)p;
+                left.push_back(r.u16(rec));
+                right.push_back(r.u16(rec + 2));
+                value.push_back(r.s16(rec + 4));
+            }
+        }
+        if (!r.ok || length == 0) break;
+        at += length;
+    }
+}
+
+// ---- distance field ----
+
+struct Edge {
+    glm::vec2 a, b;
+};
+
+// Outline contours (texel space) to line segments; quadratic arcs are split so no chord
+// strays more than about a tenth of a texel from the curve.
+void flatten(const std::vector<Contour>& contours, std::vector<Edge>& edges) {
+    for (const Contour& in : contours) {
+        // make the implied on-curve points between two off-curve ones explicit
+        Contour c;
+        for (size_t i = 0; i < in.size(); ++i) {
+            const OutlinePoint& cur = in[i];
+            const OutlinePoint& next = in[(i + 1) % in.size()];
+            c.push_back(cur);
+            if (!cur.onCurve && !next.onCurve) {
+                OutlinePoint mid;
+                mid.p = 0.5f * (cur.p + next.p);
+                mid.onCurve = true;
+                c.push_back(mid);
+            }
+        }
+        size_t start = 0;
+        while (start < c.size() && !c[start].onCurve) ++start;
+        if (start == c.size()) continue;
+        const size_t n = c.size();
+        glm::vec2 pen = c[start].p;
+        for (size_t k = 1; k <= n; ++k) {
+            const OutlinePoint& p = c[(start + k) % n];
+            if (p.onCurve) {
+                edges.push_back(Edge{ pen, p.p });
+                pen = p.p;
+                continue;
+            }
+            const glm::vec2 control = p.p;
+            const glm::vec2 to = c[(start + k + 1) % n].p;
+            ++k;
+            float deviation = glm::length(pen - 2.0f * control + to); // 4x the max distance from the chord
+            int steps = std::max(1, std::min(32, (int)std::ceil(std::sqrt(deviation * 2.5f))));
+            glm::vec2 prev = pen;
+            for (int s = 1; s <= steps; ++s) {
+                float t = (float)s / (float)steps;
+                glm::vec2 q = (1.0f - t) * (1.0f - t) * pen + 2.0f * (1.0f - t) * t * control + t * t * to;
+                edges.push_back(Edge{ prev, q });
+                prev = q;
+            }
+            pen = to;
+        }
+    }
+}
+
+float segmentDistance(const glm::vec2& p, const Edge& e) {
+    glm::vec2 ab = e.b - e.a;
+    float len2 = glm::dot(ab, ab);
+    float t = len2 > 0.0f ? glm::clamp(glm::dot(p - e.a, ab) / len2, 0.0f, 1.0f) : 0.0f;
+    return glm::length(p - (e.a + t * ab));
+}
+
+// non-zero winding number of the outline around p
+int winding(const glm::vec2& p, const std::vector<Edge>& edges) {
+    int w = 0;
+    for (const Edge& e : edges) {
+        float side = (e.b.x - e.a.x) * (p.y - e.a.y) - (p.x - e.a.x) * (e.b.y - e.a.y);
+        if (e.a.y <= p.y) {
+            if (e.b.y > p.y && side > 0.0f) ++w;
+        } else {
+            if (e.b.y <= p.y && side < 0.0f) --w;
+        }
+    }
+    return w;
+}
+
+struct GlyphBitmap {
+    int x0 = 0, y0 = 0, width = 0, height = 0; // texel rectangle relative to the pen
+    std::vector<uint8_t> texels;
+};
+
+void renderDistance(const std::vector<Edge>& edges, float spread, GlyphBitmap& out) {
+    out.texels.assign((size_t)out.width * (size_t)out.height, 0);
+    for (int y = 0; y < out.height; ++y) {
+        for (int x = 0; x < out.width; ++x) {
+            glm::vec2 p((float)(out.x0 + x) + 0.5f, (float)(out.y0 + y) + 0.5f);
+            float d = 1e30f;
+            for (const Edge& e : edges) d = std::min(d, segmentDistance(p, e));
+            if (winding(p, edges) == 0) d = -d;
+            float v = glm::clamp(0.5f + d / (2.0f * spread), 0.0f, 1.0f);
+            out.texels[(size_t)y * (size_t)out.width + (size_t)x] = (uint8_t)std::lround(v * 255.0f);
+        }
+    }
+}
+
+} // namespace
+bool buildSdfFont(const std::vector<uint8_t>& ttf, const SdfFontConfig& config, SdfFont& out, std::string& error) {
+    TrueTypeFont font(ttf);
+    if (!font.open(error)) return false;
+    out = SdfFont();
+    out.emPixels = std::max(config.emPixels, 4.0f);
+    out.spread = std::max(config.spread, 1.0f);
+    const float emUnits = (float)font.unitsPerEm;
+    const float scale = out.emPixels / emUnits; // font units -> texels
+    out.ascender = font.ascender / emUnits;
+    out.descender = font.descender / emUnits;
+    out.lineGap = font.lineGap / emUnits;
+
+    // outlines -> distance bitmaps
+    std::vector<GlyphBitmap> bitmaps;
+    std::map<uint32_t, std::vector<uint32_t>> codepointsOfGlyph;
+    GlyphTransform toTexels;
+    toTexels.a = toTexels.d = scale;
+    for (uint32_t cp = config.firstCodepoint; cp <= config.lastCodepoint; ++cp) {
+        uint32_t g = font.glyphIndex(cp);
+        if (!g && cp != config.firstCodepoint) continue; // not in the font (index 0 = .notdef)
+        std::vector<Contour> contours;
+        if (!font.outline(g, toTexels, contours)) {
+            error = "corrupt outline for codepoint " + std::to_string(cp);
+            return false;
+        }
+        std::vector<Edge> edges;
+        flatten(contours, edges);
+
+        SdfGlyph glyph;
+        glyph.codepoint = cp;
+        glyph.advance = font.advance(g) / emUnits;
+        GlyphBitmap bitmap;
+        if (!edges.empty()) {
+            glm::vec2 mn(1e30f), mx(-1e30f);
+            for (const Edge& e : edges) {
+                mn = glm::min(mn, glm::min(e.a, e.b));
+                mx = glm::max(mx, glm::max(e.a, e.b));
+            }
+            bitmap.x0 = (int)std::floor(mn.x - out.spread);
+            bitmap.y0 = (int)std::floor(mn.y - out.spread);
+            bitmap.width = (int)std::ceil(mx.x + out.spread) - bitmap.x0;
+            bitmap.height = (int)std::ceil(mx.y + out.spread) - bitmap.y0;
+            renderDistance(edges, out.spread, bitmap);
+            glyph.planeLeft = bitmap.x0 / out.emPixels;
+            glyph.planeBottom = bitmap.y0 / out.emPixels;
+            glyph.planeRight = (bitmap.x0 + bitmap.width) / out.emPixels;
+            glyph.planeTop = (bitmap.y0 + bitmap.height) / out.emPixels;
+        }
+        out.glyphs.push_back(glyph);
+        bitmaps.push_back(bitmap);
+        codepointsOfGlyph[g].push_back(cp);
+    }
+    if (out.glyphs.empty()) {
+        error = "none of the requested codepoints are in the font";
+        return false;
+    }
+
+    // shelf packing, tallest first
+    const int pad = std::max(0, config.padding);
+    out.atlasWidth = std::max(64, config.atlasWidth);
+    std::vector<size_t> order(bitmaps.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return bitmaps[a].height > bitmaps[b].height; });
+    int penX = pad, penY = pad, shelf = 0;
+    for (size_t i : order) {
+        const GlyphBitmap& b = bitmaps[i];
+        if (!b.width) continue;
+        if (b.width + 2 * pad > out.atlasWidth) {
+            error = "glyphs wider than the atlas; lower the em size or widen the atlas";
+            return false;
+        }
+        if (penX + b.width + pad > out.atlasWidth) {
+            penX = pad;
+            penY += shelf + pad;
+            shelf = 0;
+        }
+        out.glyphs[i].atlasX = (uint16_t)penX;
+        out.glyphs[i].atlasY = (uint16_t)penY;
+        out.glyphs[i].atlasWidth = (uint16_t)b.width;
+        out.glyphs[i].atlasHeight = (uint16_t)b.height;
+        penX += b.width + pad;
+        shelf = std::max(shelf, b.height);
+    }
+    int used = penY + shelf + pad;
+    out.atlasHeight = 64;
+    while (out.atlasHeight < used) out.atlasHeight *= 2;
+    out.atlas.assign((size_t)out.atlasWidth * (size_t)out.atlasHeight, 0);
+    for (size_t i = 0; i < bitmaps.size(); ++i) {
+        const GlyphBitmap& b = bitmaps[i];
+        const SdfGlyph& g = out.glyphs[i];
+        for (int y = 0; y < b.height; ++y) {
+            std::memcpy(&out.atlas[(size_t)(g.atlasY + y) * (size_t)out.atlasWidth + g.atlasX],
+                        &b.texels[(size_t)y * (size_t)b.width], (size_t)b.width);
+        }
+    }
+
+    // kerning between the codepoints we kept
+    std::vector<uint16_t> left, right;
+    std::vector<int16_t> value;
+    font.kerningPairs(left, right, value);
+    std::vector<std::pair<uint64_t, float>> pairs;
+    for (size_t i = 0; i < left.size(); ++i) {
+        std::map<uint32_t, std::vector<uint32_t>>::const_iterator l = codepointsOfGlyph.find(left[i]);
+        std::map<uint32_t, std::vector<uint32_t>>::const_iterator r = codepointsOfGlyph.find(right[i]);
+        if (l == codepointsOfGlyph.end() || r == codepointsOfGlyph.end() || value[i] == 0) continue;
+        for (uint32_t a : l->second) {
+            for (uint32_t b : r->second) pairs.push_back(std::make_pair((uint64_t)a << 32 | b, value[i] / emUnits));
+        }
+    }
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end(),
+                            [](const std::pair<uint64_t, float>& a, const std::pair<uint64_t, float>& b) { return a.first == b.first; }),
+                pairs.end());
+    for (const std::pair<uint64_t, float>& p : pairs) {
+        out.kerningPairs.push_back(p.first);
+        out.kerning.push_back(p.second);
+    }
+    return true;
+}
@@ -0,0 +1,26 @@
+#ifndef SDFFONTBUILD_HPP
+#define SDFFONTBUILD_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/sdffont.hpp"
+
+struct SdfFontConfig {
+    float emPixels = 48.0f;        // atlas texels per em (glyph detail)
+    float spread = 6.0f;           // texels of distance stored on each side of an edge
+    uint32_t firstCodepoint = 32;  // printable ASCII by default
+    uint32_t lastCodepoint = 126;
+    int atlasWidth = 512;          // the height grows (power of two) until everything fits
+    int padding = 1;               // texels between glyph rectangles
+};
+
+// Builds an SdfFont from a TrueType (.ttf, glyf outlines) file's bytes: cmap format 4
+// for the codepoints, hmtx for advances, the legacy 'kern' table (format 0) for kerning
+// (GPOS kerning is not read). Outlines, simple or composite, are flattened into line
+// segments; each texel gets its distance to the nearest segment, signed by the non-zero
+// winding rule, and the glyphs are shelf-packed into the atlas.
+bool buildSdfFont(const std::vector<uint8_t>& ttf, const SdfFontConfig& config, SdfFont& out, std::string& error);
+
+#endif